@@ -44,15 +44,104 @@
 volatile unsigned long seconds;
 
 static volatile clock_time_t count = 0;
-/* last_tar is used for calculating clock_fine */
+/* last_tar is used for calculating clock_fine. In tickless mode, it is
+ * the TAR value at which count was last brought up to date. */
 static volatile uint16_t last_tar = 0;
 /*---------------------------------------------------------------------------*/
+#if CLOCK_CONF_TICKLESS
+/* Tickless mode: TACCR1 is programmed for the next etimer expiration
+ * instead of every tick, and count is derived from TAR when needed.
+ * rtimer-arch.c extends TAR to 32 bits with 'seconds', which must follow
+ * TAR wraps closely, so we still interrupt at every second boundary. */
+static uint16_t
+read_tar(void)
+{
+  uint16_t t1, t2;
+  do {
+    t1 = TAR;
+    t2 = TAR;
+  } while(t1 != t2);
+  return t1;
+}
+/*---------------------------------------------------------------------------*/
+/* Bring count and seconds up to date. Call with interrupts disabled. */
+static void
+update_count(void)
+{
+  clock_time_t elapsed = (uint16_t)(read_tar() - last_tar) / INTERVAL;
+
+  if(elapsed > 0) {
+    if((count % CLOCK_CONF_SECOND) + elapsed >= CLOCK_CONF_SECOND) {
+      ++seconds;
+      energest_flush();
+    }
+    count += elapsed;
+    last_tar += elapsed * INTERVAL;
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* Program TACCR1 for the next etimer expiration, or the next second
+ * boundary if it comes first. Call with interrupts disabled, right after
+ * update_count(). */
+static void
+schedule_next(void)
+{
+  clock_time_t ticks;
+  clock_time_t dist;
+
+  ticks = CLOCK_CONF_SECOND - (count % CLOCK_CONF_SECOND);
+  if(etimer_pending()) {
+    dist = etimer_next_expiration_time() - count;
+    /* Expired timers are handled by the etimer process, which then
+     * calls clock_next_expiration_changed() */
+    if(dist > 0 && dist <= MAX_TICKS && dist < ticks) {
+      ticks = dist;
+    }
+  }
+
+  TACCR1 = last_tar + ticks * INTERVAL;
+  /* Don't program a compare we might miss, it would only fire after
+   * a full TAR wrap */
+  if((uint16_t)(TACCR1 - read_tar()) < 2) {
+    TACCR1 += INTERVAL;
+  }
+}
+/*---------------------------------------------------------------------------*/
+void
+clock_next_expiration_changed(void)
+{
+  int s;
+  s = splhigh();
+  update_count();
+  schedule_next();
+  splx(s);
+}
+#endif /* CLOCK_CONF_TICKLESS */
+/*---------------------------------------------------------------------------*/
 ISR(TIMERA1, timera1)
 {
   ENERGEST_ON(ENERGEST_TYPE_IRQ);
 
   watchdog_start();
 
+#if CLOCK_CONF_TICKLESS
+  if(TAIV == 2) {
+
+    /* HW timer bug fix: Interrupt handler called before TR==CCR.
+     * Occurs when timer state is toggled between STOP and CONT. */
+    while(TACTL & MC1 && TACCR1 - TAR == 1);
+
+    update_count();
+
+    if(etimer_pending() &&
+       (etimer_next_expiration_time() - count - 1) > MAX_TICKS) {
+      etimer_request_poll();
+      LPM4_EXIT;
+    }
+
+    schedule_next();
+  }
+#else /* CLOCK_CONF_TICKLESS */
   if(TAIV == 2) {
 
     /* HW timer bug fix: Interrupt handler called before TR==CCR.
@@ -87,6 +176,7 @@ ISR(TIMERA1, timera1)
     }
 
   }
+#endif /* CLOCK_CONF_TICKLESS */
   /*  if(process_nevents() >= 0) {
     LPM4_EXIT;
     }*/
@@ -99,12 +189,22 @@ ISR(TIMERA1, timera1)
 clock_time_t
 clock_time(void)
 {
+#if CLOCK_CONF_TICKLESS
+  clock_time_t t;
+  int s;
+  s = splhigh();
+  update_count();
+  t = count;
+  splx(s);
+  return t;
+#else /* CLOCK_CONF_TICKLESS */
   clock_time_t t1, t2;
   do {
     t1 = count;
     t2 = count;
   } while(t1 != t2);
   return t1;
+#endif /* CLOCK_CONF_TICKLESS */
 }
 /*---------------------------------------------------------------------------*/
 void
@@ -113,6 +213,9 @@ clock_set(clock_time_t clock, clock_time_t fclock)
   TAR = fclock;
   TACCR1 = fclock + INTERVAL;
   count = clock;
+#if CLOCK_CONF_TICKLESS
+  last_tar = fclock;
+#endif /* CLOCK_CONF_TICKLESS */
 }
 /*---------------------------------------------------------------------------*/
 int
@@ -128,7 +231,11 @@ clock_fine(void)
   /* Assign last_tar to local varible that can not be changed by interrupt */
   t = last_tar;
   /* perform calc based on t, TAR will not be changed during interrupt */
+#if CLOCK_CONF_TICKLESS
+  return (unsigned short) (TAR - t) % INTERVAL;
+#else /* CLOCK_CONF_TICKLESS */
   return (unsigned short) (TAR - t);
+#endif /* CLOCK_CONF_TICKLESS */
 }
 /*---------------------------------------------------------------------------*/
 void
@@ -164,6 +271,7 @@ clock_init(void)
   TACTL |= MC1;
 
   count = 0;
+  last_tar = 0;
 
   /* Enable interrupts. */
   eint();
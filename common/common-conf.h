@@ -90,6 +90,10 @@ typedef uint32_t rtimer_clock_t;
 
 #define CONTIKIMAC_CONF_CYCLE_TIME (CMD_CYCLE_TIME * RTIMER_ARCH_SECOND / 1000)
 
+/* Program the clock interrupt for the next etimer instead of every tick
+ * (common/clock.c), so that idle nodes wake up the MCU less often */
+#define CLOCK_CONF_TICKLESS 1
+
 
 #undef CSMA_CONF_MAX_NEIGHBOR_QUEUES
 #define CSMA_CONF_MAX_NEIGHBOR_QUEUES 4
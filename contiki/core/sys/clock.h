@@ -131,6 +131,14 @@ void clock_wait(clock_time_t t);
  */
 void clock_delay_usec(uint16_t dt);
 
+/**
+ * Notify a tickless clock that the next etimer expiration has changed,
+ * so that it can reprogram its next interrupt. Called by the etimer
+ * library when CLOCK_CONF_TICKLESS is set. Ctimers are built on
+ * etimers and need no separate notification.
+ */
+void clock_next_expiration_changed(void);
+
 /**
  * Deprecated platform-specific routines.
  *
@@ -75,6 +75,10 @@ update_time(void)
     }
     next_expiration = now + tdist;
   }
+#if CLOCK_CONF_TICKLESS
+  /* A tickless clock only interrupts at the next expiration */
+  clock_next_expiration_changed();
+#endif /* CLOCK_CONF_TICKLESS */
 }
 /*---------------------------------------------------------------------------*/
 PROCESS_THREAD(etimer_process, ev, data)
@@ -108,6 +108,7 @@ public class CollectServer implements SerialConnectionListener {
   private static final String NETWORK = "Network";
   private static final String SENSORS = "Sensors";
   private static final String POWER = "Power";
+  private static final String ORPL = "ORPL";
 
   private Properties config = new Properties();
 
@@ -597,6 +598,100 @@ public class CollectServer implements SerialConnectionListener {
             return data.getAveragePower();
           }
         },
+        new BarChartPanel(this, ORPL, "EDC (Per Node)", "EDC", "Nodes", "EDC",
+            new String[] { "Last EDC", "Average EDC" }, false) {
+          protected void addSensorData(SensorData data) {
+            if (!data.isORPL()) return;
+            String nodeName = data.getNode().getName();
+            dataset.addValue(data.getORPLEDC(), categories[0], nodeName);
+            dataset.addValue(data.getNode().getSensorDataAggregator().getAverageValue(SensorData.RTMETRIC)
+                / SensorData.ORPL_EDC_DIVISOR, categories[1], nodeName);
+          }
+        },
+        new TimeChartPanel(this, ORPL, "EDC (Over Time)", "EDC", "Time", "EDC") {
+          {
+            ValueAxis axis = chart.getXYPlot().getRangeAxis();
+            ((NumberAxis)axis).setAutoRangeIncludesZero(true);
+          }
+          protected double getSensorDataValue(SensorData data) {
+            return data.getORPLEDC();
+          }
+        },
+        new BarChartPanel(this, ORPL, "Duty Cycle (Per Node)", "Radio Duty Cycle",
+            "Nodes", "Duty Cycle (%)", new String[] { "Last Report", "Average" }, false) {
+          {
+            ValueAxis axis = chart.getCategoryPlot().getRangeAxis();
+            ((NumberAxis)axis).setAutoRangeIncludesZero(true);
+          }
+          protected void addSensorData(SensorData data) {
+            if (!data.isORPL()) return;
+            String nodeName = data.getNode().getName();
+            dataset.addValue(data.getORPLDutyCycle(), categories[0], nodeName);
+            dataset.addValue(data.getNode().getSensorDataAggregator().getAverageValue(SensorData.ORPL_DUTY_CYCLE)
+                / 100.0, categories[1], nodeName);
+          }
+        },
+        new TimeChartPanel(this, ORPL, "Duty Cycle (Over Time)", "Radio Duty Cycle", "Time", "Duty Cycle (%)") {
+          {
+            ValueAxis axis = chart.getXYPlot().getRangeAxis();
+            ((NumberAxis)axis).setAutoRangeIncludesZero(true);
+          }
+          protected double getSensorDataValue(SensorData data) {
+            return data.getORPLDutyCycle();
+          }
+        },
+        new TimeChartPanel(this, ORPL, "Wake-up Interval", "Wake-up Interval", "Time", "Interval (ms)") {
+          {
+            ValueAxis axis = chart.getXYPlot().getRangeAxis();
+            ((NumberAxis)axis).setAutoRangeIncludesZero(true);
+            axis.setStandardTickUnits(NumberAxis.createIntegerTickUnits());
+          }
+          protected double getSensorDataValue(SensorData data) {
+            return data.getValue(SensorData.ORPL_WAKEUP_INTERVAL);
+          }
+        },
+        new BarChartPanel(this, ORPL, "Forwarders (Per Node)", "Forwarder and Neighbor Sets",
+            "Nodes", "Nodes", new String[] { "Forwarders", "Neighbors" }, false) {
+          {
+            chart.getCategoryPlot().getRangeAxis().setStandardTickUnits(NumberAxis.createIntegerTickUnits());
+          }
+          protected void addSensorData(SensorData data) {
+            if (!data.isORPL()) return;
+            String nodeName = data.getNode().getName();
+            dataset.addValue(data.getValue(SensorData.ORPL_FORWARDERS), categories[0], nodeName);
+            dataset.addValue(data.getValue(SensorData.NUM_NEIGHBORS), categories[1], nodeName);
+          }
+        },
+        new BarChartPanel(this, ORPL, "Routing Set (Per Node)", "Routing Set Fill",
+            "Nodes", "Bits Set (%)", new String[] { "Routing Set" }) {
+          protected void addSensorData(SensorData data) {
+            if (!data.isORPL()) return;
+            dataset.addValue(data.getORPLRoutingSetFill(), categories[0], data.getNode().getName());
+          }
+        },
+        new BarChartPanel(this, ORPL, "Queue (Per Node)", "Queued Packets",
+            "Nodes", "Packets", new String[] { "Last Report", "Average" }, false) {
+          {
+            chart.getCategoryPlot().getRangeAxis().setStandardTickUnits(NumberAxis.createIntegerTickUnits());
+          }
+          protected void addSensorData(SensorData data) {
+            if (!data.isORPL()) return;
+            String nodeName = data.getNode().getName();
+            dataset.addValue(data.getValue(SensorData.ORPL_QUEUE_LENGTH), categories[0], nodeName);
+            dataset.addValue(data.getNode().getSensorDataAggregator().getAverageValue(SensorData.ORPL_QUEUE_LENGTH),
+                categories[1], nodeName);
+          }
+        },
+        new BarChartPanel(this, ORPL, "FP Recoveries (Per Node)", "False Positive Recoveries",
+            "Nodes", "Recoveries", new String[] { "Recoveries" }) {
+          {
+            chart.getCategoryPlot().getRangeAxis().setStandardTickUnits(NumberAxis.createIntegerTickUnits());
+          }
+          protected void addSensorData(SensorData data) {
+            if (!data.isORPL()) return;
+            dataset.addValue(data.getValue(SensorData.ORPL_FP_RECOVERIES), categories[0], data.getNode().getName());
+          }
+        },
         new NodeInfoPanel(this, MAIN),
         serialConsole
     };
@@ -149,7 +149,9 @@ public class SensorData implements SensorInfo {
       System.err.println("Failed to parse data line: '" + line + "'");
       return null;
     }
-    String nodeID = mapNodeID(data[NODE_ID]);
+    // ORPL nodes are identified by their deployment node id
+    String nodeID = data[ORPL_MAGIC] == ORPL_MAGIC_VALUE
+      ? Integer.toString(data[NODE_ID]) : mapNodeID(data[NODE_ID]);
     Node node = server.addNode(nodeID);
     return new SensorData(node, data, systemTime);
   }
@@ -240,4 +242,21 @@ public class SensorData implements SensorInfo {
     return values[BEST_NEIGHBOR_ETX] / 8.0;
   }
 
+  public boolean isORPL() {
+    return values[ORPL_MAGIC] == ORPL_MAGIC_VALUE;
+  }
+
+  public double getORPLEDC() {
+    return values[RTMETRIC] / ORPL_EDC_DIVISOR;
+  }
+
+  public double getORPLDutyCycle() {
+    return values[ORPL_DUTY_CYCLE] / 100.0;
+  }
+
+  public double getORPLRoutingSetFill() {
+    return values[ORPL_ROUTING_SET_SIZE] > 0
+      ? (100.0 * values[ORPL_ROUTING_SET_BITS]) / values[ORPL_ROUTING_SET_SIZE] : 0;
+  }
+
 }
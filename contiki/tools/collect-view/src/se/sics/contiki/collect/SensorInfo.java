@@ -80,6 +80,21 @@ public interface SensorInfo {
   public static final int HUMIDITY = 25;
   public static final int RSSI = 26;
 
+  /* ORPL telemetry reports (orpl-telemetry.c) carry these in place of the sensors */
+  public static final int ORPL_MAGIC = 20;
+  public static final int ORPL_FORWARDERS = 21;
+  public static final int ORPL_ROUTING_SET_BITS = 22;
+  public static final int ORPL_QUEUE_LENGTH = 23;
+  public static final int ORPL_DUTY_CYCLE = 24;
+  public static final int ORPL_WAKEUP_INTERVAL = 25;
+  public static final int ORPL_FP_RECOVERIES = 26;
+  public static final int ORPL_SINK = 27;
+  public static final int ORPL_VERSION = 28;
+  public static final int ORPL_ROUTING_SET_SIZE = 29;
+
+  public static final int ORPL_MAGIC_VALUE = 0x0e4c;
+  public static final double ORPL_EDC_DIVISOR = 128.0;
+
   public static final int VALUES_COUNT = 30;
 
 }
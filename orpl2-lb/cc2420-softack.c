@@ -56,6 +56,7 @@
 #include "lib/memb.h"
 
 #include "sys/timetable.h"
+#include "orpl-softack-prof.h"
 
 #if WITH_ORPL
 
@@ -629,6 +630,8 @@ struct received_frame_s {
   uint8_t len;
   uint8_t acked;
   uint8_t seqno;
+  int8_t rssi;
+  uint8_t correlation;
 };
 MEMB(rf_memb, struct received_frame_s, 4);
 LIST(rf_list);
@@ -641,6 +644,11 @@ LIST(rf_list);
 static softack_input_callback_f *softack_input_callback;
 static softack_acked_callback_f *softack_acked_callback;
 
+/* Delay before sending the ACK of the current frame, in rtimer ticks */
+rtimer_clock_t cc2420_softack_ack_delay;
+/* Number of ACKs cancelled so far */
+volatile uint16_t cc2420_softack_cancelled_count;
+
 /* Subscribe with two callbacks called from FIFOP interrupt */
 void
 cc2420_softack_subscribe(softack_input_callback_f *input_callback, softack_acked_callback_f *acked_callback)
@@ -661,6 +669,7 @@ cc2420_interrupt(void)
   struct received_frame_s *rf;
 
   process_poll(&cc2420_process);
+  ORPL_SOFTACK_PROF_START(cc2420_sfd_start_time);
 
 #if CC2420_TIMETABLE_PROFILING
   timetable_clear(&cc2420_timetable);
@@ -716,13 +725,16 @@ cc2420_interrupt(void)
   rf->len = len;
   rf->acked = 0;
   CC2420_READ_RAM(rf->buf, RXFIFO_ADDR(1), len_a);
+  ORPL_SOFTACK_PROF_STAMP(ORPL_SOFTACK_PROF_HEADER);
 
   seqno = rf->buf[2];
   rf->seqno = seqno;
 
+  cc2420_softack_ack_delay = 0;
   if(softack_input_callback) {
     softack_input_callback(rf->buf, len_a, &ackbuf, &acklen);
   }
+  ORPL_SOFTACK_PROF_STAMP(ORPL_SOFTACK_PROF_DECISION);
   do_ack = acklen > 0;
 
   if(do_ack) {
@@ -731,6 +743,14 @@ cc2420_interrupt(void)
 	  CC2420_STROBE(CC2420_SFLUSHTX);
 	  CC2420_WRITE_FIFO_BUF(&total_acklen, 1);
 	  CC2420_WRITE_FIFO_BUF(ackbuf, acklen);
+#if WITH_ORPL_SOFTACK_PROF
+	  ORPL_SOFTACK_PROF_STAMP(ORPL_SOFTACK_PROF_ACK_READY);
+	  orpl_softack_prof_acks++;
+	  /* The frame is already over: the sender may have given up waiting */
+	  if(!CC2420_SFD_IS_1) {
+	    orpl_softack_prof_late++;
+	  }
+#endif /* WITH_ORPL_SOFTACK_PROF */
   }
 
   /* Wait for end of reception */
@@ -742,11 +762,26 @@ cc2420_interrupt(void)
   CC2420_READ_RAM_BYTE(footer1, RXFIFO_ADDR(len + AUX_LEN));
 
   if(!overflow && (footer1 & FOOTER1_CRC_OK)) { /* CRC is correct */
+    if(do_ack && cc2420_softack_ack_delay > 0) {
+      /* Wait for our ACK slot. Give up if another node acks first. */
+      rtimer_clock_t t0 = RTIMER_NOW();
+      while(RTIMER_CLOCK_LT(RTIMER_NOW(), t0 + cc2420_softack_ack_delay)) {
+        if(CC2420_SFD_IS_1) {
+          CC2420_STROBE(CC2420_SFLUSHTX); /* Flush Tx fifo */
+          cc2420_softack_cancelled_count++;
+          do_ack = 0;
+          break;
+        }
+      }
+    }
     if(do_ack) {
       strobe(CC2420_STXON); /* Send ACK */
       rf->acked = 1;
     }
     frame_valid = 1;
+    /* Read the RSSI only now, not to delay the ACK */
+    CC2420_READ_RAM_BYTE(rf->rssi, RXFIFO_ADDR(len + AUX_LEN - 1));
+    rf->correlation = footer1 & FOOTER1_CORRELATION;
   } else { /* CRC is wrong */
     if(do_ack) {
       CC2420_STROBE(CC2420_SFLUSHTX); /* Flush Tx fifo */
@@ -797,6 +832,9 @@ PROCESS_THREAD(cc2420_process, ev, data)
 
   while(1) {
     PROCESS_YIELD_UNTIL(ev == PROCESS_EVENT_POLL);
+#if WITH_ORPL_SOFTACK_PROF
+    orpl_softack_prof_update();
+#endif /* WITH_ORPL_SOFTACK_PROF */
 #if CC2420_TIMETABLE_PROFILING
     TIMETABLE_TIMESTAMP(cc2420_timetable, "poll");
 #endif /* CC2420_TIMETABLE_PROFILING */
@@ -829,6 +867,8 @@ PROCESS_THREAD(cc2420_process, ev, data)
     }
     packetbuf_set_datalen(len);
     packetbuf_set_attr(PACKETBUF_ATTR_ACKED, current_is_acked);
+    packetbuf_set_attr(PACKETBUF_ATTR_RSSI, cc2420_last_rssi);
+    packetbuf_set_attr(PACKETBUF_ATTR_LINK_QUALITY, cc2420_last_correlation);
 
     NETSTACK_RDC.input();
 
@@ -864,6 +904,8 @@ cc2420_read(void *buf, unsigned short bufsize)
     }
     memcpy(buf, rf->buf, len);
     current_is_acked = rf->acked;
+    cc2420_last_rssi = rf->rssi;
+    cc2420_last_correlation = rf->correlation;
     memb_free(&rf_memb, rf);
     RELEASE_LOCK();
     return len;
@@ -41,10 +41,18 @@
 #define __CC2420_SOFTACK_H__
 
 #include "dev/cc2420.h"
+#include "sys/rtimer.h"
 
 typedef void(softack_input_callback_f)(const uint8_t *frame, uint8_t framelen, uint8_t **ackbufptr, uint8_t *acklen);
 typedef void(softack_acked_callback_f)(const uint8_t *frame, uint8_t framelen);
 
+/* Delay before sending the ACK of the current frame, in rtimer ticks.
+ * Can be set by the input callback, and is reset for every frame.
+ * If another frame is heard during the delay, the ACK is cancelled. */
+extern rtimer_clock_t cc2420_softack_ack_delay;
+/* Number of ACKs cancelled so far */
+extern volatile uint16_t cc2420_softack_cancelled_count;
+
 /* Subscribe with two callbacks called from FIFOP interrupt */
 void cc2420_softack_subscribe(softack_input_callback_f *input_callback, softack_acked_callback_f *acked_callback);
 
@@ -52,6 +52,14 @@
 #include "sys/rtimer.h"
 #include "orpl.h"
 #include "orpl-anycast.h"
+#include "orpl-radio-stats.h"
+#include "orpl-fast-forward.h"
+#if WITH_ORPL_ENERGY
+#include "orpl-energy.h"
+#endif /* WITH_ORPL_ENERGY */
+#if WITH_ORPL_LB_CTRL
+#include "orpl-dc-ctrl.h"
+#endif /* WITH_ORPL_LB_CTRL */
 
 #include <string.h>
 
@@ -80,16 +88,16 @@
 
  //period between two checks (used with ctimer) based on the sending rate
 #define LB_GUARD_PERIOD 60*60*CLOCK_SECOND //guard timer before starting load balancing
-#define DUTY_CYCLE_TARGET   3.50 //(1.75 for 30s)
+#define DUTY_CYCLE_TARGET   350 //in 1/100th of percent, i.e. 3.50% (1.75 for 30s)
 
 #if NEW_MODE
-#define DC_ALPHA 0.25 //has to be bigger given check is now for ten min
+#define DC_ALPHA 25 //in percent, has to be bigger given check is now for ten min
 #define LB_CHECK_PERIOD 2*60*CLOCK_SECOND
 #define CYCLE_MAX  (1000 * RTIMER_ARCH_SECOND/1000) // wake-up interval sup bound
 #define CYCLE_MIN (125 * RTIMER_ARCH_SECOND/1000) // wake-up interval min bound
 #define CYCLE_STEP_MAX (CYCLE_MIN)//we don't want to move too fast (related to transmission rate (4m = /2 --- 2m = /4)
 #else
-#define DC_ALPHA 0.25
+#define DC_ALPHA 25 //in percent
 #define LB_CHECK_PERIOD 2*60*CLOCK_SECOND
 #define CYCLE_MAX  (1000 * RTIMER_ARCH_SECOND/1000) // wake-up interval sup bound
 #define CYCLE_MIN (125 * RTIMER_ARCH_SECOND/1000) // wake-up interval min bound
@@ -125,11 +133,12 @@ int last_move, curr_move, since_LB_enabled;//0 =500, 1 >500, 2 <500
 uint16_t periodic_dc, objective_dc, weighted_dc, averaged_dc;
 
 uint16_t periodic_tx_dc=0;
-#if WITH_ORPL_LB_DIO_TARGET
-uint16_t periodic_tx_dc=0;
-#endif
 uint32_t strobe_time, default_strobe_time, bcast_strobe_time;//use to manage strobe_time
 int loadbalancing_is_on=0;//MF
+#if WITH_ORPL_LB_CTRL
+/* Closed-loop controller of the wake-up interval */
+static struct orpl_dc_ctrl dc_ctrl;
+#endif /* WITH_ORPL_LB_CTRL */
 #endif /*WITH_ORPL_LB*/
 
 #define WITH_SFD_COMPUTATION 0
@@ -381,19 +390,12 @@ struct seqno {
   uint8_t seqno;
 };
 
-struct app_seqno {
-  uint32_t seqno;
-};
-
 #ifdef NETSTACK_CONF_MAC_SEQNO_HISTORY
 #define MAX_SEQNOS_LL NETSTACK_CONF_MAC_SEQNO_HISTORY
 #else /* NETSTACK_CONF_MAC_SEQNO_HISTORY */
 #define MAX_SEQNOS_LL 16
 #endif /* NETSTACK_CONF_MAC_SEQNO_HISTORY */
 static struct seqno received_seqnos[MAX_SEQNOS_LL];
-/* App-layer duplicate detection. Done at RDC layer for simplicity. */
-#define MAX_SEQNOS_APP 32
-static struct app_seqno received_app_seqnos[MAX_SEQNOS_APP];
 
 #if CONTIKIMAC_CONF_BROADCAST_RATE_LIMIT
 static struct timer broadcast_rate_timer;
@@ -407,6 +409,7 @@ on(void)
   if(contikimac_is_on && radio_is_on == 0) {
     radio_is_on = 1;
     NETSTACK_RADIO.on();
+    ORPL_RADIO_STATS(orpl_radio_stats_on());
   }
 }
 /*---------------------------------------------------------------------------*/
@@ -417,6 +420,7 @@ off(void)
      contikimac_keep_radio_on == 0) {
     radio_is_on = 0;
     NETSTACK_RADIO.off();
+    ORPL_RADIO_STATS(orpl_radio_stats_off());
   }
 }
 /*---------------------------------------------------------------------------*/
@@ -534,6 +538,7 @@ powercycle(struct rtimer *t, void *ptr)
     for(count = 0; count < CCA_COUNT_MAX; ++count) {
       t0 = RTIMER_NOW();
       if(we_are_sending == 0 && we_are_receiving_burst == 0) {
+        ORPL_RADIO_STATS(orpl_radio_stats_set_activity(ORPL_RADIO_CCA, ORPL_RADIO_OWN));
         powercycle_turn_radio_on();
         /* Check if a packet is seen in the air. If so, we keep the
              radio on for a while (LISTEN_TIME_AFTER_PACKET_DETECTED) to
@@ -555,6 +560,8 @@ powercycle(struct rtimer *t, void *ptr)
       static rtimer_clock_t start;
       static uint8_t silence_periods, periods;
       start = RTIMER_NOW();
+      /* Counted as a false wake-up unless we end up receiving a frame */
+      ORPL_RADIO_STATS(orpl_radio_stats_set_activity(ORPL_RADIO_FALSE_WAKEUP, ORPL_RADIO_OWN));
 
       periods = silence_periods = 0;
       while(we_are_sending == 0 && radio_is_on &&
@@ -614,6 +621,10 @@ powercycle(struct rtimer *t, void *ptr)
           powercycle_turn_radio_off();
         }
       }
+      if(radio_is_on) {
+        /* The radio is left on for a frame being received */
+        ORPL_RADIO_STATS(orpl_radio_stats_reclassify(ORPL_RADIO_RX));
+      }
     }
 
 #if WITH_SFD_COMPUTATION
@@ -672,6 +683,9 @@ static void setLoadBalancing(int mode){
       ORPL_LOG("ORPL_LB OFF\n");
       //default_strobe_time=CONTIKIMAC_CONF_CYCLE_TIME;
       cycle_time=CONTIKIMAC_CONF_CYCLE_TIME;
+#if WITH_ORPL_LB_CTRL
+      orpl_dc_ctrl_reset(&dc_ctrl);
+#endif /* WITH_ORPL_LB_CTRL */
     }
     ctimer_stop(&ct_guard);//disable the guard timer
   }
@@ -699,7 +713,12 @@ static void managecycle(void *ptr){
     if(cpt>=5){//avoid some disparity at the beginning (LB enabled after 10 minutes anyway)
       total_dc_spent=total_dc_spent+(delta_tx+delta_rx)/100ul;
       ORPL_LOG("ORPL_LB: energy : %lu-%lu\n",total_dc_spent, delta_tx+delta_rx );
+#if WITH_ORPL_ENERGY
+      /* The energy model decides when we run out of battery */
+      if(orpl_energy_remaining() == 0){
+#else /* WITH_ORPL_ENERGY */
       if(total_dc_spent > ENERGY_THRESHOLD*10){
+#endif /* WITH_ORPL_ENERGY */
         NETSTACK_RDC.off(0);//don't keep the radio on
         NETSTACK_MAC.off(0);
         ORPL_LOG("ORPL_LB: DEAD!!!!!!!!!\n");
@@ -714,14 +733,14 @@ static void managecycle(void *ptr){
     //periodic_tx_dc = (uint16_t)((10ul * (delta_tx))/(delta_time/1000ul));
 #if WITH_ORPL_LB_DIO_TARGET && WITH_ORPL_LB
     if(dio_dc_objective==0){
-      objective_dc = (uint16_t)(DUTY_CYCLE_TARGET*100ul);
+      objective_dc = DUTY_CYCLE_TARGET;
     }
     else{
       objective_dc=dio_dc_objective;
     }
     periodic_tx_dc = (uint16_t)((10ul * (delta_tx))/(delta_time/1000ul));
 #else /*WITH_ORPL_LB_DIO_TARGET && WITH_ORPL_LB*/
-    objective_dc = (uint16_t)(DUTY_CYCLE_TARGET*100ul);
+    objective_dc = DUTY_CYCLE_TARGET;
 #endif /*WITH_ORPL_LB_DIO_TARGET && WITH_ORPL_LB*/
 
 
@@ -732,16 +751,21 @@ static void managecycle(void *ptr){
 
     averaged_dc=(periodic_dc + ((uint32_t)cpt) * averaged_dc)/(uint32_t)(cpt+1);//averaged DC since beginning
     //cycle_time_avg=((cycle_time* 1000/RTIMER_ARCH_SECOND) + ((uint32_t)cpt) * cycle_time_avg)/(uint32_t)(cpt+1);
-    weighted_dc=(uint16_t)((DC_ALPHA*100ul*periodic_dc + (1*100ul-DC_ALPHA*100ul)*weighted_dc)/100ul);
-
+    weighted_dc=(uint16_t)((DC_ALPHA*(uint32_t)periodic_dc + (100ul-DC_ALPHA)*weighted_dc)/100ul);
 
 
-    ORPL_LOG("ORPL_LB: %u - %u - %u / %u",periodic_dc,weighted_dc,averaged_dc,packet_count_current);
+#if COLLECT_ONLY
+    ORPL_LOG("ORPL_LB: %u - %u - %u / %lu",periodic_dc,weighted_dc,averaged_dc,packet_count_current);
+#else /* COLLECT_ONLY */
+    ORPL_LOG("ORPL_LB: %u - %u - %u",periodic_dc,weighted_dc,averaged_dc);
+#endif /* COLLECT_ONLY */
+#if COLLECT_ONLY
     if(cpt>=5)
     {
       packet_count_avg=(packet_count_current*100 + ((uint32_t)cpt-5) * packet_count_avg)/(uint32_t)(cpt-5+1);//*100 pour éviter arrondi, moyenne pour éviter écart du début, -5 car rien transmis pendant 10 min
       packet_count_current=0;
     }
+#endif /* COLLECT_ONLY */
     cycle_time_sum+=(uint32_t)(cycle_time* 1000/RTIMER_ARCH_SECOND);
     if(cpt > 0 && (cpt+1)%5==0){
       cycle_time_avg=cycle_time_sum/5ul;
@@ -749,6 +773,14 @@ static void managecycle(void *ptr){
       cycle_time_sum=0;
     }
     if(loadbalancing_is_on){
+#if WITH_ORPL_LB_CTRL
+      /* The PI controller replaces both the proportional step and the
+       * collect-only rollback heuristic */
+      cycle_time = orpl_dc_ctrl_update(&dc_ctrl, weighted_dc, objective_dc);
+      ORPL_LOG(" | e %d i %ld sat %u conv %u",
+          dc_ctrl.error, (long)dc_ctrl.integral, dc_ctrl.saturations,
+          orpl_dc_ctrl_is_converged(&dc_ctrl) ? dc_ctrl.converged_at : 0);
+#else /* WITH_ORPL_LB_CTRL */
 
       if(averaged_dc > objective_dc + HYSTERESIS || averaged_dc < objective_dc - HYSTERESIS)
       {
@@ -864,6 +896,7 @@ static void managecycle(void *ptr){
       }
 
 #endif
+#endif /* WITH_ORPL_LB_CTRL */
 
 
       ORPL_LOG(" -> %lu",(unsigned long)(CYCLE_TIME* 1000/RTIMER_ARCH_SECOND));
@@ -897,6 +930,14 @@ static void managecycle(void *ptr){
 
   }
 }
+#if WITH_ORPL_LB_CTRL
+/* Returns the state of the wake-up interval controller */
+const struct orpl_dc_ctrl *
+contikimac_orpl_dc_ctrl(void)
+{
+  return &dc_ctrl;
+}
+#endif /* WITH_ORPL_LB_CTRL */
 #endif /*WITH_ORPL_LB*/
 /*---------------------------------------------------------------------------*/
 static int
@@ -932,6 +973,19 @@ send_packet(mac_callback_t mac_callback, void *mac_callback_ptr,
   uint8_t got_strobe_ack = 0;
   int hdrlen, len;
   uint8_t is_broadcast = 0;
+#if WITH_ORPL_MCAST
+  /* Group messages are strobed for a whole wake-up interval, as several
+   * neighbors may need them */
+  uint8_t is_mcast = packetbuf_attr(PACKETBUF_ATTR_ORPL_DIRECTION) == direction_mcast;
+#else /* WITH_ORPL_MCAST */
+  uint8_t is_mcast = 0;
+#endif /* WITH_ORPL_MCAST */
+#if WITH_ORPL_TRAFFIC_CLASS
+  /* Urgent frames don't wait for the later ACK slots once an ACK is coming */
+  uint8_t is_urgent = packetbuf_attr(PACKETBUF_ATTR_ORPL_CLASS) == ORPL_CLASS_URGENT;
+#else /* WITH_ORPL_TRAFFIC_CLASS */
+  uint8_t is_urgent = 0;
+#endif /* WITH_ORPL_TRAFFIC_CLASS */
   uint8_t collisions;
   int transmit_len;
   int ret;
@@ -988,6 +1042,19 @@ send_packet(mac_callback_t mac_callback, void *mac_callback_ptr,
 
   packetbuf_set_attr(PACKETBUF_ATTR_MAC_ACK, 1);
 
+#if WITH_ORPL_DELAY_TRACE
+  /* Add the delay spent at this hop so far to the packet: time spent in
+   * the queue and strobing during previous attempts. The time spent
+   * strobing during this attempt can't be included as the frame is
+   * already in the radio. */
+  {
+    uint16_t strobe_ms = packetbuf_attr(PACKETBUF_ATTR_ORPL_STROBE_TIME);
+    clock_time_t residence = clock_time() - (clock_time_t)packetbuf_attr(PACKETBUF_ATTR_ORPL_ENQUEUE_TIME);
+    uint16_t hop_ms = (uint16_t)(((uint32_t)residence * 1000) / CLOCK_SECOND);
+    ORPL_LOG_ADD_DELAY_FROM_PACKETBUF(hop_ms > strobe_ms ? hop_ms - strobe_ms : 0, strobe_ms);
+  }
+#endif /* WITH_ORPL_DELAY_TRACE */
+
 #if WITH_CONTIKIMAC_HEADER
   hdrlen = packetbuf_totlen();
   if(packetbuf_hdralloc(sizeof(struct hdr)) == 0) {
@@ -1067,6 +1134,13 @@ send_packet(mac_callback_t mac_callback, void *mac_callback_ptr,
      powercycle interrupt do not interfere with us sending the packet. */
   we_are_sending = 1;
 
+#if WITH_ORPL_RADIO_STATS
+  orpl_radio_stats_set_activity(is_broadcast ? ORPL_RADIO_TX_BROADCAST
+      : (packetbuf_attr(PACKETBUF_ATTR_ORPL_DIRECTION) != direction_none ? ORPL_RADIO_TX_ANYCAST
+      : ORPL_RADIO_TX_UNICAST),
+      packetbuf_attr(PACKETBUF_ATTR_ORPL_FORWARDED) ? ORPL_RADIO_FORWARDED : ORPL_RADIO_OWN);
+#endif /* WITH_ORPL_RADIO_STATS */
+
   /* If we have a pending packet in the radio, we should not send now,
      because we will trash the received packet. Instead, we signal
      that we have a collision, which lets the packet be received. This
@@ -1204,7 +1278,19 @@ send_packet(mac_callback_t mac_callback, void *mac_callback_ptr,
      /* Wait for the ACK packet */
       wt = RTIMER_NOW();
       NETSTACK_RADIO.on();
+#if WITH_ORPL_ACK_SLOTS
+      /* Forwarders can ack in a later slot. For urgent frames, stop
+       * waiting as soon as the first ACK is on the air. */
+      while(RTIMER_CLOCK_LT(RTIMER_NOW(), wt + INTER_PACKET_INTERVAL
+          + (is_broadcast ? 0 : (ORPL_ACK_SLOTS - 1) * ORPL_ACK_SLOT_TIME))) {
+        if(is_urgent && RTIMER_CLOCK_LT(wt + INTER_PACKET_INTERVAL, RTIMER_NOW())
+            && (NETSTACK_RADIO.receiving_packet() || NETSTACK_RADIO.pending_packet())) {
+          break;
+        }
+      }
+#else /* WITH_ORPL_ACK_SLOTS */
       while(RTIMER_CLOCK_LT(RTIMER_NOW(), wt + INTER_PACKET_INTERVAL)) { }
+#endif /* WITH_ORPL_ACK_SLOTS */
 
       if(NETSTACK_RADIO.receiving_packet() ||
                            NETSTACK_RADIO.pending_packet() ||
@@ -1225,6 +1311,9 @@ send_packet(mac_callback_t mac_callback, void *mac_callback_ptr,
             memcpy(&dest, ackbuf+3, 8);
             uint16_t neighbor_rank = (ackbuf[3+8+1]<<8) + ackbuf[3+8];
             rpl_set_parent_rank((uip_lladdr_t *)&dest, neighbor_rank);
+#if WITH_ORPL_ENERGY
+            orpl_energy_set_neighbor((uip_lladdr_t *)&dest, ackbuf[3+8+2]);
+#endif /* WITH_ORPL_ENERGY */
             orpl_broadcast_acked(&dest);
           } else {
           /* Received ack for anycast, stop strobing */
@@ -1233,7 +1322,11 @@ send_packet(mac_callback_t mac_callback, void *mac_callback_ptr,
             memcpy(&dest, ackbuf+3, 8);
             uint16_t neighbor_rank = (ackbuf[3+8+1]<<8) + ackbuf[3+8];
             rpl_set_parent_rank((uip_lladdr_t *)&dest, neighbor_rank);
-            if(got_strobe_ack >= 1) {
+#if WITH_ORPL_ENERGY
+            orpl_energy_set_neighbor((uip_lladdr_t *)&dest, ackbuf[3+8+2]);
+#endif /* WITH_ORPL_ENERGY */
+            orpl_strobe_acked(&dest);
+            if(got_strobe_ack >= 1 && !is_mcast) {
               break;
             }
           }
@@ -1273,6 +1366,11 @@ uint16_t strobe_duration;
   /* Accumulate strobe duration over multiple CSMA transmissions to get a correct EDC value */
   uint16_t edc = packetbuf_attr(PACKETBUF_ATTR_EDC) + edc_inc;
   packetbuf_set_attr(PACKETBUF_ATTR_EDC, edc);
+#if WITH_ORPL_DELAY_TRACE
+  /* Same for the strobing time, in ms, used for delay tracing */
+  packetbuf_set_attr(PACKETBUF_ATTR_ORPL_STROBE_TIME, packetbuf_attr(PACKETBUF_ATTR_ORPL_STROBE_TIME)
+      + (uint16_t)(((uint32_t)(rtimer_clock_t)(RTIMER_NOW() - t0) * 1000) / RTIMER_ARCH_SECOND));
+#endif /* WITH_ORPL_DELAY_TRACE */
 
   off();
 
@@ -1430,8 +1528,10 @@ static void
 wait_burst(void *ptr)
 {
   static struct ctimer ct2;
+  ORPL_RADIO_STATS(orpl_radio_stats_set_activity(ORPL_RADIO_RX_BURST, ORPL_RADIO_OWN));
   NETSTACK_RADIO.on();
   radio_is_on=1;
+  ORPL_RADIO_STATS(orpl_radio_stats_on());
   ctimer_set(&ct2, CLOCK_SECOND/24, recv_burst_off, NULL);
 }
 /*---------------------------------------------------------------------------*/
@@ -1452,6 +1552,12 @@ input_packet(void)
     if(ret.direction != direction_none) {
       packetbuf_set_attr(PACKETBUF_ATTR_EDC, ret.neighbor_edc);
       orpl_packetbuf_set_seqno(ret.seqno);
+#if WITH_ORPL_PATH_HINT
+      packetbuf_set_attr(PACKETBUF_ATTR_ORPL_HINT, ret.hint);
+#endif /* WITH_ORPL_PATH_HINT */
+#if WITH_ORPL_TRAFFIC_CLASS
+      packetbuf_set_attr(PACKETBUF_ATTR_ORPL_CLASS, ret.traffic_class);
+#endif /* WITH_ORPL_TRAFFIC_CLASS */
     } else {
       packetbuf_set_attr(PACKETBUF_ATTR_EDC, 0xffff);
     }
@@ -1556,26 +1662,12 @@ input_packet(void)
       PRINTDEBUG("contikimac: data (%u)\n", packetbuf_datalen());
 
       if(packetbuf_attr(PACKETBUF_ATTR_ORPL_DIRECTION) != direction_none) {
-        /* Duplicate detection */
-        {
-          int i;
-          uint32_t seqno = orpl_packetbuf_seqno();
-          if(packetbuf_attr(PACKETBUF_ATTR_ORPL_DIRECTION) != direction_recover) {
-            for(i = 0; i < MAX_SEQNOS_APP; ++i) {
-              /* base the comparison on both seqno and false-positive count, so that fp recovery packet
-               * are not dropped as app-layer duplicates */
-              if(seqno == received_app_seqnos[i].seqno) {
-                /* Drop the packet. */
-            	ORPL_LOG_FROM_PACKETBUF("Cmac:! dropping app-layer duplicate from %d",
-            	    ORPL_LOG_NODEID_FROM_RIMEADDR(packetbuf_addr(PACKETBUF_ADDR_SENDER)));
-                return;
-              }
-            }
-          }
-          for(i = MAX_SEQNOS_APP - 1; i > 0; --i) {
-            received_app_seqnos[i] = received_app_seqnos[i - 1];
-          }
-          received_app_seqnos[0].seqno = seqno;
+        /* App-layer duplicate detection. Done at RDC layer for simplicity. */
+        if(orpl_anycast_is_duplicate()) {
+          /* Drop the packet. */
+          ORPL_LOG_FROM_PACKETBUF("Cmac:! dropping app-layer duplicate from %d",
+              ORPL_LOG_NODEID_FROM_RIMEADDR(packetbuf_addr(PACKETBUF_ADDR_SENDER)));
+          return;
         }
         
         ORPL_LOG_INC_HOPCOUNT_FROM_PACKETBUF();
@@ -1585,12 +1677,19 @@ input_packet(void)
 #if COLLECT_ONLY && WITH_ORPL_LB
         packet_count_current+=1;
 #endif /* COLLECT_ONLY */
+#if WITH_ORPL_FAST_FORWARD
+        /* Frames we only forward don't need to go through uIP */
+        if(orpl_fast_forward()) {
+          return;
+        }
+#endif /* WITH_ORPL_FAST_FORWARD */
       }
       
       NETSTACK_MAC.input();
       return;
     } else {
       PRINTDEBUG("contikimac: data not for us\n");
+      ORPL_RADIO_STATS(orpl_radio_stats_reclassify_last(ORPL_RADIO_RX, ORPL_RADIO_OVERHEAR));
     }
   } else {
     PRINTF("contikimac: failed to parse (%u)\n", packetbuf_totlen());
@@ -1608,6 +1707,9 @@ init(void)
   //bcast_strobe_time=CYCLE_TIME;
   bcast_strobe_time=CONTIKIMAC_CONF_CYCLE_TIME;//the bcast strobe time never changed
   strobe_time=bcast_strobe_time;
+#if WITH_ORPL_LB_CTRL
+  orpl_dc_ctrl_init(&dc_ctrl, CONTIKIMAC_CONF_CYCLE_TIME, CYCLE_MIN, CYCLE_MAX, CYCLE_STEP_MAX);
+#endif /* WITH_ORPL_LB_CTRL */
 #endif
   rtimer_set(&rt, RTIMER_NOW() + (random_rand() % CYCLE_TIME), 1,
              (void (*)(struct rtimer *, void *))powercycle, NULL);
@@ -1628,6 +1730,7 @@ init(void)
   phase_init();
 #endif /* WITH_PHASE_OPTIMIZATION */
 
+  ORPL_RADIO_STATS(orpl_radio_stats_init());
 }
 /*---------------------------------------------------------------------------*/
 static int
@@ -1647,6 +1750,8 @@ turn_off(int keep_radio_on)
 {
   contikimac_is_on = 0;
   contikimac_keep_radio_on = keep_radio_on;
+  /* Radio time is only accounted for while duty cycling */
+  ORPL_RADIO_STATS(orpl_radio_stats_off());
   if(keep_radio_on) {
     radio_is_on = 1;
     return NETSTACK_RADIO.on();
@@ -14,4 +14,10 @@ extern uint16_t periodic_tx_dc;
 extern uint16_t periodic_dc;
 #endif
 
+#if WITH_ORPL_LB_CTRL
+#include "orpl-dc-ctrl.h"
+/* Returns the state of the wake-up interval controller, for telemetry */
+const struct orpl_dc_ctrl *contikimac_orpl_dc_ctrl(void);
+#endif /* WITH_ORPL_LB_CTRL */
+
 #endif /* CONTIKIMAC_ORPL_H_ */
@@ -0,0 +1,155 @@
+/*
+ * Copyright (c) 2014, Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+  *
+ */
+/**
+ * \file
+ *         Border router running the ORPL root on a Linux host, on top of a
+ *         radio mote running radio/slip-radio-orpl.c. Based on Contiki's
+ *         native border router.
+ *
+ */
+
+#include "contiki.h"
+#include "contiki-lib.h"
+#include "contiki-net.h"
+#include "net/uip.h"
+#include "net/uip-ds6.h"
+#include "net/rpl/rpl.h"
+#include "net/netstack.h"
+#include "cmd.h"
+#include "border-router.h"
+#include "border-router-cmds.h"
+#include "deployment.h"
+#include "orpl.h"
+#include "orpl-br.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define DEBUG DEBUG_FULL
+#include "net/uip-debug.h"
+
+extern long slip_sent;
+extern long slip_received;
+
+extern int contiki_argc;
+extern char **contiki_argv;
+
+/* The deployment tools identify nodes from their MAC address: the host
+ * takes that of the radio mote */
+unsigned char ds2411_id[8];
+unsigned short node_id;
+
+static uint8_t mac_set;
+
+CMD_HANDLERS(orpl_br_host_cmd_handler, border_router_cmd_handler);
+
+PROCESS(border_router_process, "ORPL border router process");
+AUTOSTART_PROCESSES(&border_router_process, &border_router_cmd_process);
+
+/*---------------------------------------------------------------------------*/
+static void
+request_mac(void)
+{
+  write_to_slip((uint8_t *)"?M", 2);
+}
+/*---------------------------------------------------------------------------*/
+void
+border_router_set_mac(const uint8_t *data)
+{
+  memcpy(uip_lladdr.addr, data, sizeof(uip_lladdr.addr));
+  rimeaddr_set_node_addr((rimeaddr_t *)uip_lladdr.addr);
+  memcpy(ds2411_id, data, sizeof(ds2411_id));
+  node_id = get_node_id();
+
+  uip_ds6_init();
+  rpl_init();
+
+  mac_set = 1;
+}
+/*---------------------------------------------------------------------------*/
+void
+border_router_print_stat()
+{
+  printf("bytes received over SLIP: %ld\n", slip_received);
+  printf("bytes sent over SLIP: %ld\n", slip_sent);
+}
+/*---------------------------------------------------------------------------*/
+void
+border_router_set_sensors(const char *data, int len)
+{
+  printf("Radio sensors: %.*s\n", len, data);
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(border_router_process, ev, data)
+{
+  static struct etimer et;
+  uip_ipaddr_t global_ipaddr;
+
+  PROCESS_BEGIN();
+
+  PROCESS_PAUSE();
+
+  PRINTF("ORPL border router started\n");
+
+  slip_config_handle_arguments(contiki_argc, contiki_argv);
+
+  /* tun init is also responsible for setting up the SLIP connection */
+  tun_init();
+
+  while(!mac_set) {
+    etimer_set(&et, CLOCK_SECOND);
+    request_mac();
+    PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&et));
+  }
+
+  if(!is_sink_id(node_id)) {
+    PRINTF("Radio %u is not a sink of the deployment\n", node_id);
+    exit(1);
+  }
+
+  /* Same global address and DODAG as a root mote would have */
+  deployment_init(&global_ipaddr);
+  orpl_init(1, 0);
+  orpl_br_host_push_digest();
+
+  PRINTF("ORPL root %u: ", node_id);
+  PRINT6ADDR(&global_ipaddr);
+  PRINTF("\n");
+
+  while(1) {
+    etimer_set(&et, CLOCK_SECOND * 60);
+    PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&et));
+    border_router_print_stat();
+  }
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
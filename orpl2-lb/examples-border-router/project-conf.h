@@ -0,0 +1,83 @@
+/*
+ * Copyright (c) 2014, Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+  *
+ */
+/**
+ * \file
+ *         Configuration of the host side of the split ORPL root
+ *
+ */
+
+#ifndef __PROJECT_CONF_H__
+#define __PROJECT_CONF_H__
+
+#define WITH_ORPL 1
+/* The ORPL state of the root runs here, frames go through the radio mote */
+#define WITH_ORPL_BR_HOST 1
+#define COLLECT_ONLY 1
+#define WITH_ENERGY_THRESHOLD 0
+
+/* The ContikiMAC wakeup interval of the network, used for csma backoffs */
+#define CONTIKIMAC_CONF_CYCLE_TIME (RTIMER_ARCH_SECOND / 2)
+
+/* Same 6LoWPAN settings as the motes */
+#undef SICSLOWPAN_CONF_FRAG
+#define SICSLOWPAN_CONF_FRAG     0
+#undef UIP_CONF_UDP_CHECKSUMS
+#define UIP_CONF_UDP_CHECKSUMS   0
+
+/* Memory is not an issue here */
+#undef NBR_TABLE_CONF_MAX_NEIGHBORS
+#define NBR_TABLE_CONF_MAX_NEIGHBORS 64
+#undef UIP_CONF_MAX_ROUTES
+#define UIP_CONF_MAX_ROUTES      256
+#undef UIP_CONF_BUFFER_SIZE
+#define UIP_CONF_BUFFER_SIZE    1280
+#undef QUEUEBUF_CONF_NUM
+#define QUEUEBUF_CONF_NUM         16
+
+#include "tools/orpl-log.h"
+#include "orpl-contiki-conf.h"
+
+/* Traffic to the outside goes through the tun interface */
+#undef UIP_FALLBACK_INTERFACE
+#define UIP_FALLBACK_INTERFACE rpl_interface
+
+/* slip-cmd settings of the native border router */
+#define SLIP_DEV_CONF_SEND_DELAY (CLOCK_SECOND / 32)
+#define SERIALIZE_ATTRIBUTES 1
+#define CMD_CONF_OUTPUT border_router_cmd_output
+#define SELECT_CALLBACK 1
+
+/* Packets are handed to the radio mote, which runs ContikiMAC-ORPL */
+#undef NETSTACK_CONF_RDC
+#define NETSTACK_CONF_RDC     orpl_br_host_rdc_driver
+#undef NETSTACK_CONF_RADIO
+#define NETSTACK_CONF_RADIO   nullradio_driver
+
+#endif /* __PROJECT_CONF_H__ */
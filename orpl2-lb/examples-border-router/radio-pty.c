@@ -0,0 +1,291 @@
+/*
+ * Copyright (c) 2014, Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+  *
+ */
+/**
+ * \file
+ *         Pseudo-terminal stand-in for the radio mote of the split ORPL
+ *         root, to run the border router without hardware:
+ *           ./radio-pty [-m mac] [-a acker] [-e edc]
+ *           sudo ./border-router.native -s pts/N aaaa::1/64, N as printed
+ *         Answers the MAC requests, reports every packet as acked by
+ *         acker with the given EDC, and prints the digests pushed by the
+ *         host. Every line of hex typed on stdin is sent to the host as a
+ *         received frame: sender[8] receiver[8] atts payload.
+ *
+ */
+
+#define _DEFAULT_SOURCE
+#define _XOPEN_SOURCE 600
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <termios.h>
+#include <sys/select.h>
+
+#define SLIP_END     0300
+#define SLIP_ESC     0333
+#define SLIP_ESC_END 0334
+#define SLIP_ESC_ESC 0335
+
+/* From orpl-br.h, kept here so that radio-pty builds with plain gcc */
+#define ORPL_BR_ACK_INFO_LEN     11
+#define ORPL_BR_DIGEST_FLAGS     2
+#define ORPL_BR_DIGEST_IPADDR    3
+#define ORPL_BR_DIGEST_RS        19
+
+static int fd;
+static uint8_t mac[8] = {0x00, 0x12, 0x74, 0x01, 0x00, 0x01, 0x01, 0x01};
+static uint8_t acker[8] = {0x00, 0x12, 0x74, 0x02, 0x00, 0x02, 0x02, 0x02};
+static unsigned edc = 256;
+
+/*---------------------------------------------------------------------------*/
+static void
+slip_write(const uint8_t *buf, int len)
+{
+  uint8_t out[2 * 512 + 2];
+  int i, pos = 0;
+  out[pos++] = SLIP_END;
+  for(i = 0; i < len && i < 512; i++) {
+    if(buf[i] == SLIP_END) {
+      out[pos++] = SLIP_ESC;
+      out[pos++] = SLIP_ESC_END;
+    } else if(buf[i] == SLIP_ESC) {
+      out[pos++] = SLIP_ESC;
+      out[pos++] = SLIP_ESC_ESC;
+    } else {
+      out[pos++] = buf[i];
+    }
+  }
+  out[pos++] = SLIP_END;
+  if(write(fd, out, pos) != pos) {
+    perror("radio-pty: write");
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+print_addr(const uint8_t *addr)
+{
+  int i;
+  for(i = 0; i < 8; i++) {
+    printf("%s%02x", i ? ":" : "", addr[i]);
+  }
+}
+/*---------------------------------------------------------------------------*/
+static int
+parse_addr(const char *str, uint8_t *addr)
+{
+  unsigned b[8];
+  int i;
+  if(sscanf(str, "%x:%x:%x:%x:%x:%x:%x:%x",
+            &b[0], &b[1], &b[2], &b[3], &b[4], &b[5], &b[6], &b[7]) != 8) {
+    return 0;
+  }
+  for(i = 0; i < 8; i++) {
+    addr[i] = b[i];
+  }
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+static void
+report(uint8_t sid, int is_broadcast)
+{
+  uint8_t buf[5 + ORPL_BR_ACK_INFO_LEN];
+  buf[0] = '!';
+  buf[1] = 'R';
+  buf[2] = sid;
+  buf[3] = 0; /* MAC_TX_OK */
+  buf[4] = 1;
+  memset(buf + 5, 0, ORPL_BR_ACK_INFO_LEN);
+  if(!is_broadcast) {
+    memcpy(buf + 5, acker, 8);
+    buf[5 + 8] = edc >> 8;
+    buf[5 + 9] = edc & 0xff;
+    buf[5 + 10] = 255;
+  }
+  slip_write(buf, sizeof(buf));
+
+  if(is_broadcast) {
+    /* Broadcast acked by acker */
+    uint8_t done[3 + ORPL_BR_ACK_INFO_LEN];
+    done[0] = '!';
+    done[1] = 'B';
+    done[2] = 1;
+    memcpy(done + 3, acker, 8);
+    done[3 + 8] = edc >> 8;
+    done[3 + 9] = edc & 0xff;
+    done[3 + 10] = 255;
+    slip_write(done, sizeof(done));
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+handle_frame(const uint8_t *data, int len)
+{
+  static const uint8_t null_addr[8];
+  int i, bits;
+
+  if(len >= 2 && data[0] == '?' && data[1] == 'M') {
+    uint8_t buf[10];
+    buf[0] = '!';
+    buf[1] = 'M';
+    memcpy(buf + 2, mac, 8);
+    slip_write(buf, sizeof(buf));
+  } else if(len >= 11 && data[0] == '!' && data[1] == 'S') {
+    printf("radio-pty: send %u to ", data[2]);
+    print_addr(data + 3);
+    printf(", %d bytes\n", len - 11);
+    report(data[2], memcmp(data + 3, null_addr, 8) == 0);
+  } else if(len > 2 + ORPL_BR_DIGEST_RS && data[0] == '!' && data[1] == 'O') {
+    data += 2;
+    len -= 2;
+    for(i = ORPL_BR_DIGEST_RS, bits = 0; i < len; i++) {
+      bits += __builtin_popcount(data[i]);
+    }
+    printf("radio-pty: digest edc %u flags %02x ip ", (data[0] << 8) | data[1],
+           data[ORPL_BR_DIGEST_FLAGS]);
+    for(i = 0; i < 16; i += 2) {
+      printf("%s%x", i ? ":" : "",
+             (data[ORPL_BR_DIGEST_IPADDR + i] << 8) | data[ORPL_BR_DIGEST_IPADDR + i + 1]);
+    }
+    printf(" routing set %d/%d bits\n", bits, (len - ORPL_BR_DIGEST_RS) * 8);
+  } else if(len > 0) {
+    printf("radio-pty: ignoring '%c%c' (%d bytes)\n", data[0],
+           len > 1 ? data[1] : ' ', len);
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+slip_read(void)
+{
+  static uint8_t buf[1024];
+  static int len, esc;
+  uint8_t in[256];
+  int i, n;
+
+  n = read(fd, in, sizeof(in));
+  if(n <= 0) {
+    return;
+  }
+  for(i = 0; i < n; i++) {
+    if(in[i] == SLIP_END) {
+      handle_frame(buf, len);
+      len = 0;
+    } else if(in[i] == SLIP_ESC) {
+      esc = 1;
+    } else if(len < sizeof(buf)) {
+      if(esc) {
+        buf[len++] = in[i] == SLIP_ESC_END ? SLIP_END : SLIP_ESC;
+        esc = 0;
+      } else {
+        buf[len++] = in[i];
+      }
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+stdin_read(void)
+{
+  char line[1024];
+  uint8_t buf[2 + 512];
+  unsigned b;
+  char *p;
+  int len = 2, n;
+
+  if(fgets(line, sizeof(line), stdin) == NULL) {
+    exit(0);
+  }
+  buf[0] = '!';
+  buf[1] = 'I';
+  for(p = line; len < sizeof(buf) && sscanf(p, " %2x%n", &b, &n) == 1; p += n) {
+    buf[len++] = b;
+  }
+  if(len > 2 + 16) {
+    slip_write(buf, len);
+    printf("radio-pty: input %d bytes\n", len - 2);
+  }
+}
+/*---------------------------------------------------------------------------*/
+int
+main(int argc, char **argv)
+{
+  struct termios tio;
+  int c, slave;
+
+  while((c = getopt(argc, argv, "m:a:e:")) != -1) {
+    if(c == 'm' && parse_addr(optarg, mac)) {
+      continue;
+    } else if(c == 'a' && parse_addr(optarg, acker)) {
+      continue;
+    } else if(c == 'e') {
+      edc = atoi(optarg);
+      continue;
+    }
+    fprintf(stderr, "usage: %s [-m mac] [-a acker] [-e edc]\n", argv[0]);
+    return 1;
+  }
+
+  fd = posix_openpt(O_RDWR | O_NOCTTY);
+  if(fd < 0 || grantpt(fd) < 0 || unlockpt(fd) < 0) {
+    perror("radio-pty: posix_openpt");
+    return 1;
+  }
+  /* Raw line, as a serial port */
+  slave = open(ptsname(fd), O_RDWR | O_NOCTTY);
+  if(slave >= 0 && tcgetattr(slave, &tio) == 0) {
+    cfmakeraw(&tio);
+    tcsetattr(slave, TCSANOW, &tio);
+  }
+  setvbuf(stdout, NULL, _IOLBF, 0);
+  printf("radio-pty: mac ");
+  print_addr(mac);
+  printf(" on %s\n", ptsname(fd));
+
+  while(1) {
+    fd_set rset;
+    FD_ZERO(&rset);
+    FD_SET(fd, &rset);
+    FD_SET(STDIN_FILENO, &rset);
+    if(select(fd + 1, &rset, NULL, NULL, NULL) < 0) {
+      perror("radio-pty: select");
+      return 1;
+    }
+    if(FD_ISSET(fd, &rset)) {
+      slip_read();
+    }
+    if(FD_ISSET(STDIN_FILENO, &rset)) {
+      stdin_read();
+    }
+  }
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,93 @@
+/*
+ * Copyright (c) 2014, Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+  *
+ */
+/**
+ * \file
+ *         Configuration of the radio side of the split ORPL root
+ *
+ */
+
+#ifndef __PROJECT_CONF_H__
+#define __PROJECT_CONF_H__
+
+#define WITH_ORPL 1
+/* Relays frames for the ORPL root running on the host */
+#define WITH_ORPL_BR_RADIO 1
+#define COLLECT_ONLY 1
+#define WITH_ENERGY_THRESHOLD 0
+
+/* The IEEE 802.15.4 channel in use */
+#undef RF_CHANNEL
+#define RF_CHANNEL              15
+
+/* 32-bit rtimer */
+#define RTIMER_CONF_SECOND (4096UL*8)
+typedef uint32_t rtimer_clock_t;
+#define RTIMER_CLOCK_LT(a,b)     ((int32_t)(((rtimer_clock_t)a)-((rtimer_clock_t)b)) < 0)
+
+/* The ContikiMAC wakeup interval */
+#define CONTIKIMAC_CONF_CYCLE_TIME (RTIMER_ARCH_SECOND / 2 )
+
+/* No uIP on the radio, frames are relayed as they are */
+#undef UIP_CONF_BUFFER_SIZE
+#define UIP_CONF_BUFFER_SIZE    140
+#undef UIP_CONF_ROUTER
+#define UIP_CONF_ROUTER           0
+#undef UIP_CONF_IPV6_RPL
+#define UIP_CONF_IPV6_RPL         0
+#undef QUEUEBUF_CONF_NUM
+#define QUEUEBUF_CONF_NUM         4
+
+#include "tools/orpl-log.h"
+#include "orpl-contiki-conf.h"
+
+/* The radio is always on, the host does not run duty cycle control */
+#undef WITH_ORPL_LB
+#define WITH_ORPL_LB 0
+#undef WITH_ORPL_LB_DIO_TARGET
+#define WITH_ORPL_LB_DIO_TARGET 0
+#undef WITH_ORPL_LB_CTRL
+#define WITH_ORPL_LB_CTRL 0
+/* All frames go to the host */
+#undef WITH_ORPL_FAST_FORWARD
+#define WITH_ORPL_FAST_FORWARD 0
+
+#define CMD_CONF_OUTPUT slip_radio_cmd_output
+#define CMD_CONF_HANDLERS orpl_br_radio_cmd_handler,slip_radio_cmd_handler
+
+/* ContikiMAC-ORPL below a network driver relaying frames to the host */
+#undef NETSTACK_CONF_MAC
+#define NETSTACK_CONF_MAC     nullmac_driver
+#undef NETSTACK_CONF_NETWORK
+#define NETSTACK_CONF_NETWORK orpl_br_radio_driver
+
+#undef UART1_CONF_RX_WITH_DMA
+#define UART1_CONF_RX_WITH_DMA           1
+
+#endif /* __PROJECT_CONF_H__ */
@@ -0,0 +1,161 @@
+/*
+ * Copyright (c) 2014, Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+  *
+ */
+/**
+ * \file
+ *         Radio mote of the split ORPL root: a slip-radio running
+ *         ContikiMAC-ORPL, that acks anycasts for the host and relays
+ *         frames to it (see orpl-br.h).
+ *
+ */
+
+#include "contiki.h"
+#include "net/uip.h"
+#include "net/netstack.h"
+#include "dev/slip.h"
+#include "cmd.h"
+#include "orpl-br.h"
+#include <stdio.h>
+
+#define SLIP_END     0300
+#define SLIP_ESC     0333
+#define SLIP_ESC_END 0334
+#define SLIP_ESC_ESC 0335
+
+int slip_radio_cmd_handler(const uint8_t *data, int len);
+
+CMD_HANDLERS(CMD_CONF_HANDLERS);
+
+/*---------------------------------------------------------------------------*/
+static void
+slip_send_packet(const uint8_t *ptr, int len)
+{
+  uint16_t i;
+  uint8_t c;
+
+  slip_arch_writeb(SLIP_END);
+  for(i = 0; i < len; ++i) {
+    c = *ptr++;
+    if(c == SLIP_END) {
+      slip_arch_writeb(SLIP_ESC);
+      c = SLIP_ESC_END;
+    } else if(c == SLIP_ESC) {
+      slip_arch_writeb(SLIP_ESC);
+      c = SLIP_ESC_ESC;
+    }
+    slip_arch_writeb(c);
+  }
+  slip_arch_writeb(SLIP_END);
+}
+/*---------------------------------------------------------------------------*/
+/* Answers the MAC address requests of the host */
+int
+slip_radio_cmd_handler(const uint8_t *data, int len)
+{
+  int i;
+  if(data[0] == '?' && data[1] == 'M') {
+    uint8_t buf[2 + sizeof(uip_lladdr.addr)];
+    buf[0] = '!';
+    buf[1] = 'M';
+    for(i = 0; i < sizeof(uip_lladdr.addr); i++) {
+      buf[2 + i] = uip_lladdr.addr[i];
+    }
+    cmd_send(buf, sizeof(buf));
+    return 1;
+  }
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+void
+slip_radio_cmd_output(const uint8_t *data, int data_len)
+{
+  slip_send_packet(data, data_len);
+}
+/*---------------------------------------------------------------------------*/
+static void
+slip_input_callback(void)
+{
+  cmd_input(uip_buf, uip_len);
+  uip_len = 0;
+}
+/*---------------------------------------------------------------------------*/
+/* Debug output goes to the host as SLIP debug frames */
+#undef putchar
+int
+putchar(int c)
+{
+  static char debug_frame = 0;
+
+  if(!debug_frame) {            /* Start of debug output */
+    slip_arch_writeb(SLIP_END);
+    slip_arch_writeb('\r');     /* Type debug line == '\r' */
+    debug_frame = 1;
+  }
+
+  slip_arch_writeb((char)c);
+
+  /* Line buffered output, a newline marks the end of debug output */
+  if(c == '\n') {
+    slip_arch_writeb(SLIP_END);
+    debug_frame = 0;
+  }
+  return c;
+}
+/*---------------------------------------------------------------------------*/
+PROCESS(slip_radio_orpl_process, "Slip radio ORPL process");
+AUTOSTART_PROCESSES(&slip_radio_orpl_process);
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(slip_radio_orpl_process, ev, data)
+{
+  static struct etimer et;
+  PROCESS_BEGIN();
+
+#ifndef BAUD2UBR
+#define BAUD2UBR(baud) baud
+#endif
+  slip_arch_init(BAUD2UBR(115200));
+  process_start(&slip_process, NULL);
+  slip_set_input_callback(slip_input_callback);
+
+  orpl_br_radio_init();
+  /* Always on, as any ORPL root */
+  NETSTACK_RDC.off(1);
+  printf("Slip radio ORPL started\n");
+
+  /* Anycasts are not acked until the host pushed its state */
+  while(!orpl_br_radio_has_digest()) {
+    orpl_br_radio_request_digest();
+    etimer_set(&et, CLOCK_SECOND * 3);
+    PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&et));
+  }
+  printf("Slip radio ORPL got digest\n");
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
@@ -96,6 +96,11 @@ receiver(struct simple_udp_connection *c,
 {
   struct app_data data;
   appdata_copy(&data, (struct app_data*)dataptr);
+  /* The IPv6 source must be the origin, not the last forwarder */
+  if(ORPL_LOG_NODEID_FROM_IPADDR(sender_addr) != data.src) {
+    ORPL_LOG_FROM_APPDATAPTR((struct app_data *)dataptr, "App: wrong source %u",
+        ORPL_LOG_NODEID_FROM_IPADDR(sender_addr));
+  }
   if(data.ping) {
     ORPL_LOG_FROM_APPDATAPTR((struct app_data *)dataptr, "App: received ping");
   } else {
@@ -118,6 +123,8 @@ app_send_to(uint16_t id, int ping, uint32_t seqno)
   data.dest = id;
   data.hop = 0;
   data.fpcount = 0;
+  data.queue_delay = 0;
+  data.strobe_delay = 0;
   data.ping = ping;
 
   if(ping) {
@@ -155,13 +162,13 @@ PROCESS_THREAD(unicast_sender_process, ev, data)
 #endif
 
   deployment_init(&global_ipaddr);
-  orpl_init(node_id == ROOT_ID, 0);
+  orpl_init(is_sink_id(node_id), 0);
   simple_udp_register(&unicast_connection, UDP_PORT,
                       NULL, UDP_PORT, receiver);
 
   //printf("App: %u starting\n", node_id);
 
-  if(node_id == ROOT_ID) {
+  if(is_sink_id(node_id)) {
     NETSTACK_RDC.off(1);
   } else if(is_id_in_any_to_any(get_node_id())) {
     etimer_set(&periodic_timer, 2 * 60 * CLOCK_SECOND);
@@ -65,7 +65,6 @@ static uint16_t compteur=0;
 PROCESS(unicast_sender_process, "ORPL -- Collect-only Application");
 AUTOSTART_PROCESSES(&unicast_sender_process);
 /*---------------------------------------------------------------------------*/
-extern uint16_t dc_obj_metric, dc_obj_count;
 static void
 receiver(struct simple_udp_connection *c,
          const uip_ipaddr_t *sender_addr,
@@ -76,9 +75,7 @@ receiver(struct simple_udp_connection *c,
          uint16_t datalen)
 {
 #if WITH_ORPL_LB && WITH_ORPL_LB_DIO_TARGET
-  dc_obj_count+=1;
-  dc_obj_metric=(((struct app_data *)data)->dc_metric + (dc_obj_count-1) * dc_obj_metric)/dc_obj_count;
-  printf("ORPL_LB: DC metric average %u-%u\n",dc_obj_metric,((struct app_data *)data)->dc_metric);
+  orpl_dc_objective_report(((struct app_data *)data)->dc_metric);
 #endif
   ((struct app_data *)data)->hopcount=uip_ds6_if.cur_hop_limit - UIP_IP_BUF->ttl + 1;//added by macfly to use ttl from ipv6 header as hopcount
   ORPL_LOG_FROM_APPDATAPTR((struct app_data *)data, "App: received");
@@ -95,9 +92,10 @@ void app_send_to(uint16_t id) {
   data.dest = id;
   data.hop = 0;
   data.fpcount = 0;
+  data.queue_delay = 0;
+  data.strobe_delay = 0;
 #if WITH_ORPL_LB & WITH_ORPL_LB_DIO_TARGET
-  data.dc_metric=cycle_time* 1000/RTIMER_ARCH_SECOND;
-  //data.dc_metric=periodic_tx_dc;
+  data.dc_metric=periodic_dc;
 #endif
   //data.wuint = averageWUratio;
   set_ipaddr_from_id(&dest_ipaddr, id);
@@ -67,8 +67,6 @@ PROCESS(unicast_sender_process, "ORPL -- Collect-only Application");
 AUTOSTART_PROCESSES(&unicast_sender_process);
 /*---------------------------------------------------------------------------*/
 
-uint32_t dc_obj_metric=0;
-uint16_t dc_obj_count=0;
 uint8_t dead=0;
 static void
 receiver(struct simple_udp_connection *c,
@@ -79,14 +77,16 @@ receiver(struct simple_udp_connection *c,
          const uint8_t *data,
          uint16_t datalen)
 {
-#if WITH_ORPL_LB && WITH_ORPL_LB_DIO_TARGET
-  uint32_t temp=(uint32_t)(((struct app_data *)data)->dc_metric);
-  if(temp!=0){
-  //dc_obj_metric=(temp + ((uint32_t)(dc_obj_count)) * dc_obj_metric)/(uint32_t)(dc_obj_count+1);
-  dc_obj_metric+=temp;
-    dc_obj_count+=1;
-  printf("ORPL_LB: dc_metric %lu-%lu\n",dc_obj_metric,temp);
+  struct app_data appdata;
+  appdata_copy(&appdata, (struct app_data *)data);
+  /* The IPv6 source must be the origin, not the last forwarder */
+  if(ORPL_LOG_NODEID_FROM_IPADDR(sender_addr) != appdata.src) {
+    ORPL_LOG_FROM_APPDATAPTR((struct app_data *)data, "App: wrong source %u",
+        ORPL_LOG_NODEID_FROM_IPADDR(sender_addr));
   }
+#if WITH_ORPL_LB && WITH_ORPL_LB_DIO_TARGET
+  /* Feed the root-side duty-cycle objective computation */
+  orpl_dc_objective_report(appdata.dc_metric);
 #endif
   //printf("hop count test %u\n",uip_ds6_if.cur_hop_limit - UIP_IP_BUF->ttl + 1);
   ORPL_LOG_FROM_APPDATAPTR((struct app_data *)data, "App: received");
@@ -105,16 +105,25 @@ void app_send_to(uint16_t id) {
   data.dest = id;
   data.hop = 0;
   data.fpcount = 0;
+  data.queue_delay = 0;
+  data.strobe_delay = 0;
 #if WITH_ORPL_LB & WITH_ORPL_LB_DIO_TARGET
   //data.dc_metric=cycle_time* 1000/RTIMER_ARCH_SECOND;
-  data.dc_metric=periodic_tx_dc;
+  /* Report the total (tx+rx) duty cycle, which is what the objective
+   * is compared to in managecycle() */
+  data.dc_metric=periodic_dc;
 #endif
   //data.wuint = averageWUratio;
+#if WITH_ORPL_MULTI_SINK
+  if(id == ROOT_ID) {
+    /* Send to the virtual sink, reached through the nearest root */
+    orpl_sink_ipaddr(&dest_ipaddr);
+  } else
+#endif /* WITH_ORPL_MULTI_SINK */
   set_ipaddr_from_id(&dest_ipaddr, id);
   ORPL_LOG_FROM_APPDATAPTR(&data, "App: sending");
 
   orpl_set_curr_seqno(data.seqno);
-  set_ipaddr_from_id(&dest_ipaddr, id);
 
   simple_udp_sendto(&unicast_connection, &data, sizeof(data), &dest_ipaddr);
 
@@ -147,15 +156,12 @@ PROCESS_THREAD(unicast_sender_process, ev, data)
 
   deployment_init(&global_ipaddr);
 #if WITH_ORPL
-  orpl_init(node_id == ROOT_ID, 1);
+  orpl_init(is_sink_id(node_id), 1);
 #endif /* WITH_ORPL */
   simple_udp_register(&unicast_connection, UDP_PORT,
                       NULL, UDP_PORT, receiver);
 
-  if(node_id == ROOT_ID) {
-#if WITH_ORPL_LB_DIO_TARGET && WITH_ORPL_LB
-    dio_dc_objective=100;
-#endif
+  if(is_sink_id(node_id)) {
     NETSTACK_RDC.off(1);
   } else {
 
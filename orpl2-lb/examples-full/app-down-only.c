@@ -31,6 +31,9 @@
  * \file
  *         Example file using ORPL for a data dissemination: periodic
  *         unicasts from root to other nodes in a round-robin fashion.
+ *         With WITH_ORPL_RDGRAM, the unicasts are reliable datagrams and
+ *         nodes send collect reports to the root, periodically and after
+ *         each datagram received. The reports carry the ACKs.
  *         Enables logging as used in the ORPL SenSyS'13 paper.
  *         Can be deployed in the Indriya or Twist testbeds.
  *
@@ -41,6 +44,10 @@
 #include "lib/random.h"
 #include "orpl.h"
 #include "orpl-routing-set.h"
+#if WITH_ORPL_RDGRAM
+#include "orpl-rdgram.h"
+#include "net/rpl/rpl-private.h"
+#endif /* WITH_ORPL_RDGRAM */
 #include "deployment.h"
 #include "simple-energest.h"
 #include "simple-udp.h"
@@ -50,13 +57,48 @@
 #define SEND_INTERVAL   (4 * CLOCK_SECOND)
 #define UDP_PORT 1234
 #define TARGET_REACHABLE_RATIO 80
+#if WITH_ORPL_RDGRAM
+#define REPORT_INTERVAL (2 * 60 * CLOCK_SECOND)
+#endif /* WITH_ORPL_RDGRAM */
 
+#if WITH_ORPL_RDGRAM
+static struct orpl_rdgram_conn unicast_connection;
+#else /* WITH_ORPL_RDGRAM */
 static struct simple_udp_connection unicast_connection;
+#endif /* WITH_ORPL_RDGRAM */
 
 /*---------------------------------------------------------------------------*/
 PROCESS(unicast_sender_process, "ORPL -- Down-only Application");
 AUTOSTART_PROCESSES(&unicast_sender_process);
 /*---------------------------------------------------------------------------*/
+#if WITH_ORPL_RDGRAM
+static void
+receiver(struct orpl_rdgram_conn *c,
+         const uip_ipaddr_t *sender_addr,
+         const uint8_t *data,
+         uint16_t datalen)
+{
+  ORPL_LOG_FROM_APPDATAPTR((struct app_data *)data, "App: received");
+  if(node_id != ROOT_ID) {
+    /* Report back, out of the input callback */
+    process_poll(&unicast_sender_process);
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+sent(struct orpl_rdgram_conn *c,
+     const uip_ipaddr_t *dest_addr,
+     const uint8_t *data,
+     uint16_t datalen,
+     int status)
+{
+  if(status == ORPL_RDGRAM_ACKED) {
+    ORPL_LOG_FROM_APPDATAPTR((struct app_data *)data, "App: delivered");
+  } else {
+    ORPL_LOG_FROM_APPDATAPTR((struct app_data *)data, "App:! not delivered");
+  }
+}
+#else /* WITH_ORPL_RDGRAM */
 static void
 receiver(struct simple_udp_connection *c,
          const uip_ipaddr_t *sender_addr,
@@ -68,6 +110,7 @@ receiver(struct simple_udp_connection *c,
 {
   ORPL_LOG_FROM_APPDATAPTR((struct app_data *)data, "App: received");
 }
+#endif /* WITH_ORPL_RDGRAM */
 /*---------------------------------------------------------------------------*/
 void app_send_to(uint16_t id) {
 
@@ -81,13 +124,24 @@ void app_send_to(uint16_t id) {
   data.dest = id;
   data.hop = 0;
   data.fpcount = 0;
+  data.queue_delay = 0;
+  data.strobe_delay = 0;
 
   ORPL_LOG_FROM_APPDATAPTR(&data, "App: sending");
 
   orpl_set_curr_seqno(data.seqno);
   set_ipaddr_from_id(&dest_ipaddr, id);
 
+#if WITH_ORPL_RDGRAM
+  if(node_id == ROOT_ID) {
+    orpl_rdgram_sendto(&unicast_connection, &data, sizeof(data), &dest_ipaddr);
+  } else {
+    /* Reports are collect traffic, they carry the ACKs we owe the root */
+    orpl_rdgram_sendto_unreliable(&unicast_connection, &data, sizeof(data), &dest_ipaddr);
+  }
+#else /* WITH_ORPL_RDGRAM */
   simple_udp_sendto(&unicast_connection, &data, sizeof(data), &dest_ipaddr);
+#endif /* WITH_ORPL_RDGRAM */
 
   cnt++;
 }
@@ -138,8 +192,12 @@ PROCESS_THREAD(unicast_sender_process, ev, data)
 
   deployment_init(&global_ipaddr);
   orpl_init(node_id == ROOT_ID, 0);
+#if WITH_ORPL_RDGRAM
+  orpl_rdgram_register(&unicast_connection, UDP_PORT, receiver, sent);
+#else /* WITH_ORPL_RDGRAM */
   simple_udp_register(&unicast_connection, UDP_PORT,
                       NULL, UDP_PORT, receiver);
+#endif /* WITH_ORPL_RDGRAM */
 
   if(node_id == ROOT_ID) {
     NETSTACK_RDC.off(1);
@@ -165,6 +223,20 @@ PROCESS_THREAD(unicast_sender_process, ev, data)
       etimer_reset(&periodic_timer);
     }
   }
+#if WITH_ORPL_RDGRAM
+  else {
+    etimer_set(&periodic_timer, REPORT_INTERVAL);
+    while(1) {
+      PROCESS_WAIT_EVENT_UNTIL(ev == PROCESS_EVENT_POLL || etimer_expired(&periodic_timer));
+      if(etimer_expired(&periodic_timer)) {
+        etimer_reset(&periodic_timer);
+      }
+      if(default_instance != NULL) {
+        app_send_to(ROOT_ID);
+      }
+    }
+  }
+#endif /* WITH_ORPL_RDGRAM */
 
   PROCESS_END();
 }
@@ -331,6 +331,30 @@ lladdr_from_ipaddr_uuid(uip_lladdr_t *lladdr, const uip_ipaddr_t *ipaddr)
 }
 #endif
 
+/* List of sinks used for different deployments. Only the first N_SINKS
+ * are actually sinks. In Cooja, sinks 1 to 4 are at the corners of the
+ * multi-sink scenarios. */
+static const uint16_t sink_id_list[] = {
+#if IN_COOJA
+    ROOT_ID, 2, 3, 4
+#else
+    ROOT_ID
+#endif
+};
+
+/* Returns 1 if the node with the given id is a sink */
+int
+is_sink_id(uint16_t id)
+{
+  int i;
+  for(i = 0; i < N_SINKS && i < sizeof(sink_id_list) / sizeof(uint16_t); i++) {
+    if(sink_id_list[i] == id) {
+      return 1;
+    }
+  }
+  return 0;
+}
+
 /* Returns a node-id from a node's IPv6 address */
 uint16_t
 node_id_from_ipaddr(const uip_ipaddr_t *addr)
@@ -400,8 +424,17 @@ deployment_init(uip_ipaddr_t *ipaddr) {
   set_ipaddr_from_id(ipaddr, id);
   uip_ds6_addr_add(ipaddr, 0, ADDR_AUTOCONF);
 
-  if(node_id == ROOT_ID) {
+  if(is_sink_id(node_id)) {
+#if WITH_ORPL_MULTI_SINK
+    /* All sinks are roots of the same DODAG, identified by the
+     * virtual sink address */
+    uip_ipaddr_t sink_ipaddr;
+    memcpy(&sink_ipaddr, &prefix, 8);
+    orpl_set_sink_iid(&sink_ipaddr);
+    rpl_set_root(RPL_DEFAULT_INSTANCE, &sink_ipaddr);
+#else /* WITH_ORPL_MULTI_SINK */
     rpl_set_root(RPL_DEFAULT_INSTANCE, ipaddr);
+#endif /* WITH_ORPL_MULTI_SINK */
     dag = rpl_get_any_dag();
     rpl_set_prefix(dag, &prefix, 64);
   }
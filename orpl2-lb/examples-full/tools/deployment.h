@@ -62,6 +62,15 @@
 #define ROOT_ID 1
 #endif
 
+/* Number of sinks (DODAG roots) in use. Sinks are taken from the
+ * deployment's sink list, starting with ROOT_ID. All sinks share a
+ * virtual sink address (see WITH_ORPL_MULTI_SINK). */
+#ifdef DEPLOYMENT_CONF_N_SINKS
+#define N_SINKS DEPLOYMENT_CONF_N_SINKS
+#else /* DEPLOYMENT_CONF_N_SINKS */
+#define N_SINKS 1
+#endif /* DEPLOYMENT_CONF_N_SINKS */
+
 /* Returns the node's node-id */
 uint16_t get_n_nodes();
 /* Returns the total number of nodes in the deployment */
@@ -78,6 +87,8 @@ void set_ipaddr_from_rimeaddr(uip_ipaddr_t *ipaddr, const rimeaddr_t *lladdr);
 void set_ipaddr_from_id(uip_ipaddr_t *ipaddr, uint16_t id);
 /* Sets an rimeaddr from a link-layer address */
 void set_rimeaddr_from_id(rimeaddr_t *lladdr, uint16_t id);
+/* Returns 1 if the node with the given id is a sink */
+int is_sink_id(uint16_t id);
 /* Initializes global IPv6 and creates DODAG */
 void deployment_init(uip_ipaddr_t *ipaddr);
 
@@ -98,6 +98,21 @@ appdataptr_from_packetbuf()
   }
 }
 
+/* Add the delay spent at this hop to the packet currently in packetbuf.
+ * The packet may not be aligned, hence the copies. */
+void
+appdata_add_delay_from_packetbuf(uint16_t queue_delay, uint16_t strobe_delay)
+{
+  struct app_data data;
+  struct app_data *dataptr = appdataptr_from_packetbuf();
+  if(dataptr) {
+    appdata_copy(&data, dataptr);
+    data.queue_delay += queue_delay;
+    data.strobe_delay += strobe_delay;
+    appdata_copy(dataptr, &data);
+  }
+}
+
 /* Log information about a data packet along with ORPL routing information */
 void
 log_appdataptr(struct app_data *dataptr)
@@ -109,12 +124,14 @@ log_appdataptr(struct app_data *dataptr)
   if(dataptr) {
     appdata_init(&data, dataptr);
 
-    ORPL_LOG(" [%lx %u_%u %u->%u]",
+    ORPL_LOG(" [%lx %u_%u %u->%u %u+%u]",
         data.seqno,
         data.hop,
         data.fpcount,
         data.src,
-        data.dest
+        data.dest,
+        data.queue_delay,
+        data.strobe_delay
         );
   }
 
@@ -51,6 +51,10 @@ struct app_data {
   uint8_t ping;
   uint8_t fpcount;
   uint16_t dc_metric;
+  /* Delay trace, cumulated over all hops, in ms: time spent in
+   * CSMA queues, and time spent strobing */
+  uint16_t queue_delay;
+  uint16_t strobe_delay;
 };
 
 /* Copy an appdata to another with no assumption that the addresses are aligned */
@@ -61,6 +65,8 @@ struct app_data *appdataptr_from_uip();
 struct app_data *appdataptr_from_packetbuf();
 /* Log information about a data packet along with ORPL routing information */
 void log_appdataptr(struct app_data *dataptr);
+/* Add the delay spent at this hop to the packet currently in packetbuf */
+void appdata_add_delay_from_packetbuf(uint16_t queue_delay, uint16_t strobe_delay);
 /* Return node id from its rime address */
 uint16_t log_node_id_from_rimeaddr(const void *rimeaddr);
 /* Return node id from its IP address */
@@ -79,6 +85,7 @@ void orpl_log_start();
 #define ORPL_LOG_LLADDR(addr) uip_debug_lladdr_print(addr)
 #define ORPL_LOG_INC_HOPCOUNT_FROM_PACKETBUF() { appdataptr_from_packetbuf()->hop++; }
 #define ORPL_LOG_INC_FPCOUNT_FROM_PACKETBUF() { appdataptr_from_packetbuf()->fpcount++; }
+#define ORPL_LOG_ADD_DELAY_FROM_PACKETBUF(queue, strobe) appdata_add_delay_from_packetbuf(queue, strobe)
 
 #define ORPL_LOG_NODEID_FROM_RIMEADDR log_node_id_from_rimeaddr
 #define ORPL_LOG_NODEID_FROM_IPADDR log_node_id_from_ipaddr
@@ -57,10 +57,18 @@ extern uint8_t queuebuf_len;
 #else
 #define CSMA_ADVANCED 1
 #endif
+#if QUEUEBUF_CONF_MMEM && QUEUEBUF_CONF_STATS
+/* Queue statistics from queuebuf.c */
+extern uint8_t queuebuf_len, queuebuf_len_max;
+extern uint16_t queuebuf_mem_used, queuebuf_mem_max, queuebuf_mem_fails;
+#endif /* QUEUEBUF_CONF_MMEM && QUEUEBUF_CONF_STATS */
 #if WITH_ORPL
 #include "net/uip.h"
 #include "orpl.h"
 #include "orpl-anycast.h"
+#if WITH_ORPL_DTN
+#include "orpl-dtn.h"
+#endif /* WITH_ORPL_DTN */
 #define UIP_IP_BUF ((struct uip_ip_hdr *)&uip_buf[UIP_LLH_LEN])
 #endif /* WITH_ORPL */
 
@@ -197,6 +205,88 @@ free_packet(struct neighbor_queue *n, struct rdc_buf_list *p)
   }
 }
 /*---------------------------------------------------------------------------*/
+#if WITH_ORPL_TRAFFIC_CLASS
+/* Account for an anycast the queue is done with, per traffic class */
+static void
+class_done(struct rdc_buf_list *q, int delivered)
+{
+  if(queuebuf_attr(q->buf, PACKETBUF_ATTR_ORPL_DIRECTION) != direction_none) {
+    orpl_anycast_class_done(queuebuf_attr(q->buf, PACKETBUF_ATTR_ORPL_CLASS), delivered,
+#if WITH_ORPL_DELAY_TRACE
+        clock_time() - (clock_time_t)queuebuf_attr(q->buf, PACKETBUF_ATTR_ORPL_ENQUEUE_TIME)
+#else /* WITH_ORPL_DELAY_TRACE */
+        0
+#endif /* WITH_ORPL_DELAY_TRACE */
+        );
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* Callbacks of the packets dropped for urgent ones. They are called from
+ * a ctimer rather than from within send_packet, so that the upper layer
+ * doesn't re-enter csma. */
+static struct {
+  mac_callback_t sent;
+  void *cptr;
+} dropped[MAX_QUEUED_PACKETS];
+static uint8_t dropped_count;
+static struct ctimer dropped_timer;
+/*---------------------------------------------------------------------------*/
+static void
+report_dropped(void *ptr)
+{
+  while(dropped_count > 0) {
+    dropped_count--;
+    mac_call_sent_callback(dropped[dropped_count].sent,
+        dropped[dropped_count].cptr, MAC_TX_ERR, 0);
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* Drop the last normal packet found in the queues to make room for an
+ * urgent one. Heads of queues are kept, as they may be in the middle of
+ * their transmissions. Returns 1 if a packet was dropped. */
+static int
+drop_normal_packet(void)
+{
+  struct neighbor_queue *n;
+  struct neighbor_queue *victim_n = NULL;
+  struct rdc_buf_list *q;
+  struct rdc_buf_list *victim = NULL;
+  struct qbuf_metadata *metadata;
+
+  if(dropped_count == MAX_QUEUED_PACKETS) {
+    return 0;
+  }
+
+  for(n = list_head(neighbor_list); n != NULL; n = list_item_next(n)) {
+    for(q = list_item_next(list_head(n->queued_packet_list));
+        q != NULL; q = list_item_next(q)) {
+      if(queuebuf_attr(q->buf, PACKETBUF_ATTR_ORPL_CLASS) != ORPL_CLASS_URGENT) {
+        victim_n = n;
+        victim = q;
+      }
+    }
+  }
+
+  if(victim == NULL) {
+    return 0;
+  }
+
+  ORPL_LOG("Csma:! dropping %u for urgent\n", ORPL_LOG_NODEID_FROM_RIMEADDR(&victim_n->addr));
+  class_done(victim, 0);
+  metadata = (struct qbuf_metadata *)victim->ptr;
+  list_remove(victim_n->queued_packet_list, victim);
+  queuebuf_free(victim->buf);
+  memb_free(&packet_memb, victim);
+  /* Not the head of its queue: the neighbor entry and its timer are left as is */
+  dropped[dropped_count].sent = metadata->sent;
+  dropped[dropped_count].cptr = metadata->cptr;
+  dropped_count++;
+  ctimer_set(&dropped_timer, 0, report_dropped, NULL);
+  memb_free(&metadata_memb, metadata);
+  return 1;
+}
+#endif /* WITH_ORPL_TRAFFIC_CLASS */
+/*---------------------------------------------------------------------------*/
 static void
 packet_sent(void *ptr, int status, int num_transmissions)
 {
@@ -331,11 +421,26 @@ packet_sent(void *ptr, int status, int num_transmissions)
         		NETSTACK_MAC.send(sent, cptr);
 #endif
         	} else {
+#if WITH_ORPL_DTN
+        	  /* Park the packet in flash rather than dropping it */
+        	  if(orpl_dtn_park(q->buf)) {
+#if WITH_ORPL_TRAFFIC_CLASS
+        	    /* The queue is done with it, even if the DTN store sends it later */
+        	    class_done(q, 0);
+#endif /* WITH_ORPL_TRAFFIC_CLASS */
+        	    free_packet(n, q);
+        	    mac_call_sent_callback(sent, cptr, status, num_tx);
+        	    return;
+        	  }
+#endif /* WITH_ORPL_DTN */
         	  ORPL_LOG_FROM_PACKETBUF("Csma:! dropping %u after %d tx, %d collisions",
         	      ORPL_LOG_NODEID_FROM_RIMEADDR(&n->addr) , n->transmissions, n->collisions);
         	  PRINTF("csma: drop with status %d after %d transmissions, %d collisions\n",
         	      status, n->transmissions, n->collisions);
             //packetbuf_set_attr(PACKETBUF_ATTR_EDC, 0xffff);//MF-BUG
+#if WITH_ORPL_TRAFFIC_CLASS
+        	  class_done(q, 0);
+#endif /* WITH_ORPL_TRAFFIC_CLASS */
         	  free_packet(n, q);
         	  mac_call_sent_callback(sent, cptr, status, num_tx);
         	}
@@ -355,6 +460,9 @@ packet_sent(void *ptr, int status, int num_transmissions)
                                  &rimeaddr_null)) {
             ORPL_LOG_FROM_PACKETBUF("Csma: success %u after %d tx, %d collisions",
                 ORPL_LOG_NODEID_FROM_RIMEADDR(packetbuf_addr(PACKETBUF_ADDR_RECEIVER)), n->transmissions, n->collisions);
+#if WITH_ORPL_DTN
+            orpl_dtn_link_up();
+#endif /* WITH_ORPL_DTN */
           }
 #endif /* WITH_ORPL */
           PRINTF("csma: rexmit ok %u after %d tx, %d collisions\n",packetbuf_addr(PACKETBUF_ADDR_RECEIVER), n->transmissions, n->collisions);
@@ -364,6 +472,9 @@ packet_sent(void *ptr, int status, int num_transmissions)
 #endif /* WITH_ORPL */
           PRINTF("csma: rexmit failed %d: %d\n", n->transmissions, status);
         }
+#if WITH_ORPL_TRAFFIC_CLASS
+        class_done(q, status == MAC_TX_OK);
+#endif /* WITH_ORPL_TRAFFIC_CLASS */
         free_packet(n, q);
         mac_call_sent_callback(sent, cptr, status, num_tx);
       }
@@ -377,6 +488,9 @@ send_packet(mac_callback_t sent, void *ptr)
   struct rdc_buf_list *q;
   struct neighbor_queue *n;
   static uint16_t seqno;
+#if WITH_ORPL_TRAFFIC_CLASS
+  int is_urgent = packetbuf_attr(PACKETBUF_ATTR_ORPL_CLASS) == ORPL_CLASS_URGENT;
+#endif /* WITH_ORPL_TRAFFIC_CLASS */
 #if WITH_ORPL_LOADCTRL
   ORPL_LOG("Queue : %u\n",queuebuf_len);
 #endif
@@ -384,6 +498,14 @@ send_packet(mac_callback_t sent, void *ptr)
     /* Using packetbuf address would lead to a single queue for all anycasts.
        * We use the IPv6 UUID to have one queue per destination instead. */
     const rimeaddr_t *addr = (const rimeaddr_t *)(((uint8_t*)&UIP_IP_BUF->destipaddr)+8);
+#if WITH_ORPL_ROUTING_DESC
+    /* Fast-forwarded packets never go through uip_buf. When there is a
+     * routing descriptor, take the IID from it. */
+    if(packetbuf_datalen() >= ORPL_DESC_LEN
+        && ORPL_DESC_IS_DISPATCH(((uint8_t *)packetbuf_dataptr())[0])) {
+      addr = (const rimeaddr_t *)((uint8_t *)packetbuf_dataptr() + 1);
+    }
+#endif /* WITH_ORPL_ROUTING_DESC */
 
     /* Set PACKETBUF_ATTR_ROUTING_SET for outgoing routing set broadcast,
      * so that the proper ORPL callback function can be called after transmission. */
@@ -437,10 +559,26 @@ send_packet(mac_callback_t sent, void *ptr)
   if(n != NULL) {
     /* Add packet to the neighbor's queue */
     q = memb_alloc(&packet_memb);
+#if WITH_ORPL_TRAFFIC_CLASS
+    if(q == NULL && is_urgent && drop_normal_packet()) {
+      q = memb_alloc(&packet_memb);
+    }
+#endif /* WITH_ORPL_TRAFFIC_CLASS */
     if(q != NULL) {
       q->ptr = memb_alloc(&metadata_memb);
       if(q->ptr != NULL) {
+#if WITH_ORPL_DELAY_TRACE
+	/* Time of entry in the queue, and strobing time so far, used
+	 * to trace the delay spent at this hop */
+	packetbuf_set_attr(PACKETBUF_ATTR_ORPL_ENQUEUE_TIME, clock_time());
+	packetbuf_set_attr(PACKETBUF_ATTR_ORPL_STROBE_TIME, 0);
+#endif /* WITH_ORPL_DELAY_TRACE */
 	q->buf = queuebuf_new_from_packetbuf();
+#if WITH_ORPL_TRAFFIC_CLASS
+	if(q->buf == NULL && is_urgent && drop_normal_packet()) {
+	  q->buf = queuebuf_new_from_packetbuf();
+	}
+#endif /* WITH_ORPL_TRAFFIC_CLASS */
 	if(q->buf != NULL) {
 	  struct qbuf_metadata *metadata = (struct qbuf_metadata *)q->ptr;
 	  /* Neighbor and packet successfully allocated */
@@ -457,6 +595,15 @@ send_packet(mac_callback_t sent, void *ptr)
 	  if(packetbuf_attr(PACKETBUF_ATTR_PACKET_TYPE) ==
 	     PACKETBUF_ATTR_PACKET_TYPE_ACK) {
 	    list_push(n->queued_packet_list, q);
+#if WITH_ORPL_TRAFFIC_CLASS
+	  } else if(is_urgent) {
+	    /* Urgent packets jump ahead of the normal ones. The preempted
+	     * head starts over with a fresh transmission count. */
+	    list_push(n->queued_packet_list, q);
+	    n->transmissions = 0;
+	    n->collisions = 0;
+	    n->deferrals = 0;
+#endif /* WITH_ORPL_TRAFFIC_CLASS */
 	  } else {
 	    list_add(n->queued_packet_list, q);
 	  }
@@ -481,6 +628,11 @@ send_packet(mac_callback_t sent, void *ptr)
     PRINTF("csma: could not allocate packet, dropping packet\n");
 #if WITH_ORPL
     ORPL_LOG_FROM_PACKETBUF("Csma:! couldn't allocate packet");
+#if QUEUEBUF_CONF_MMEM && QUEUEBUF_CONF_STATS
+    ORPL_LOG("Csma: queue %u pkts (max %u), %u bytes (max %u), %u fails\n",
+        queuebuf_len, queuebuf_len_max, queuebuf_mem_used, queuebuf_mem_max,
+        queuebuf_mem_fails);
+#endif /* QUEUEBUF_CONF_MMEM && QUEUEBUF_CONF_STATS */
    //ORPL_LOG_FROM_PACKETBUF("Csma:! couldn't allocate packet");
 #endif /* WITH_ORPL */
   } else {
@@ -354,6 +354,19 @@ enum {
   PACKETBUF_ATTR_ORPL_DIRECTION,
   PACKETBUF_ATTR_ROUTING_SET,
   PACKETBUF_ATTR_ACKED,
+#if WITH_ORPL_RADIO_STATS
+  PACKETBUF_ATTR_ORPL_FORWARDED,
+#endif /* WITH_ORPL_RADIO_STATS */
+#if WITH_ORPL_DELAY_TRACE
+  PACKETBUF_ATTR_ORPL_ENQUEUE_TIME,
+  PACKETBUF_ATTR_ORPL_STROBE_TIME,
+#endif /* WITH_ORPL_DELAY_TRACE */
+#if WITH_ORPL_PATH_HINT
+  PACKETBUF_ATTR_ORPL_HINT,
+#endif /* WITH_ORPL_PATH_HINT */
+#if WITH_ORPL_TRAFFIC_CLASS
+  PACKETBUF_ATTR_ORPL_CLASS,
+#endif /* WITH_ORPL_TRAFFIC_CLASS */
 #endif /* WITH_ORPL */
 
   /* Scope 1 attributes: used between two neighbors only. */
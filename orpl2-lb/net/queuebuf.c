@@ -47,6 +47,19 @@
 #include "cfs/cfs.h"
 #endif
 
+#ifdef QUEUEBUF_CONF_MMEM
+#define QUEUEBUF_MMEM QUEUEBUF_CONF_MMEM
+#else
+#define QUEUEBUF_MMEM 0
+#endif
+
+#if QUEUEBUF_MMEM
+#if WITH_SWAP
+#error queuebuf: QUEUEBUF_CONF_MMEM is not supported with WITH_SWAP
+#endif
+#include "lib/mmem.h"
+#endif /* QUEUEBUF_MMEM */
+
 #include <string.h> /* for memcpy() */
 
 #ifdef QUEUEBUF_CONF_REF_NUM
@@ -68,13 +81,37 @@ struct queuebuf {
   enum {IN_RAM, IN_CFS} location;
   union {
 #endif
+#if QUEUEBUF_MMEM
+    struct mmem mem;
+#else /* QUEUEBUF_MMEM */
     struct queuebuf_data *ram_ptr;
+#endif /* QUEUEBUF_MMEM */
 #if WITH_SWAP
     int swap_id;
   };
 #endif
 };
 
+#if QUEUEBUF_MMEM
+/* With QUEUEBUF_CONF_MMEM, the queuebuf data is stored in a managed
+   memory block of variable size, holding only the actual packet and
+   the attributes and addresses that are set, as follows:
+   - a struct queuebuf_mmem_hdr
+   - the packet, len bytes
+   - nattrs attributes, stored as 3 bytes: type, value (big-endian)
+   - naddrs addresses, stored as the type followed by the address
+   As mmem compacts its memory on every free, there is no external
+   fragmentation. Pointers returned by queuebuf_dataptr() and
+   queuebuf_addr() are only valid until the next queuebuf_free(). */
+struct queuebuf_mmem_hdr {
+  uint8_t len;
+  uint8_t nattrs;
+  uint8_t naddrs;
+};
+#define MMEM_ATTR_SIZE 3
+#define MMEM_ADDR_SIZE (1 + sizeof(rimeaddr_t))
+#endif /* QUEUEBUF_MMEM */
+
 /* The actual queuebuf data */
 struct queuebuf_data {
   uint16_t len;
@@ -92,7 +129,9 @@ struct queuebuf_ref {
 
 MEMB(bufmem, struct queuebuf, QUEUEBUF_NUM);
 MEMB(refbufmem, struct queuebuf_ref, QUEUEBUF_REF_NUM);
+#if !QUEUEBUF_MMEM
 MEMB(buframmem, struct queuebuf_data, QUEUEBUFRAM_NUM);
+#endif /* !QUEUEBUF_MMEM */
 
 #if WITH_SWAP
 
@@ -145,6 +184,13 @@ LIST(queuebuf_list);
 
 #if QUEUEBUF_STATS
 uint8_t queuebuf_len, queuebuf_ref_len, queuebuf_max_len;
+#if QUEUEBUF_MMEM
+/* Managed memory statistics: bytes currently used, high-water marks
+   in bytes and in packets, and failed allocations */
+uint16_t queuebuf_mem_used, queuebuf_mem_max;
+uint8_t queuebuf_len_max;
+uint16_t queuebuf_mem_fails;
+#endif /* QUEUEBUF_MMEM */
 #endif /* QUEUEBUF_STATS */
 
 #if WITH_SWAP
@@ -280,6 +326,95 @@ queuebuf_load_to_ram(struct queuebuf *b)
     }
   }
 }
+#elif QUEUEBUF_MMEM
+/*---------------------------------------------------------------------------*/
+/* Returns the size of the managed memory block needed to store the
+   packetbuf, and counts the attributes and addresses that are set */
+static uint16_t
+mmem_size_from_packetbuf(uint16_t len, uint8_t *nattrs, uint8_t *naddrs)
+{
+  int i;
+  *nattrs = 0;
+  *naddrs = 0;
+  for(i = 0; i < PACKETBUF_NUM_ATTRS; i++) {
+    if(packetbuf_attr(i) != 0) {
+      (*nattrs)++;
+    }
+  }
+  for(i = 0; i < PACKETBUF_NUM_ADDRS; i++) {
+    if(!rimeaddr_cmp(packetbuf_addr(PACKETBUF_ADDR_FIRST + i), &rimeaddr_null)) {
+      (*naddrs)++;
+    }
+  }
+  return sizeof(struct queuebuf_mmem_hdr) + len
+    + *nattrs * MMEM_ATTR_SIZE + *naddrs * MMEM_ADDR_SIZE;
+}
+/*---------------------------------------------------------------------------*/
+/* Returns a pointer to the attributes stored after the packet */
+static uint8_t *
+mmem_attrs_ptr(struct queuebuf_mmem_hdr *hdr)
+{
+  return (uint8_t *)hdr + sizeof(struct queuebuf_mmem_hdr) + hdr->len;
+}
+/*---------------------------------------------------------------------------*/
+/* Stores the packetbuf attributes and addresses that are set */
+static void
+mmem_write_attrs(struct queuebuf_mmem_hdr *hdr, uint8_t nattrs, uint8_t naddrs)
+{
+  int i;
+  uint8_t *ptr = mmem_attrs_ptr(hdr);
+  hdr->nattrs = nattrs;
+  hdr->naddrs = naddrs;
+  for(i = 0; i < PACKETBUF_NUM_ATTRS; i++) {
+    packetbuf_attr_t val = packetbuf_attr(i);
+    if(val != 0) {
+      ptr[0] = i;
+      ptr[1] = val >> 8;
+      ptr[2] = val & 0xff;
+      ptr += MMEM_ATTR_SIZE;
+    }
+  }
+  for(i = 0; i < PACKETBUF_NUM_ADDRS; i++) {
+    const rimeaddr_t *addr = packetbuf_addr(PACKETBUF_ADDR_FIRST + i);
+    if(!rimeaddr_cmp(addr, &rimeaddr_null)) {
+      ptr[0] = PACKETBUF_ADDR_FIRST + i;
+      rimeaddr_copy((rimeaddr_t *)(ptr + 1), addr);
+      ptr += MMEM_ADDR_SIZE;
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* Looks up a stored attribute or address. Returns a pointer to its
+   value, or NULL if it was not set. */
+static uint8_t *
+mmem_find_attr(struct queuebuf *b, uint8_t type)
+{
+  struct queuebuf_mmem_hdr *hdr = (struct queuebuf_mmem_hdr *)MMEM_PTR(&b->mem);
+  uint8_t *ptr = mmem_attrs_ptr(hdr);
+  int i;
+  for(i = 0; i < hdr->nattrs; i++, ptr += MMEM_ATTR_SIZE) {
+    if(ptr[0] == type) {
+      return ptr + 1;
+    }
+  }
+  for(i = 0; i < hdr->naddrs; i++, ptr += MMEM_ADDR_SIZE) {
+    if(ptr[0] == type) {
+      return ptr + 1;
+    }
+  }
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+#if QUEUEBUF_STATS
+static void
+mmem_stats_add(int16_t size)
+{
+  queuebuf_mem_used += size;
+  if(queuebuf_mem_used > queuebuf_mem_max) {
+    queuebuf_mem_max = queuebuf_mem_used;
+  }
+}
+#endif /* QUEUEBUF_STATS */
 #else /* WITH_SWAP */
 /*---------------------------------------------------------------------------*/
 static struct queuebuf_data *
@@ -299,7 +434,11 @@ queuebuf_init(void)
     qbuf_renew_file(i);
   }
 #endif
+#if QUEUEBUF_MMEM
+  mmem_init();
+#else /* QUEUEBUF_MMEM */
   memb_init(&buframmem);
+#endif /* QUEUEBUF_MMEM */
   memb_init(&bufmem);
   memb_init(&refbufmem);
 #if QUEUEBUF_STATS
@@ -332,7 +471,9 @@ queuebuf_new_from_packetbuf(void)
     }
     return (struct queuebuf *)rbuf;
   } else {
+#if !QUEUEBUF_MMEM
     struct queuebuf_data *buframptr;
+#endif /* !QUEUEBUF_MMEM */
     buf = memb_alloc(&bufmem);
     if(buf != NULL) {
 #if QUEUEBUF_DEBUG
@@ -341,6 +482,31 @@ queuebuf_new_from_packetbuf(void)
       buf->line = line;
       buf->time = clock_time();
 #endif /* QUEUEBUF_DEBUG */
+#if QUEUEBUF_MMEM
+      {
+        uint8_t nattrs, naddrs;
+        uint16_t size = mmem_size_from_packetbuf(packetbuf_totlen(), &nattrs, &naddrs);
+        struct queuebuf_mmem_hdr *hdr;
+
+        if(mmem_alloc(&buf->mem, size) == 0) {
+          PRINTF("queuebuf_new_from_packetbuf: could not allocate %u bytes\n", size);
+#if QUEUEBUF_STATS
+          queuebuf_mem_fails++;
+#endif /* QUEUEBUF_STATS */
+#if QUEUEBUF_DEBUG
+          list_remove(queuebuf_list, buf);
+#endif /* QUEUEBUF_DEBUG */
+          memb_free(&bufmem, buf);
+          return NULL;
+        }
+        hdr = (struct queuebuf_mmem_hdr *)MMEM_PTR(&buf->mem);
+        hdr->len = packetbuf_copyto((uint8_t *)hdr + sizeof(struct queuebuf_mmem_hdr));
+        mmem_write_attrs(hdr, nattrs, naddrs);
+#if QUEUEBUF_STATS
+        mmem_stats_add(size);
+#endif /* QUEUEBUF_STATS */
+      }
+#else /* QUEUEBUF_MMEM */
       buf->ram_ptr = memb_alloc(&buframmem);
 #if WITH_SWAP
       /* If the allocation failed, store the qbuf in swap files */
@@ -363,6 +529,7 @@ queuebuf_new_from_packetbuf(void)
 
       buframptr->len = packetbuf_copyto(buframptr->data);
       packetbuf_attr_copyto(buframptr->attrs, buframptr->addrs);
+#endif /* QUEUEBUF_MMEM */
 
 #if WITH_SWAP
       if(buf->location == IN_CFS) {
@@ -379,10 +546,19 @@ queuebuf_new_from_packetbuf(void)
       //PRINTF("queuebuf len %d\n", queuebuf_len);
       //printf("#A q=%d\n", queuebuf_len);
       if(queuebuf_len == queuebuf_max_len + 1) {
+#if QUEUEBUF_MMEM
+  mmem_stats_add(-(int16_t)buf->mem.size);
+  mmem_free(&buf->mem);
+#endif /* QUEUEBUF_MMEM */
   memb_free(&bufmem, buf);
   queuebuf_len--;
   return NULL;
       }
+#if QUEUEBUF_MMEM
+      if(queuebuf_len > queuebuf_len_max) {
+        queuebuf_len_max = queuebuf_len;
+      }
+#endif /* QUEUEBUF_MMEM */
 #endif /* QUEUEBUF_STATS */
 
     } else {
@@ -395,6 +571,44 @@ queuebuf_new_from_packetbuf(void)
 void
 queuebuf_update_attr_from_packetbuf(struct queuebuf *buf)
 {
+#if QUEUEBUF_MMEM
+  uint8_t nattrs, naddrs;
+  struct queuebuf_mmem_hdr *hdr = (struct queuebuf_mmem_hdr *)MMEM_PTR(&buf->mem);
+  uint16_t size = mmem_size_from_packetbuf(hdr->len, &nattrs, &naddrs);
+
+  if(size > buf->mem.size) {
+    /* The block needs to grow. mmem has no realloc: save the block to
+       a temporary one, then move it to a new, larger block for this
+       queuebuf. Each free compacts the memory. */
+    struct mmem tmp;
+    uint16_t old_size = buf->mem.size;
+    int ok = 0;
+    if(mmem_alloc(&tmp, old_size)) {
+      memcpy(MMEM_PTR(&tmp), MMEM_PTR(&buf->mem), old_size);
+      mmem_free(&buf->mem);
+      ok = mmem_alloc(&buf->mem, size);
+      if(!ok) {
+        /* Restore the original block, we just freed enough for it */
+        mmem_alloc(&buf->mem, old_size);
+      }
+      memcpy(MMEM_PTR(&buf->mem), MMEM_PTR(&tmp), old_size);
+      mmem_free(&tmp);
+    }
+    if(!ok) {
+      PRINTF("queuebuf_update_attr_from_packetbuf: could not allocate %u bytes\n", size);
+#if QUEUEBUF_STATS
+      queuebuf_mem_fails++;
+#endif /* QUEUEBUF_STATS */
+      return;
+    }
+#if QUEUEBUF_STATS
+    mmem_stats_add(size - old_size);
+#endif /* QUEUEBUF_STATS */
+    hdr = (struct queuebuf_mmem_hdr *)MMEM_PTR(&buf->mem);
+  }
+  /* Smaller attribute sets are written in place */
+  mmem_write_attrs(hdr, nattrs, naddrs);
+#else /* QUEUEBUF_MMEM */
   struct queuebuf_data *buframptr = queuebuf_load_to_ram(buf);
   packetbuf_attr_copyto(buframptr->attrs, buframptr->addrs);
 #if WITH_SWAP
@@ -402,6 +616,7 @@ queuebuf_update_attr_from_packetbuf(struct queuebuf *buf)
     queuebuf_flush_tmpdata();
   }
 #endif
+#endif /* QUEUEBUF_MMEM */
 }
 /*---------------------------------------------------------------------------*/
 void
@@ -414,6 +629,11 @@ queuebuf_free(struct queuebuf *buf)
     } else {
       queuebuf_remove_from_file(buf->swap_id);
     }
+#elif QUEUEBUF_MMEM
+#if QUEUEBUF_STATS
+    mmem_stats_add(-(int16_t)buf->mem.size);
+#endif /* QUEUEBUF_STATS */
+    mmem_free(&buf->mem);
 #else
     memb_free(&buframmem, buf->ram_ptr);
 #endif
@@ -438,9 +658,23 @@ queuebuf_to_packetbuf(struct queuebuf *b)
 {
   struct queuebuf_ref *r;
   if(memb_inmemb(&bufmem, b)) {
+#if QUEUEBUF_MMEM
+    struct queuebuf_mmem_hdr *hdr = (struct queuebuf_mmem_hdr *)MMEM_PTR(&b->mem);
+    uint8_t *ptr = mmem_attrs_ptr(hdr);
+    int i;
+    packetbuf_copyfrom((uint8_t *)hdr + sizeof(struct queuebuf_mmem_hdr), hdr->len);
+    packetbuf_attr_clear();
+    for(i = 0; i < hdr->nattrs; i++, ptr += MMEM_ATTR_SIZE) {
+      packetbuf_set_attr(ptr[0], ((packetbuf_attr_t)ptr[1] << 8) | ptr[2]);
+    }
+    for(i = 0; i < hdr->naddrs; i++, ptr += MMEM_ADDR_SIZE) {
+      packetbuf_set_addr(ptr[0], (rimeaddr_t *)(ptr + 1));
+    }
+#else /* QUEUEBUF_MMEM */
     struct queuebuf_data *buframptr = queuebuf_load_to_ram(b);
     packetbuf_copyfrom(buframptr->data, buframptr->len);
     packetbuf_attr_copyfrom(buframptr->attrs, buframptr->addrs);
+#endif /* QUEUEBUF_MMEM */
   } else if(memb_inmemb(&refbufmem, b)) {
     r = (struct queuebuf_ref *)b;
     packetbuf_clear();
@@ -456,8 +690,12 @@ queuebuf_dataptr(struct queuebuf *b)
   struct queuebuf_ref *r;
 
   if(memb_inmemb(&bufmem, b)) {
+#if QUEUEBUF_MMEM
+    return (uint8_t *)MMEM_PTR(&b->mem) + sizeof(struct queuebuf_mmem_hdr);
+#else /* QUEUEBUF_MMEM */
     struct queuebuf_data *buframptr = queuebuf_load_to_ram(b);
     return buframptr->data;
+#endif /* QUEUEBUF_MMEM */
   } else if(memb_inmemb(&refbufmem, b)) {
     r = (struct queuebuf_ref *)b;
     return r->ref;
@@ -468,22 +706,36 @@ queuebuf_dataptr(struct queuebuf *b)
 int
 queuebuf_datalen(struct queuebuf *b)
 {
+#if QUEUEBUF_MMEM
+  return ((struct queuebuf_mmem_hdr *)MMEM_PTR(&b->mem))->len;
+#else /* QUEUEBUF_MMEM */
   struct queuebuf_data *buframptr = queuebuf_load_to_ram(b);
   return buframptr->len;
+#endif /* QUEUEBUF_MMEM */
 }
 /*---------------------------------------------------------------------------*/
 rimeaddr_t *
 queuebuf_addr(struct queuebuf *b, uint8_t type)
 {
+#if QUEUEBUF_MMEM
+  rimeaddr_t *addr = (rimeaddr_t *)mmem_find_attr(b, type);
+  return addr != NULL ? addr : (rimeaddr_t *)&rimeaddr_null;
+#else /* QUEUEBUF_MMEM */
   struct queuebuf_data *buframptr = queuebuf_load_to_ram(b);
   return &buframptr->addrs[type - PACKETBUF_ADDR_FIRST].addr;
+#endif /* QUEUEBUF_MMEM */
 }
 /*---------------------------------------------------------------------------*/
 packetbuf_attr_t
 queuebuf_attr(struct queuebuf *b, uint8_t type)
 {
+#if QUEUEBUF_MMEM
+  uint8_t *val = mmem_find_attr(b, type);
+  return val != NULL ? ((packetbuf_attr_t)val[0] << 8) | val[1] : 0;
+#else /* QUEUEBUF_MMEM */
   struct queuebuf_data *buframptr = queuebuf_load_to_ram(b);
   return buframptr->attrs[type].val;
+#endif /* QUEUEBUF_MMEM */
 }
 /*---------------------------------------------------------------------------*/
 void
@@ -576,13 +576,28 @@ rpl_add_parent(rpl_dag_t *dag, rpl_dio_t *dio, uip_ipaddr_t *addr)
   if(lladdr != NULL) {
     /* Add parent in rpl_parents */
     p = nbr_table_add_lladdr(rpl_parents, (rimeaddr_t *)lladdr);
+    if(p == NULL) {
+      PRINTF("RPL: rpl_add_parent p NULL\n");
+      return NULL;
+    }
     p->dag = dag;
     p->rank = dio->rank;
     p->dtsn = dio->dtsn;
     p->link_metric = RPL_INIT_LINK_METRIC * RPL_DAG_MC_ETX_DIVISOR;
 #if WITH_ORPL
-    p->bc_ackcount = 0;
+    p->bc_history = 0;
+    p->bc_samples = 0;
+    p->bc_acked = 0;
 #endif /* WITH_ORPL */
+#if WITH_ORPL_BOOTSTRAP
+    orpl_bootstrap_link_prior(p);
+#endif /* WITH_ORPL_BOOTSTRAP */
+#if WITH_ORPL_ENERGY
+    p->energy = 255; /* Assume full until advertised otherwise */
+#endif /* WITH_ORPL_ENERGY */
+#if WITH_ORPL_MULTI_SINK
+    p->sink = 0; /* Unknown until advertised (ORPL_SINK_NONE) */
+#endif /* WITH_ORPL_MULTI_SINK */
 #if RPL_DAG_MC != RPL_DAG_MC_NONE
     memcpy(&p->mc, &dio->mc, sizeof(p->mc));
 #endif /* RPL_DAG_MC != RPL_DAG_MC_NONE */
@@ -1281,11 +1296,7 @@ rpl_process_dio(uip_ipaddr_t *from, rpl_dio_t *dio)
    * whether to keep it in the set.
    */
 #if WITH_ORPL_LB_DIO_TARGET && WITH_ORPL_LB
-    if(!orpl_is_root() && (dio->dc_target_sn > dio_dc_obj_sn) && dio_dc_objective != dio->dc_target && dio->dc_target != 0){
-      dio_dc_objective=dio->dc_target;
-      dio_dc_obj_sn=dio->dc_target_sn;
-      //printf("ORPL_LB: dc_target %u\n",dio_dc_objective);
-    }
+    orpl_dc_objective_dio_input(dio->dc_target_sn, dio->dc_target);
 #endif
 
   p = rpl_find_parent(dag, from);
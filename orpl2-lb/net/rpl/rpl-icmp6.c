@@ -58,6 +58,9 @@
 #if WITH_ORPL_LB
 #include "orpl.h"
 #endif
+#if WITH_ORPL_NBR_POLICY
+#include "orpl-nbr-policy.h"
+#endif /* WITH_ORPL_NBR_POLICY */
 #include "net/uip-debug.h"
 
 #if UIP_CONF_IPV6
@@ -238,6 +241,16 @@ dio_input(void)
   PRINTF("\n");
 
   if((nbr = uip_ds6_nbr_lookup(&from)) == NULL) {
+#if WITH_ORPL_NBR_POLICY
+    /* Only make room for the neighbor if it is more useful than
+     * the ones we already have. The rank is at offset 2. */
+    if(!orpl_nbr_admit(&from, get16(UIP_ICMP_PAYLOAD, 2))) {
+      PRINTF("RPL: Neighbor table full, dropping DIO from ");
+      PRINT6ADDR(&from);
+      PRINTF("\n");
+      return;
+    }
+#endif /* WITH_ORPL_NBR_POLICY */
     if((nbr = uip_ds6_nbr_add(&from, (uip_lladdr_t *)
                               packetbuf_addr(PACKETBUF_ADDR_SENDER),
                               0, NBR_REACHABLE)) != NULL) {
@@ -474,7 +487,7 @@ dio_output(rpl_instance_t *instance, uip_ipaddr_t *uc_addr)
 
 #if WITH_ORPL_LB_DIO_TARGET && WITH_ORPL_LB
   buffer[pos++] = dio_dc_obj_sn;
-  buffer[pos++] = dio_dc_objective;
+  buffer[pos++] = orpl_dc_objective_to_dio();
 #else
   buffer[pos++] = 0; /* flags */
   buffer[pos++] = 0; /* reserved */
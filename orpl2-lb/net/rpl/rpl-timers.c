@@ -46,15 +46,6 @@
 #if WITH_ORPL
 #include "orpl.h"
 #endif /* WITH_ORPL */
-#if WITH_ORPL_LB && WITH_ORPL_LB_DIO_TARGET
-//uint16_t wu_target=500;
-//uint8_t dc_min=30;//0.30
-//uint8_t dc_max=100;//1.00
-uint8_t dc_fixed=0;
-uint16_t prev;
-extern uint32_t dc_obj_metric;
-extern uint16_t dc_obj_count;
-#endif
 
 #if UIP_CONF_IPV6
 
@@ -160,38 +151,6 @@ handle_dio_timer(void *ptr)
   }
 
   if(instance->dio_send) {
-#if WITH_ORPL_LB && WITH_ORPL_LB_DIO_TARGET
-  if(orpl_is_root()){
-    if(dc_obj_metric !=0){
-      dc_obj_metric=dc_obj_metric/((uint32_t)dc_obj_count);
-    }
-    if(dc_fixed<2){//optimum not yet found
-      if(dc_obj_metric !=0){
-        if(dc_obj_metric <= prev-1){
-          dio_dc_objective=dio_dc_objective-5;
-          dc_fixed=0;//previous step was decrease
-        }
-        else if(dc_obj_metric > prev+1){
-            dc_fixed++;
-          if(dc_fixed==2){
-            dio_dc_objective=dio_dc_objective + 5;
-          }
-        }
-        prev=dc_obj_metric;
-      }
-      else{//starting case
-        dio_dc_objective=80;//dc_min+(dc_max-dc_min)/2;
-        prev=dio_dc_objective;
-      }
-    }
-    //printf("ORPL_LB: dc_objective %u-%u-%u  %lu\n",dio_dc_objective,dc_min,dc_max,dc_obj_metric);
-    printf("ORPL_LB: dc_objective %u-%lu\n",dio_dc_objective,dc_obj_metric);
-    dio_dc_obj_sn=dio_dc_obj_sn++;
-    dc_obj_metric=0;//reset
-    dc_obj_count=0;//reset
-
-  }
-#endif
     /* send DIO if counter is less than desired redundancy */
     if(instance->dio_counter < instance->dio_redundancy) {
 #if RPL_CONF_STATS
@@ -119,8 +119,16 @@ struct rpl_parent {
 #endif /* RPL_DAG_MC != RPL_DAG_MC_NONE */
   rpl_rank_t rank;
 #if WITH_ORPL
-  uint16_t bc_ackcount; /* Broadcast ack count used by ORPL for link estimation */
+  uint16_t bc_history; /* Broadcasts acked by the neighbor, one bit per broadcast, bit 0 is the latest */
+  uint8_t bc_samples; /* Number of broadcasts in bc_history */
+  uint8_t bc_acked; /* The neighbor acked our current broadcast, or an anycast since the last one */
 #endif /* WITH_ORPL */
+#if WITH_ORPL_ENERGY
+  uint8_t energy; /* Remaining energy advertised by the neighbor */
+#endif /* WITH_ORPL_ENERGY */
+#if WITH_ORPL_MULTI_SINK
+  uint16_t sink; /* Sink the neighbor is routing to */
+#endif /* WITH_ORPL_MULTI_SINK */
   uint16_t link_metric;
   uint8_t dtsn;
   uint8_t updated;
@@ -70,6 +70,9 @@
 #include "orpl.h"
 #include "orpl-routing-set.h"
 #include "orpl-anycast.h"
+#if WITH_ORPL_PATH_HINT
+#include "orpl-path-hint.h"
+#endif /* WITH_ORPL_PATH_HINT */
 #endif /* WITH_ORPL */
 
 #if UIP_CONF_IPV6
@@ -126,7 +129,12 @@ void uip_log(char *msg);
 /** \name Pointers in the rime buffer
  *  @{
  */
+#if WITH_ORPL_FRAG
+/* Anycast fragments carry the ORPL routing descriptor first */
+#define RIME_FRAG_PTR           (rime_ptr + orpl_desc_len)
+#else /* WITH_ORPL_FRAG */
 #define RIME_FRAG_PTR           (rime_ptr)
+#endif /* WITH_ORPL_FRAG */
 #define RIME_FRAG_DISPATCH_SIZE 0   /* 16 bit */
 #define RIME_FRAG_TAG           2   /* 16 bit */
 #define RIME_FRAG_OFFSET        4   /* 8 bit */
@@ -232,7 +240,17 @@ static uint16_t sicslowpan_len;
  * It has a fix size as we do not use dynamic memory allocation.
  */
 static uip_buf_t sicslowpan_aligned_buf;
+#if WITH_ORPL_FRAG
+/**
+ * The buffer the incoming packet is decompressed into. Anycast fragments
+ * may take long to all arrive: unfragmented packets are decompressed
+ * straight into uip_buf meanwhile, and the reassembly is left alone.
+ */
+static uint8_t *sicslowpan_in_buf = sicslowpan_aligned_buf.u8;
+#define sicslowpan_buf sicslowpan_in_buf
+#else /* WITH_ORPL_FRAG */
 #define sicslowpan_buf (sicslowpan_aligned_buf.u8)
+#endif /* WITH_ORPL_FRAG */
 
 /** The total length of the IPv6 packet in the sicslowpan_buf. */
 
@@ -254,6 +272,12 @@ rimeaddr_t frag_sender;
 /** Reassembly %process %timer. */
 static struct timer reass_timer;
 
+#if WITH_ORPL_FRAG
+/** When reassembling, the ORPL sequence number of the anycast fragments
+    being merged. They take different paths, their sender may differ. */
+static uint32_t reass_seqno;
+#endif /* WITH_ORPL_FRAG */
+
 /** @} */
 #else /* SICSLOWPAN_CONF_FRAG */
 /** The buffer used for the 6lowpan processing is uip_buf.
@@ -328,6 +352,28 @@ static struct sicslowpan_addr_context *context;
 /** pointer to the byte where to write next inline field. */
 static uint8_t *hc06_ptr;
 
+#if WITH_ORPL_ROUTING_DESC
+/** set when compressing an anycast packet, that carries the ORPL
+    routing descriptor in front of the IPHC header */
+static uint8_t orpl_desc_out;
+/** destination IID from the routing descriptor of the incoming packet */
+static uint8_t *orpl_desc_in;
+#endif /* WITH_ORPL_ROUTING_DESC */
+
+#if WITH_ORPL_FRAG
+#if !WITH_ORPL_FAST_FORWARD
+#error WITH_ORPL_FRAG needs WITH_ORPL_FAST_FORWARD, forwarders don't reassemble anycast fragments
+#endif
+/** length of the routing descriptor in front of the fragmentation
+    header of the current packet, 0 if it has none */
+static uint8_t orpl_desc_len;
+#endif /* WITH_ORPL_FRAG */
+
+#if WITH_ORPL_TRAFFIC_CLASS
+/** traffic class of the outgoing packet, carried by the routing descriptor */
+static uint8_t orpl_class_out;
+#endif /* WITH_ORPL_TRAFFIC_CLASS */
+
 /* Uncompression of linklocal */
 /*   0 -> 16 bytes from packet  */
 /*   1 -> 2 bytes from prefix - bunch of zeroes and 8 from packet */
@@ -398,10 +444,16 @@ addr_context_lookup_by_number(uint8_t number)
 static uint8_t
 compress_addr_64(uint8_t bitpos, uip_ipaddr_t *ipaddr, uip_lladdr_t *lladdr)
 {
-#if !WITH_ORPL /* The current implementation of ORPL disables
-IID compression for quicker lookup from radio interrupts
+#if !WITH_ORPL || WITH_ORPL_ROUTING_DESC /* Without routing descriptor,
+ORPL disables IID compression for quicker lookup from radio interrupts
 when implementing extended software acks */
-  if(uip_is_addr_mac_addr_based(ipaddr, lladdr)) {
+  if(uip_is_addr_mac_addr_based(ipaddr, lladdr)
+#if WITH_ORPL_ROUTING_DESC
+      /* Anycasts are fast-forwarded as they are: past the first hop, the
+       * link-layer sender is not the source, keep the source IID inline */
+      && !(orpl_desc_out && bitpos == SICSLOWPAN_IPHC_SAM_BIT)
+#endif /* WITH_ORPL_ROUTING_DESC */
+      ) {
     return 3 << bitpos; /* 0-bits */
   } else if(sicslowpan_is_iid_16_bit_compressable(ipaddr)) {
     /* compress IID to 16 bits xxxx::0000:00ff:fe00:XXXX */
@@ -409,7 +461,7 @@ when implementing extended software acks */
     hc06_ptr += 2;
     return 2 << bitpos; /* 16-bits */
   } else
-#endif /* !WITH_ORPL */
+#endif /* !WITH_ORPL || WITH_ORPL_ROUTING_DESC */
   {
     /* do not compress IID => xxxx::IID */
     memcpy(hc06_ptr, &ipaddr->u16[4], 8);
@@ -510,7 +562,20 @@ compress_hdr_hc06(rimeaddr_t *rime_destaddr)
   }
 #endif
 
-  hc06_ptr = rime_ptr + 2;
+#if WITH_ORPL_ROUTING_DESC
+  if(orpl_desc_out) {
+    /* The ORPL routing descriptor goes first, at a fixed position */
+#if WITH_ORPL_TRAFFIC_CLASS
+    rime_ptr[0] = ORPL_DESC_DISPATCH | orpl_class_out;
+#else /* WITH_ORPL_TRAFFIC_CLASS */
+    rime_ptr[0] = ORPL_DESC_DISPATCH;
+#endif /* WITH_ORPL_TRAFFIC_CLASS */
+    memcpy(rime_ptr + 1, &UIP_IP_BUF->destipaddr.u8[8], 8);
+    rime_hdr_len = ORPL_DESC_LEN;
+  }
+#endif /* WITH_ORPL_ROUTING_DESC */
+
+  hc06_ptr = rime_ptr + rime_hdr_len + 2;
   /*
    * As we copy some bit-length fields, in the IPHC encoding bytes,
    * we sometimes use |=
@@ -586,7 +651,7 @@ compress_hdr_hc06(rimeaddr_t *rime_destaddr)
   /* Note that the payload length is always compressed */
 
   /* Next header. We compress it if UDP */
-#if !WITH_ORPL && (UIP_CONF_UDP || UIP_CONF_ROUTER) /* ORPL: don't compress UDP */
+#if (!WITH_ORPL || WITH_ORPL_ROUTING_DESC) && (UIP_CONF_UDP || UIP_CONF_ROUTER) /* ORPL: don't compress UDP */
   if(UIP_IP_BUF->proto == UIP_PROTO_UDP) {
     iphc0 |= SICSLOWPAN_IPHC_NH_C;
   }
@@ -596,17 +661,17 @@ compress_hdr_hc06(rimeaddr_t *rime_destaddr)
     iphc0 |= SICSLOWPAN_IPHC_NH_C;
   }
 #endif
-#if !WITH_ORPL /* Don't compress next header for quicker
-  parsing from interrupts */
+#if !WITH_ORPL || WITH_ORPL_ROUTING_DESC /* Without routing descriptor,
+  don't compress next header for quicker parsing from interrupts */
   if ((iphc0 & SICSLOWPAN_IPHC_NH_C) == 0) {
     *hc06_ptr = UIP_IP_BUF->proto;
     hc06_ptr += 1;
   }
 
-#else /* WITH_ORPL */
+#else /* !WITH_ORPL || WITH_ORPL_ROUTING_DESC */
   *hc06_ptr = UIP_IP_BUF->proto;
    hc06_ptr += 1;
-#endif /* !WITH_ORPL */
+#endif /* !WITH_ORPL || WITH_ORPL_ROUTING_DESC */
   /*
    * Hop limit
    * if 1: compress, encoding is 01
@@ -614,8 +679,8 @@ compress_hdr_hc06(rimeaddr_t *rime_destaddr)
    * if 255: compress, encoding is 11
    * else do not compress
    */
-#if !WITH_ORPL /* Don't compress hop limit for quicker
-parsing from interrupts */
+#if !WITH_ORPL || WITH_ORPL_ROUTING_DESC /* Without routing descriptor,
+don't compress hop limit for quicker parsing from interrupts */
   switch(UIP_IP_BUF->ttl) {
     case 1:
       iphc0 |= SICSLOWPAN_IPHC_TTL_1;
@@ -631,10 +696,10 @@ parsing from interrupts */
       hc06_ptr += 1;
       break;
   }
-#else /* WITH_ORPL */
+#else /* !WITH_ORPL || WITH_ORPL_ROUTING_DESC */
     *hc06_ptr = UIP_IP_BUF->ttl;
     hc06_ptr += 1;
-#endif /* WITH_ORPL */
+#endif /* !WITH_ORPL || WITH_ORPL_ROUTING_DESC */
 
   /* source address - cannot be multicast */
   if(uip_is_addr_unspecified(&UIP_IP_BUF->srcipaddr)) {
@@ -699,6 +764,12 @@ parsing from interrupts */
       /* elide the prefix */
       iphc1 |= SICSLOWPAN_IPHC_DAC;
       RIME_IPHC_BUF[2] |= context->number;
+#if WITH_ORPL_ROUTING_DESC
+      if(orpl_desc_out) {
+        /* The IID is carried by the routing descriptor */
+        iphc1 |= SICSLOWPAN_IPHC_DAM_11;
+      } else
+#endif /* WITH_ORPL_ROUTING_DESC */
       /* compession compare with link adress (destination) */
 
       iphc1 |= compress_addr_64(SICSLOWPAN_IPHC_DAM_BIT,
@@ -720,7 +791,7 @@ parsing from interrupts */
 
   uncomp_hdr_len = UIP_IPH_LEN;
 
-#if !WITH_ORPL && (UIP_CONF_UDP || UIP_CONF_ROUTER) /* ORPL: do not compress UDP */
+#if (!WITH_ORPL || WITH_ORPL_ROUTING_DESC) && (UIP_CONF_UDP || UIP_CONF_ROUTER) /* ORPL: do not compress UDP */
   /* UDP header compression */
   if(UIP_IP_BUF->proto == UIP_PROTO_UDP) {
     PRINTF("IPHC: Uncompressed UDP ports on send side: %x, %x\n",
@@ -935,6 +1006,13 @@ uncompress_hdr_hc06(uint16_t ip_len)
 	PRINTF("sicslowpan uncompress_hdr: error context not found\n");
 	return;
       }
+#if WITH_ORPL_ROUTING_DESC
+      if(orpl_desc_in != NULL && tmp == 3) {
+        /* The IID is carried by the routing descriptor */
+        memcpy(&SICSLOWPAN_IP_BUF->destipaddr, context->prefix, 8);
+        memcpy(&SICSLOWPAN_IP_BUF->destipaddr.u8[8], orpl_desc_in, 8);
+      } else
+#endif /* WITH_ORPL_ROUTING_DESC */
       uncompress_addr(&SICSLOWPAN_IP_BUF->destipaddr, context->prefix,
                       unc_ctxconf[tmp],
                       (uip_lladdr_t *)packetbuf_addr(PACKETBUF_ADDR_RECEIVER));
@@ -1437,6 +1515,28 @@ output(uip_lladdr_t *localdest)
   
   PRINTFO("sicslowpan output: sending packet len %d\n", uip_len);
 
+#if WITH_ORPL_ROUTING_DESC
+  /* Anycast packets carry the ORPL routing descriptor, only
+   * supported with IPHC */
+  orpl_desc_out = SICSLOWPAN_COMPRESSION == SICSLOWPAN_COMPRESSION_HC06
+      && uip_len >= COMPRESSION_THRESHOLD
+      && (localdest == (uip_lladdr_t *)&anycast_addr_up
+          || localdest == (uip_lladdr_t *)&anycast_addr_down
+          || localdest == (uip_lladdr_t *)&anycast_addr_nbr
+          || localdest == (uip_lladdr_t *)&anycast_addr_recover
+#if WITH_ORPL_MCAST
+          || localdest == (uip_lladdr_t *)&anycast_addr_mcast
+#endif /* WITH_ORPL_MCAST */
+          );
+#endif /* WITH_ORPL_ROUTING_DESC */
+#if WITH_ORPL_FRAG
+  orpl_desc_len = orpl_desc_out ? ORPL_DESC_LEN : 0;
+#endif /* WITH_ORPL_FRAG */
+#if WITH_ORPL_TRAFFIC_CLASS
+  /* Set by the application, or by tcpip.c for forwarded packets */
+  orpl_class_out = orpl_get_curr_class();
+#endif /* WITH_ORPL_TRAFFIC_CLASS */
+
   if(uip_len >= COMPRESSION_THRESHOLD) {
     /* Try to compress the headers */
 #if SICSLOWPAN_COMPRESSION == SICSLOWPAN_COMPRESSION_HC1
@@ -1483,15 +1583,30 @@ output(uip_lladdr_t *localdest)
 
   if(localdest == (uip_lladdr_t *)&anycast_addr_up) {
     packetbuf_set_attr(PACKETBUF_ATTR_ORPL_DIRECTION, direction_up);
+#if WITH_ORPL_PATH_HINT
+    packetbuf_set_attr(PACKETBUF_ATTR_ORPL_HINT, orpl_path_hint_curr());
+#endif /* WITH_ORPL_PATH_HINT */
   } else if(localdest == (uip_lladdr_t *)&anycast_addr_down) {
     packetbuf_set_attr(PACKETBUF_ATTR_ORPL_DIRECTION, direction_down);
   } else if(localdest == (uip_lladdr_t *)&anycast_addr_nbr) {
     packetbuf_set_attr(PACKETBUF_ATTR_ORPL_DIRECTION, direction_nbr);
   } else if(localdest == (uip_lladdr_t *)&anycast_addr_recover) {
     packetbuf_set_attr(PACKETBUF_ATTR_ORPL_DIRECTION, direction_recover);
+#if WITH_ORPL_MCAST
+  } else if(localdest == (uip_lladdr_t *)&anycast_addr_mcast) {
+    packetbuf_set_attr(PACKETBUF_ATTR_ORPL_DIRECTION, direction_mcast);
+#endif /* WITH_ORPL_MCAST */
   } else {
     packetbuf_set_attr(PACKETBUF_ATTR_ORPL_DIRECTION, direction_none);
   }
+#if WITH_ORPL_TRAFFIC_CLASS
+  packetbuf_set_attr(PACKETBUF_ATTR_ORPL_CLASS, orpl_class_out);
+#endif /* WITH_ORPL_TRAFFIC_CLASS */
+#if WITH_ORPL_RADIO_STATS
+  /* Used to account radio time for forwarded traffic */
+  packetbuf_set_attr(PACKETBUF_ATTR_ORPL_FORWARDED,
+      !uip_ds6_is_my_addr(&UIP_IP_BUF->srcipaddr));
+#endif /* WITH_ORPL_RADIO_STATS */
 #endif /* WITH_ORPL */
 
 #if WITH_ORPL /* Workaround to avoid fragmented DIOs */
@@ -1516,7 +1631,14 @@ output(uip_lladdr_t *localdest)
     PRINTFO("sicslowpan output: 1rst fragment ");
 
     /* move HC1/HC06/IPv6 header */
+#if WITH_ORPL_FRAG
+    /* The routing descriptor stays in front, every fragment of an
+     * anycast carries it so that forwarders can route the fragment */
+    memmove(RIME_FRAG_PTR + SICSLOWPAN_FRAG1_HDR_LEN, RIME_FRAG_PTR,
+            rime_hdr_len - orpl_desc_len);
+#else /* WITH_ORPL_FRAG */
     memmove(rime_ptr + SICSLOWPAN_FRAG1_HDR_LEN, rime_ptr, rime_hdr_len);
+#endif /* WITH_ORPL_FRAG */
 
     /*
      * FRAG1 dispatch + header
@@ -1563,7 +1685,11 @@ output(uip_lladdr_t *localdest)
      * Datagram tag is already in the buffer, we need to set the
      * FRAGN dispatch and for each fragment, the offset
      */
+#if WITH_ORPL_FRAG
+    rime_hdr_len = orpl_desc_len + SICSLOWPAN_FRAGN_HDR_LEN;
+#else /* WITH_ORPL_FRAG */
     rime_hdr_len = SICSLOWPAN_FRAGN_HDR_LEN;
+#endif /* WITH_ORPL_FRAG */
 /*     RIME_FRAG_BUF->dispatch_size = */
 /*       uip_htons((SICSLOWPAN_DISPATCH_FRAGN << 8) | uip_len); */
     SET16(RIME_FRAG_PTR, RIME_FRAG_DISPATCH_SIZE,
@@ -1621,6 +1747,20 @@ output(uip_lladdr_t *localdest)
 }
 
 /*--------------------------------------------------------------------*/
+#if WITH_ORPL_FRAG
+/* Check whether the fragment in packetbuf belongs to the same packet as
+ * the ones being reassembled. Anycast fragments are matched on their
+ * end-to-end sequence number, as each may come from another forwarder. */
+static int
+reass_same_origin(void)
+{
+  if(orpl_desc_in != NULL) {
+    return reass_seqno == orpl_packetbuf_seqno();
+  }
+  return rimeaddr_cmp(&frag_sender, packetbuf_addr(PACKETBUF_ADDR_SENDER));
+}
+#endif /* WITH_ORPL_FRAG */
+
 /** \brief Process a received 6lowpan packet.
  *  \param r The MAC layer
  *
@@ -1654,6 +1794,17 @@ input(void)
   /* The MAC puts the 15.4 payload inside the RIME data buffer */
   rime_ptr = packetbuf_dataptr();
 
+#if WITH_ORPL_FRAG
+  /* Skip the ORPL routing descriptor, if any. In anycast fragments,
+   * it comes before the fragmentation header. */
+  orpl_desc_in = NULL;
+  if(ORPL_DESC_IS_DISPATCH(rime_ptr[0])) {
+    orpl_desc_in = rime_ptr + 1;
+    rime_hdr_len += ORPL_DESC_LEN;
+  }
+  orpl_desc_len = rime_hdr_len;
+#endif /* WITH_ORPL_FRAG */
+
 #if SICSLOWPAN_CONF_FRAG
   /* if reassembly timed out, cancel it */
   if(timer_expired(&reass_timer)) {
@@ -1717,7 +1868,11 @@ input(void)
 #define PRIORITIZE_NEW_PACKETS 1
 #if PRIORITIZE_NEW_PACKETS
   if(processed_ip_in_len > 0 && first_fragment
+#if WITH_ORPL_FRAG
+      && !reass_same_origin()) {
+#else /* WITH_ORPL_FRAG */
       && !rimeaddr_cmp(&frag_sender, packetbuf_addr(PACKETBUF_ADDR_SENDER))) {
+#endif /* WITH_ORPL_FRAG */
     sicslowpan_len = 0;
     processed_ip_in_len = 0;
   }
@@ -1726,11 +1881,19 @@ input(void)
   if(processed_ip_in_len > 0) {
     /* reassembly is ongoing */
     /*    printf("frag %d %d\n", reass_tag, frag_tag);*/
+#if WITH_ORPL_FRAG
+    /* Unfragmented packets go through, see sicslowpan_in_buf */
+    if(frag_size > 0 &&
+        (frag_size != sicslowpan_len ||
+         reass_tag  != frag_tag ||
+         !reass_same_origin())) {
+#else /* WITH_ORPL_FRAG */
     if((frag_size > 0 &&
         (frag_size != sicslowpan_len ||
          reass_tag  != frag_tag ||
          !rimeaddr_cmp(&frag_sender, packetbuf_addr(PACKETBUF_ADDR_SENDER))))  ||
        frag_size == 0) {
+#endif /* WITH_ORPL_FRAG */
       /*
        * the packet is a fragment that does not belong to the packet
        * being reassembled or the packet is not a fragment.
@@ -1746,9 +1909,19 @@ input(void)
     if((frag_size > 0) && (frag_size <= UIP_BUFSIZE)) {
       /* We are currently not reassembling a packet, but have received a packet fragment
        * that is not the first one. */
+#if WITH_ORPL_FRAG
+      /* Anycast fragments take different paths and may arrive in any
+       * order. Their payload goes at its offset in the IP packet anyway,
+       * whether the first fragment is here or not. */
+      if(is_fragment && !first_fragment && orpl_desc_in == NULL) {
+        return;
+      }
+      reass_seqno = orpl_packetbuf_seqno();
+#else /* WITH_ORPL_FRAG */
       if(is_fragment && !first_fragment) {
         return;
       }
+#endif /* WITH_ORPL_FRAG */
 
       sicslowpan_len = frag_size;
       reass_tag = frag_tag;
@@ -1759,12 +1932,26 @@ input(void)
     }
   }
 
+#if WITH_ORPL_FRAG
+  sicslowpan_in_buf = frag_size > 0 ? sicslowpan_aligned_buf.u8 : uip_buf;
+  if(rime_hdr_len == orpl_desc_len + SICSLOWPAN_FRAGN_HDR_LEN) {
+#else /* WITH_ORPL_FRAG */
   if(rime_hdr_len == SICSLOWPAN_FRAGN_HDR_LEN) {
+#endif /* WITH_ORPL_FRAG */
     /* this is a FRAGN, skip the header compression dispatch section */
     goto copypayload;
   }
 #endif /* SICSLOWPAN_CONF_FRAG */
 
+#if WITH_ORPL_ROUTING_DESC && !WITH_ORPL_FRAG
+  /* Skip the ORPL routing descriptor, if any */
+  orpl_desc_in = NULL;
+  if(ORPL_DESC_IS_DISPATCH(RIME_HC1_PTR[RIME_HC1_DISPATCH])) {
+    orpl_desc_in = RIME_HC1_PTR + 1;
+    rime_hdr_len += ORPL_DESC_LEN;
+  }
+#endif /* WITH_ORPL_ROUTING_DESC && !WITH_ORPL_FRAG */
+
   /* Process next dispatch and headers */
 #if SICSLOWPAN_COMPRESSION == SICSLOWPAN_COMPRESSION_HC06
   if((RIME_HC1_PTR[RIME_HC1_DISPATCH] & 0xe0) == SICSLOWPAN_DISPATCH_IPHC) {
@@ -1818,11 +2005,16 @@ input(void)
   {
     int req_size = UIP_LLH_LEN + uncomp_hdr_len + (uint16_t)(frag_offset << 3)
         + rime_payload_len;
+#if WITH_ORPL_FRAG
+    /* Both buffers are UIP_BUFSIZE long */
+    if(req_size > UIP_BUFSIZE) {
+#else /* WITH_ORPL_FRAG */
     if(req_size > sizeof(sicslowpan_buf)) {
+#endif /* WITH_ORPL_FRAG */
       PRINTF(
           "SICSLOWPAN: packet dropped, minimum required SICSLOWPAN_IP_BUF size: %d+%d+%d+%d=%d (current size: %d)\n",
           UIP_LLH_LEN, uncomp_hdr_len, (uint16_t)(frag_offset << 3),
-          rime_payload_len, req_size, sizeof(sicslowpan_buf));
+          rime_payload_len, req_size, UIP_BUFSIZE);
       return;
     }
   }
@@ -1837,6 +2029,19 @@ input(void)
     if(first_fragment != 0) {
       processed_ip_in_len += uncomp_hdr_len;
     }
+#if WITH_ORPL_FRAG
+    if(orpl_desc_in != NULL) {
+      /* Anycast fragments come in any order: the one at the end of the
+         packet is not always the last we receive. Count its bytes only
+         up to the end of the packet. */
+      uint16_t frag_start = (uint16_t)(frag_offset << 3);
+      if(frag_start + rime_payload_len > frag_size) {
+        processed_ip_in_len += frag_size > frag_start ? frag_size - frag_start : 0;
+      } else {
+        processed_ip_in_len += rime_payload_len;
+      }
+    } else
+#endif /* WITH_ORPL_FRAG */
     /* For the last fragment, we are OK if there is extrenous bytes at
        the end of the packet. */
     if(last_fragment != 0) {
@@ -1848,7 +2053,12 @@ input(void)
 
   } else {
 #endif /* SICSLOWPAN_CONF_FRAG */
+#if WITH_ORPL_FRAG
+    /* Already in uip_buf, sicslowpan_len is the reassembly's */
+    uip_len = rime_payload_len + uncomp_hdr_len;
+#else /* WITH_ORPL_FRAG */
     sicslowpan_len = rime_payload_len + uncomp_hdr_len;
+#endif /* WITH_ORPL_FRAG */
 #if SICSLOWPAN_CONF_FRAG
   }
 
@@ -1858,6 +2068,17 @@ input(void)
    */
   PRINTF("sicslowpan_init processed_ip_in_len %d, sicslowpan_len %d\n",
          processed_ip_in_len, sicslowpan_len);
+#if WITH_ORPL_FRAG
+  if(frag_size == 0 || processed_ip_in_len == sicslowpan_len) {
+    if(frag_size > 0) {
+      PRINTFI("sicslowpan input: IP packet ready (length %d)\n",
+             sicslowpan_len);
+      memcpy((uint8_t *)UIP_IP_BUF, (uint8_t *)SICSLOWPAN_IP_BUF, sicslowpan_len);
+      uip_len = sicslowpan_len;
+      sicslowpan_len = 0;
+      processed_ip_in_len = 0;
+    }
+#else /* WITH_ORPL_FRAG */
   if(processed_ip_in_len == 0 || (processed_ip_in_len == sicslowpan_len)) {
     PRINTFI("sicslowpan input: IP packet ready (length %d)\n",
            sicslowpan_len);
@@ -1865,6 +2086,7 @@ input(void)
     uip_len = sicslowpan_len;
     sicslowpan_len = 0;
     processed_ip_in_len = 0;
+#endif /* WITH_ORPL_FRAG */
 #endif /* SICSLOWPAN_CONF_FRAG */
 
 #if DEBUG
@@ -51,6 +51,12 @@
 #include "orpl.h"
 #include "orpl-anycast.h"
 #include "orpl-routing-set.h"
+#if WITH_ORPL_PATH_HINT
+#include "orpl-path-hint.h"
+#endif /* WITH_ORPL_PATH_HINT */
+#if WITH_ORPL_MCAST
+#include "orpl-mcast.h"
+#endif /* WITH_ORPL_MCAST */
 #endif /* WITH_ORPL */
 
 #include <string.h>
@@ -651,17 +657,41 @@ tcpip_ipv6_output(void)
         seqno = orpl_get_new_seqno();
       }
       orpl_set_curr_seqno(seqno);
+#if WITH_ORPL_TRAFFIC_CLASS
+      /* Forwarded packets keep their class */
+      if(!uip_ds6_is_my_addr(&UIP_IP_BUF->srcipaddr)) {
+        orpl_set_curr_class(packetbuf_attr(PACKETBUF_ATTR_ORPL_CLASS));
+      }
+#endif /* WITH_ORPL_TRAFFIC_CLASS */
 
       /* Set anycast MAC address instead of routing */
       if(orpl_is_reachable_neighbor(&UIP_IP_BUF->destipaddr)) {
         ORPL_LOG_FROM_UIP("Tcpip: fw to nbr");
         anycast_addr = &anycast_addr_nbr;
-      } else if(orpl_routing_set_contains(&UIP_IP_BUF->destipaddr) && !orpl_blacklist_contains(seqno)) {
+      } else if(orpl_routing_set_contains(&UIP_IP_BUF->destipaddr) && !orpl_blacklist_contains(seqno)
+#if WITH_ORPL_MULTI_SINK
+          && !orpl_is_sink_ipaddr(&UIP_IP_BUF->destipaddr)
+#endif /* WITH_ORPL_MULTI_SINK */
+          ) {
         ORPL_LOG_FROM_UIP("Tcpip: fw down");
         anycast_addr = &anycast_addr_down;
+#if WITH_ORPL_PATH_HINT
+        /* We turn this flow down: tell the source */
+        if(!uip_ds6_is_my_addr(&UIP_IP_BUF->srcipaddr)
+            && packetbuf_attr(PACKETBUF_ATTR_ORPL_DIRECTION) == direction_up) {
+          orpl_path_hint_turned(&UIP_IP_BUF->srcipaddr, &UIP_IP_BUF->destipaddr);
+        }
+#endif /* WITH_ORPL_PATH_HINT */
       } else if(orpl_is_root() == 0){
         ORPL_LOG_FROM_UIP("Tcpip: fw up");
         anycast_addr = &anycast_addr_up;
+#if WITH_ORPL_PATH_HINT
+        /* Sources mark their flows with the hint they have, forwarders
+         * keep the hint of the packet */
+        orpl_path_hint_set_curr(uip_ds6_is_my_addr(&UIP_IP_BUF->srcipaddr)
+            ? orpl_path_hint_lookup(&UIP_IP_BUF->destipaddr)
+            : packetbuf_attr(PACKETBUF_ATTR_ORPL_HINT));
+#endif /* WITH_ORPL_PATH_HINT */
       } else { /* We are the root and need to route upwards =>
       use fallback interface. */
         orpl_packetbuf_set_seqno(0);
@@ -790,6 +820,26 @@ tcpip_ipv6_output(void)
     return;
   }
   /* Multicast IP destination address. */
+#if WITH_ORPL_MCAST
+  if(orpl_mcast_is_group(&UIP_IP_BUF->destipaddr)) {
+    /* ORPL group: anycast down to the members of our sub-DODAG.
+     * Only originators get here, forwarders do it from fast forwarding. */
+    uint32_t seqno = orpl_get_curr_seqno();
+    if(seqno == 0) {
+      seqno = orpl_get_new_seqno();
+    }
+    orpl_set_curr_seqno(seqno);
+    if(orpl_mcast_has_members(&UIP_IP_BUF->destipaddr)) {
+      ORPL_LOG_FROM_UIP("Tcpip: fw mcast");
+      tcpip_output((uip_lladdr_t *)&anycast_addr_mcast);
+    } else {
+      ORPL_LOG_FROM_UIP("Tcpip:! no member for group");
+    }
+    uip_len = 0;
+    uip_ext_len = 0;
+    return;
+  }
+#endif /* WITH_ORPL_MCAST */
   tcpip_output(NULL);
   uip_len = 0;
   uip_ext_len = 0;
@@ -41,8 +41,18 @@
 #include "orpl.h"
 #include "orpl-routing-set.h"
 #include "orpl-anycast.h"
+#if WITH_ORPL_ENERGY
+#include "orpl-energy.h"
+#endif /* WITH_ORPL_ENERGY */
 #include "net/packetbuf.h"
 #include "cc2420-softack.h"
+#include "orpl-softack-prof.h"
+#if WITH_ORPL_PATH_HINT
+#include "orpl-path-hint.h"
+#endif /* WITH_ORPL_PATH_HINT */
+#if WITH_ORPL_MCAST
+#include "orpl-mcast.h"
+#endif /* WITH_ORPL_MCAST */
 #include "net/mac/frame802154.h"
 #include "dev/leds.h"
 #include <string.h>
@@ -52,16 +62,46 @@
 #if WITH_ORPL
 
 extern uint8_t queuebuf_len, queuebuf_ref_len, queuebuf_max_len;
+#if WITH_ORPL_RIMAC
+/* Set by ORPL-RIMAC while it sends, see orpl_softack_input_callback */
+extern volatile unsigned char we_are_sending;
+#endif /* WITH_ORPL_RIMAC */
 
 /* The different link-layer addresses used for anycast */
 rimeaddr_t anycast_addr_up = {.u8 = {0xfa, 0xfa, 0xfa, 0xfa, 0xfa, 0xfa, 0xfa, 0xfa}};
 rimeaddr_t anycast_addr_down = {.u8 = {0xfb, 0xfb, 0xfb, 0xfb, 0xfb, 0xfb, 0xfb, 0xfb}};
 rimeaddr_t anycast_addr_nbr = {.u8 = {0xfc, 0xfc, 0xfc, 0xfc, 0xfc, 0xfc, 0xfc, 0xfc}};
 rimeaddr_t anycast_addr_recover = {.u8 = {0xfd, 0xfd, 0xfd, 0xfd, 0xfd, 0xfd, 0xfd, 0xfd}};
+#if WITH_ORPL_MCAST
+rimeaddr_t anycast_addr_mcast = {.u8 = {0xfe, 0xfe, 0xfe, 0xfe, 0xfe, 0xfe, 0xfe, 0xfe}};
+#endif /* WITH_ORPL_MCAST */
 
-/* Callback functions for 802.15.4 softack driver */
+#if !WITH_ORPL_BR_HOST
+/* Callback functions for 802.15.4 softack driver. On the host of a
+ * split root, frames are acked by the radio (see orpl-br.h). */
 static void orpl_softack_acked_callback(const uint8_t *buf, uint8_t len);
 static void orpl_softack_input_callback(const uint8_t *buf, uint8_t len, uint8_t **ackbufptr, uint8_t *acklen);
+#endif /* !WITH_ORPL_BR_HOST */
+
+/* Anycast forwarding counters */
+static struct orpl_anycast_stats stats;
+#if WITH_ORPL_TRAFFIC_CLASS
+static struct orpl_class_stats class_stats[ORPL_CLASS_COUNT];
+#endif /* WITH_ORPL_TRAFFIC_CLASS */
+
+#if WITH_ORPL_ACK_SLOTS
+/* ACK slot of the frame being processed, set by the ack decision */
+static uint8_t ack_slot;
+
+/* Returns the ACK slot corresponding to the EDC progress we would bring
+ * beyond ORPL_EDC_W: the more progress, the earlier the slot */
+static uint8_t
+ack_slot_from_progress(uint16_t progress)
+{
+  uint16_t steps = progress / ORPL_ACK_SLOT_EDC;
+  return steps >= ORPL_ACK_SLOTS - 1 ? 0 : ORPL_ACK_SLOTS - 1 - steps;
+}
+#endif /* WITH_ORPL_ACK_SLOTS */
 
 /* A buffer where extended 802.15.4 are prepared */
 static unsigned char ackbuf[3 + EXTRA_ACK_LEN] = {0x02, 0x00};
@@ -70,7 +110,7 @@ static uint8_t last_acked_seqno = -1;
 
 /* Set the destination link-layer address in packetbuf in case of anycast.
  * The address contains the following information:
- * - direction, among up, down, nbr, recover
+ * - direction, among up, down, nbr, recover (and mcast)
  * - the EDC of the sender
  * - the end-to-end sequence number
  *  */
@@ -80,15 +120,27 @@ orpl_anycast_set_packetbuf_addr()
   uint16_t *ptr = (uint16_t *)packetbuf_addr(PACKETBUF_ADDR_RECEIVER);
   /* Check is the address is an anycast address */
   if(rimeaddr_cmp((rimeaddr_t*)ptr, &anycast_addr_up) || rimeaddr_cmp((rimeaddr_t*)ptr, &anycast_addr_down)
-      || rimeaddr_cmp((rimeaddr_t*)ptr, &anycast_addr_nbr) || rimeaddr_cmp((rimeaddr_t*)ptr, &anycast_addr_recover)) {
+      || rimeaddr_cmp((rimeaddr_t*)ptr, &anycast_addr_nbr) || rimeaddr_cmp((rimeaddr_t*)ptr, &anycast_addr_recover)
+#if WITH_ORPL_MCAST
+      || rimeaddr_cmp((rimeaddr_t*)ptr, &anycast_addr_mcast)
+#endif /* WITH_ORPL_MCAST */
+      ) {
     uint32_t seqno = orpl_packetbuf_seqno();
     /* Append EDC and sequence number */
     ptr[1] = orpl_current_edc();
     ptr[2] = seqno >> 16;
     ptr[3] = seqno;
+#if WITH_ORPL_PATH_HINT
+    /* The second byte of upwards addresses carries the path hint */
+    if(packetbuf_attr(PACKETBUF_ATTR_ORPL_DIRECTION) == direction_up
+        && packetbuf_attr(PACKETBUF_ATTR_ORPL_HINT) != 0) {
+      ((uint8_t *)ptr)[1] = packetbuf_attr(PACKETBUF_ATTR_ORPL_HINT) - 1;
+    }
+#endif /* WITH_ORPL_PATH_HINT */
   }
 }
 
+#if !WITH_ORPL_BR_HOST
 /* The frame was acked (i.e. we wanted to ack it AND it was not corrupt).
  * Store the last acked sequence number to avoid repeatedly acking in case
  * we're not duty cycled (e.g. border router) */
@@ -96,8 +148,131 @@ static void
 orpl_softack_acked_callback(const uint8_t *frame, uint8_t framelen)
 {
 	last_acked_seqno = frame[2];
+	if((frame[0] >> 5) & 1) {
+	  stats.acked++;
+	}
+}
+#endif /* !WITH_ORPL_BR_HOST */
+
+/* App-layer duplicate detection, shared by the RDCs */
+struct app_seqno {
+  uint32_t seqno;
+#if WITH_ORPL_FRAG
+  uint8_t frag_offset; /* Fragments of a packet share its seqno */
+#endif /* WITH_ORPL_FRAG */
+#if !FREEZE_TOPOLOGY
+  uint16_t sender; /* Node id of the neighbor we received it from */
+  uint16_t edc; /* EDC that neighbor claimed in the anycast address */
+#endif /* !FREEZE_TOPOLOGY */
+};
+#define MAX_SEQNOS_APP 32
+static struct app_seqno received_app_seqnos[MAX_SEQNOS_APP];
+
+/* Returns 1 if the anycast in packetbuf is an app-layer duplicate, and
+ * records it otherwise. Also detects loops from upward duplicates. */
+int
+orpl_anycast_is_duplicate()
+{
+  int i;
+  uint32_t seqno = orpl_packetbuf_seqno();
+#if WITH_ORPL_FRAG
+  uint8_t frag_offset = orpl_packetbuf_frag_offset();
+#endif /* WITH_ORPL_FRAG */
+  if(packetbuf_attr(PACKETBUF_ATTR_ORPL_DIRECTION) != direction_recover) {
+    for(i = 0; i < MAX_SEQNOS_APP; i++) {
+      /* Recovery packets are not compared, so that they are not dropped
+       * as duplicates of the packet they recover */
+      if(seqno == received_app_seqnos[i].seqno
+#if WITH_ORPL_FRAG
+          && frag_offset == received_app_seqnos[i].frag_offset
+#endif /* WITH_ORPL_FRAG */
+          ) {
+        orpl_anycast_duplicate_received();
+#if !FREEZE_TOPOLOGY
+        /* Parallel forwarders relay the same packet too, but from below
+         * the EDC it first came to us at. The same packet going up from
+         * a neighbor that claims an EDC no lower than that went through
+         * us before: loop. Roots don't forward, they only see duplicates. */
+        if(!orpl_is_root()
+            && packetbuf_attr(PACKETBUF_ATTR_ORPL_DIRECTION) == direction_up
+            && received_app_seqnos[i].sender != ORPL_LOG_NODEID_FROM_RIMEADDR(packetbuf_addr(PACKETBUF_ADDR_SENDER))
+            && packetbuf_attr(PACKETBUF_ATTR_EDC) >= received_app_seqnos[i].edc) {
+          orpl_loop_detected(seqno, packetbuf_addr(PACKETBUF_ADDR_SENDER));
+        }
+#endif /* !FREEZE_TOPOLOGY */
+        return 1;
+      }
+    }
+  }
+  memmove(&received_app_seqnos[1], &received_app_seqnos[0],
+      (MAX_SEQNOS_APP - 1) * sizeof(received_app_seqnos[0]));
+  received_app_seqnos[0].seqno = seqno;
+#if WITH_ORPL_FRAG
+  received_app_seqnos[0].frag_offset = frag_offset;
+#endif /* WITH_ORPL_FRAG */
+#if !FREEZE_TOPOLOGY
+  received_app_seqnos[0].sender = ORPL_LOG_NODEID_FROM_RIMEADDR(packetbuf_addr(PACKETBUF_ADDR_SENDER));
+  received_app_seqnos[0].edc = packetbuf_attr(PACKETBUF_ATTR_EDC);
+#endif /* !FREEZE_TOPOLOGY */
+  return 0;
+}
+
+/* Called when a duplicate anycast was received and dropped */
+void
+orpl_anycast_duplicate_received()
+{
+  stats.duplicates++;
+  if(stats.duplicates % 16 == 0) {
+#if !WITH_ORPL_BR_HOST
+    stats.cancelled = cc2420_softack_cancelled_count;
+#endif /* !WITH_ORPL_BR_HOST */
+    ORPL_LOG("ORPL: anycast stats acked %lu cancelled %u duplicates %lu\n",
+        stats.acked, stats.cancelled, stats.duplicates);
+  }
+}
+
+/* Returns the anycast forwarding counters */
+const struct orpl_anycast_stats *
+orpl_anycast_get_stats()
+{
+#if !WITH_ORPL_BR_HOST
+  stats.cancelled = cc2420_softack_cancelled_count;
+#endif /* !WITH_ORPL_BR_HOST */
+  return &stats;
+}
+
+#if WITH_ORPL_TRAFFIC_CLASS
+/* Called by CSMA when it is done with an anycast of a given class */
+void
+orpl_anycast_class_done(uint8_t traffic_class, int delivered, clock_time_t delay)
+{
+  struct orpl_class_stats *s;
+  if(traffic_class >= ORPL_CLASS_COUNT) {
+    return;
+  }
+  s = &class_stats[traffic_class];
+  if(delivered) {
+    s->delivered++;
+    s->delay += delay;
+  } else {
+    s->dropped++;
+  }
+  if((s->delivered + s->dropped) % 16 == 0) {
+    ORPL_LOG("ORPL: class %u delivered %u dropped %u delay %lu ms\n",
+        traffic_class, s->delivered, s->dropped,
+        s->delivered ? (1000 * (s->delay / s->delivered)) / CLOCK_SECOND : 0);
+  }
 }
 
+/* Returns the counters of a traffic class */
+const struct orpl_class_stats *
+orpl_anycast_get_class_stats(uint8_t traffic_class)
+{
+  return traffic_class < ORPL_CLASS_COUNT ? &class_stats[traffic_class] : NULL;
+}
+#endif /* WITH_ORPL_TRAFFIC_CLASS */
+
+#if !WITH_ORPL_BR_HOST
 /* Called for every incoming frame from interrupt. We check if we want to ack the
  * frame and prepare an ACK if needed */
 static void
@@ -113,18 +288,28 @@ orpl_softack_input_callback(const uint8_t *frame, uint8_t framelen, uint8_t **ac
   if(is_data) {
     if(ack_required) { /* This is unicast or unicast, parse it */
       //do_ack = orpl_anycast_parse_802154_frame((uint8_t *)frame, framelen, 0).do_ack;
+      ORPL_SOFTACK_PROF_STAMP(ORPL_SOFTACK_PROF_MUST_ACK_START);
 #if WITH_ORPL_LOADCTRL
       //ORPL_LOG_FROM_PACKETBUF("queue: %u-%u",queuebuf_len,queuebuf_max_len);
       do_ack = (queuebuf_len < queuebuf_max_len-1 && orpl_anycast_802154_frame_must_ack((uint8_t *)frame, framelen));
 #else /*WITH_ORPL_LOADCTRL*/
       do_ack = orpl_anycast_802154_frame_must_ack((uint8_t *)frame, framelen);
 #endif /*WITH_ORPL_LOADCTRL*/
+      ORPL_SOFTACK_PROF_STAMP(ORPL_SOFTACK_PROF_MUST_ACK_END);
     } else { /* We also ack broadcast, even if we didn't modify the framer
 		and still send them with ack_required unset */
 			if(seqno != last_acked_seqno) {
 				do_ack = 1;
 			}
 		}
+#if WITH_ORPL_RIMAC
+    /* A RIMAC sender reads every incoming frame while it listens for
+     * beacons and ACKs, and can't take data meanwhile. Don't ack, so that
+     * the sender tries another forwarder instead of losing the frame. */
+    if(we_are_sending) {
+      do_ack = 0;
+    }
+#endif /* WITH_ORPL_RIMAC */
 	}
 
 	if(do_ack) { /* Prepare ack */
@@ -137,22 +322,33 @@ orpl_softack_input_callback(const uint8_t *frame, uint8_t framelen, uint8_t **ac
 		/* Append our rank to the ack */
 		ackbuf[3+8] = curr_edc & 0xff;
 		ackbuf[3+8+1] = (curr_edc >> 8)& 0xff;
+#if WITH_ORPL_ENERGY
+		/* Append our remaining energy to the ack */
+		ackbuf[3+8+2] = orpl_energy_remaining();
+#endif /* WITH_ORPL_ENERGY */
+#if WITH_ORPL_ACK_SLOTS
+		if(ack_required) {
+		  cc2420_softack_ack_delay = ack_slot * ORPL_ACK_SLOT_TIME;
+		}
+#endif /* WITH_ORPL_ACK_SLOTS */
 	} else {
 
 		*acklen = 0;
 	}
 }
+#endif /* !WITH_ORPL_BR_HOST */
 
 /* Parse a link-layer address, extract anycast direction, sender EDC, end-to-end sequence number.
  * Return 1 if anycast, 0 otherwise */
 static int
 anycast_parse_addr(rimeaddr_t *addr, enum anycast_direction_e *anycast_direction,
-    uint16_t *curr_edc, uint32_t *seqno)
+    uint16_t *curr_edc, uint32_t *seqno, uint8_t *hint)
 {
   int up = 0;
   int down = 0;
   int nbr = 0;
   int recover = 0;
+  int mcast = 0;
 
   int i;
   uint8_t addr_host_order[8];
@@ -161,10 +357,17 @@ anycast_parse_addr(rimeaddr_t *addr, enum anycast_direction_e *anycast_direction
     addr_host_order[i] = addr->u8[7-i];
   }
 
+#if WITH_ORPL_PATH_HINT
+  /* Upwards, the second byte carries the path hint */
+  up = addr_host_order[0] == anycast_addr_up.u8[0];
+  if(hint) *hint = up && addr_host_order[1] != ORPL_PATH_HINT_ADDR_NONE ? addr_host_order[1] + 1 : 0;
+#else /* WITH_ORPL_PATH_HINT */
+  up = !memcmp(addr_host_order, &anycast_addr_up, 2);
+#endif /* WITH_ORPL_PATH_HINT */
+
   /* Compare only the 2 first bytes, as other bytes carry curr_edc and seqno */
-  if(!memcmp(addr_host_order, &anycast_addr_up, 2)) {
+  if(up) {
     if(anycast_direction) *anycast_direction = direction_up;
-    up = 1;
   } else if(!memcmp(addr_host_order, &anycast_addr_down, 2)) {
     if(anycast_direction) *anycast_direction = direction_down;
     down = 1;
@@ -174,6 +377,11 @@ anycast_parse_addr(rimeaddr_t *addr, enum anycast_direction_e *anycast_direction
   } else if(!memcmp(addr_host_order, &anycast_addr_recover, 2)) {
     if(anycast_direction) *anycast_direction = direction_recover;
     recover = 1;
+#if WITH_ORPL_MCAST
+  } else if(!memcmp(addr_host_order, &anycast_addr_mcast, 2)) {
+    if(anycast_direction) *anycast_direction = direction_mcast;
+    mcast = 1;
+#endif /* WITH_ORPL_MCAST */
   }
 
   uint16_t *ptr = (uint16_t*)addr_host_order;
@@ -182,7 +390,7 @@ anycast_parse_addr(rimeaddr_t *addr, enum anycast_direction_e *anycast_direction
   /* Extrace end-to-end sequence number */
   if(seqno) *seqno = (((uint32_t)ptr[2]) << 16) + (uint32_t)ptr[3];
 
-  if(!up && !down && !nbr && !recover) {
+  if(!up && !down && !nbr && !recover && !mcast) {
     return 0; /* This is not an anycast address */
   } else {
     return 1; /* This is an anycast address */
@@ -212,11 +420,26 @@ orpl_anycast_802154_frame_parse(uint8_t *data, uint8_t len)
   /* This is a unciast or anycast data frame */
   if(fcf.frame_type == FRAME802154_DATAFRAME && fcf.ack_required == 1) {
     /* Parse the destination address */
-    if(anycast_parse_addr((rimeaddr_t*)dest_addr, &info.direction, &info.neighbor_edc, &info.seqno)) {
+    if(anycast_parse_addr((rimeaddr_t*)dest_addr, &info.direction, &info.neighbor_edc, &info.seqno,
+#if WITH_ORPL_PATH_HINT
+        &info.hint
+#else /* WITH_ORPL_PATH_HINT */
+        NULL
+#endif /* WITH_ORPL_PATH_HINT */
+        )) {
       /* Set destination address to ours so it doesn't get dropped by upper layers */
       for(i=0; i<8; i++) {
         dest_addr[i] = rimeaddr_node_addr.u8[7-i];
       }
+#if WITH_ORPL_TRAFFIC_CLASS
+      {
+        /* The class is in the dispatch of the routing descriptor */
+        uint8_t *desc = data + 21 + (CONTIKIMAC_CONF_WITH_CONTIKIMAC_HEADER ? 2 : 0);
+        if(desc < data + len && ORPL_DESC_IS_DISPATCH(desc[0])) {
+          info.traffic_class = desc[0] & ORPL_DESC_CLASS_MASK;
+        }
+      }
+#endif /* WITH_ORPL_TRAFFIC_CLASS */
     }
   }
 
@@ -236,6 +459,10 @@ orpl_anycast_802154_frame_must_ack(uint8_t *data, uint8_t len)
   int do_ack = 0;
 
   memset(&info, 0, sizeof(info));
+#if WITH_ORPL_ACK_SLOTS
+  /* Frames for us, to a neighbor or in recovery are acked right away */
+  ack_slot = 0;
+#endif /* WITH_ORPL_ACK_SLOTS */
 
   if(len < 3) {
     return 0;
@@ -258,32 +485,98 @@ orpl_anycast_802154_frame_must_ack(uint8_t *data, uint8_t len)
       dest_addr_host_order[i] = dest_addr[7-i];
     }
     /* Parse the destination address */
-    if(anycast_parse_addr((rimeaddr_t*)dest_addr, &info.direction, &info.neighbor_edc, &info.seqno)) {
+    if(anycast_parse_addr((rimeaddr_t*)dest_addr, &info.direction, &info.neighbor_edc, &info.seqno,
+#if WITH_ORPL_PATH_HINT
+        &info.hint
+#else /* WITH_ORPL_PATH_HINT */
+        NULL
+#endif /* WITH_ORPL_PATH_HINT */
+        )) {
       rpl_rank_t curr_edc = orpl_current_edc();
+#if WITH_ORPL_ENERGY
+      /* Depleted nodes are less eager to forward: they act as if their
+       * EDC was worse (upwards) or better (downwards) than it is */
+      rpl_rank_t energy_penalty = orpl_energy_own_penalty();
+#else /* WITH_ORPL_ENERGY */
+      rpl_rank_t energy_penalty = 0;
+#endif /* WITH_ORPL_ENERGY */
 
       /* Calculate destination IPv6 address */
-      /* TODO ORPL: better document this addressing */
       uip_ipaddr_t dest_ipv6;
       memcpy(&dest_ipv6, &global_ipv6, 8); /* override prefix */
+#if WITH_ORPL_ROUTING_DESC
+      {
+        /* The routing descriptor follows the 21-byte MAC header */
+        uint8_t *desc = data + 21 + (CONTIKIMAC_CONF_WITH_CONTIKIMAC_HEADER ? 2 : 0);
+        if(desc + ORPL_DESC_LEN > data + len || !ORPL_DESC_IS_DISPATCH(desc[0])) {
+          /* No descriptor, we can't route this frame */
+          return 0;
+        }
+        memcpy(((char*)&dest_ipv6)+8, desc + 1, 8);
+#if WITH_ORPL_TRAFFIC_CLASS
+        info.traffic_class = desc[0] & ORPL_DESC_CLASS_MASK;
+#endif /* WITH_ORPL_TRAFFIC_CLASS */
+      }
+#else /* WITH_ORPL_ROUTING_DESC */
+      /* The destination IID is found at a fixed offset in the frame, as
+       * 6LoWPAN compression of addresses, next header and hop limit is
+       * disabled. */
       memcpy(((char*)&dest_ipv6)+8, data + (CONTIKIMAC_CONF_WITH_CONTIKIMAC_HEADER ? 2 : 0) + 34, 8);
+#endif /* WITH_ORPL_ROUTING_DESC */
 
       if(uip_ip6addr_cmp(&dest_ipv6, &global_ipv6)) {
         /* Take the data if it is for us */
         do_ack = 1;
+#if WITH_ORPL_MULTI_SINK
+      } else if(orpl_is_root() && orpl_is_sink_ipaddr(&dest_ipv6)) {
+        /* Any root takes the data sent to the virtual sink */
+        do_ack = 1;
+#endif /* WITH_ORPL_MULTI_SINK */
       } else if(rimeaddr_cmp((rimeaddr_t*)dest_addr_host_order, &rimeaddr_node_addr)) {
         /* Unicast, for us */
         do_ack = 1;
       } else if(info.direction == direction_up) {
+#if WITH_ORPL_PATH_HINT
+        if(info.hint != 0 && !orpl_blacklist_contains(info.seqno) && orpl_routing_set_contains(&dest_ipv6)
+#if WITH_ORPL_MULTI_SINK
+            && !orpl_is_sink_ipaddr(&dest_ipv6)
+#endif /* WITH_ORPL_MULTI_SINK */
+            ) {
+          /* The flow has a path hint: turn it down here, before any
+           * upwards forwarder takes it */
+          do_ack = 1;
+          ack_slot = 0;
+        } else
+#endif /* WITH_ORPL_PATH_HINT */
         /* Routing upwards. ACK if our rank is better. */
-        if(info.neighbor_edc > ORPL_EDC_W && curr_edc < info.neighbor_edc - ORPL_EDC_W) {
+        if(info.neighbor_edc > ORPL_EDC_W && (uint32_t)curr_edc + energy_penalty < info.neighbor_edc - ORPL_EDC_W) {
           do_ack = 1;
+#if WITH_ORPL_ACK_SLOTS
+          ack_slot = ack_slot_from_progress(info.neighbor_edc - ORPL_EDC_W - curr_edc - energy_penalty);
+#endif /* WITH_ORPL_ACK_SLOTS */
+#if WITH_ORPL_PATH_HINT
+          /* We would climb past the EDC where the flow turns down,
+           * let nodes closer to the turn go first */
+          if(info.hint != 0 && ORPL_PATH_HINT_EDC_TO_BAND(curr_edc) < info.hint - 1) {
+            ack_slot = ORPL_ACK_SLOTS - 1;
+          }
+#endif /* WITH_ORPL_PATH_HINT */
         } else {
           /* We don't route upwards, now check if we are a common ancester of the source
            * and destination. We do this by checking our routing set against the destination. */
-          if(!orpl_blacklist_contains(info.seqno) && orpl_routing_set_contains(&dest_ipv6)) {
+          if(!orpl_blacklist_contains(info.seqno) && orpl_routing_set_contains(&dest_ipv6)
+#if WITH_ORPL_MULTI_SINK
+              /* The virtual sink is never in routing sets, ignore false positives */
+              && !orpl_is_sink_ipaddr(&dest_ipv6)
+#endif /* WITH_ORPL_MULTI_SINK */
+              ) {
             /* Traffic is going up but we have destination in our routing set.
              * Ack it and start routing downwards (towards the destination) */
             do_ack = 1;
+#if WITH_ORPL_ACK_SLOTS
+            /* Let forwarders towards the root go first */
+            ack_slot = ORPL_ACK_SLOTS - 1;
+#endif /* WITH_ORPL_ACK_SLOTS */
           }
         }
       } else if(info.direction == direction_down) {
@@ -291,9 +584,15 @@ orpl_anycast_802154_frame_must_ack(uint8_t *data, uint8_t len)
          * we it is in subdodag and we have a worse rank */
         if(!orpl_blacklist_contains(info.seqno)
             && (orpl_is_reachable_neighbor(&dest_ipv6)
-                || (curr_edc > ORPL_EDC_W && curr_edc - ORPL_EDC_W > info.neighbor_edc
+                || (curr_edc > ORPL_EDC_W + energy_penalty
+                && curr_edc - ORPL_EDC_W - energy_penalty > info.neighbor_edc
                 && orpl_routing_set_contains(&dest_ipv6)))) {
           do_ack = 1;
+#if WITH_ORPL_ACK_SLOTS
+          if(!orpl_is_reachable_neighbor(&dest_ipv6)) {
+            ack_slot = ack_slot_from_progress(curr_edc - ORPL_EDC_W - energy_penalty - info.neighbor_edc);
+          }
+#endif /* WITH_ORPL_ACK_SLOTS */
         }
       } else if(info.direction == direction_recover) {
         /* This packet is sent back from a child that experiences false positive. Only
@@ -301,6 +600,19 @@ orpl_anycast_802154_frame_must_ack(uint8_t *data, uint8_t len)
          * take the packet back during a recovery, before sending down again. This is
          * to avoid duplicates during the recovery process. */
         do_ack = orpl_acked_down_contains(info.seqno, (const rimeaddr_t *)src_addr_host_order);
+#if WITH_ORPL_MCAST
+      } else if(info.direction == direction_mcast) {
+        /* Group message. Members deeper than the sender take it, as well
+         * as the nodes further down the DODAG that have members below them.
+         * The sender strobes for a whole wake-up interval, so all of them
+         * get a chance to ack. */
+        do_ack = (curr_edc > info.neighbor_edc
+                && orpl_mcast_is_member_iid(((uint8_t*)&dest_ipv6) + 8))
+            || (!orpl_blacklist_contains(info.seqno)
+                && curr_edc > ORPL_EDC_W + energy_penalty
+                && curr_edc - ORPL_EDC_W - energy_penalty > info.neighbor_edc
+                && orpl_routing_set_contains(&dest_ipv6));
+#endif /* WITH_ORPL_MCAST */
       }
     }
   }
@@ -313,8 +625,10 @@ orpl_anycast_802154_frame_must_ack(uint8_t *data, uint8_t len)
 void
 orpl_anycast_init()
 {
+#if !WITH_ORPL_BR_HOST
   /* Subscribe to 802.15.4 softack driver */
   cc2420_softack_subscribe(orpl_softack_input_callback, orpl_softack_acked_callback);
+#endif /* !WITH_ORPL_BR_HOST */
 }
 
 #endif /* WITH_ORPL */
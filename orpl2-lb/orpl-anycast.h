@@ -43,26 +43,102 @@
 
 #include "uip.h"
 
-#define EXTRA_ACK_LEN    10 /* Number of bytes we add to standard IEEE 802.15.4 ACK frames */
+/* Number of bytes we add to standard IEEE 802.15.4 ACK frames:
+ * our link-layer address, our EDC, and optionally our energy level */
+#if WITH_ORPL_ENERGY
+#define EXTRA_ACK_LEN    11
+#else /* WITH_ORPL_ENERGY */
+#define EXTRA_ACK_LEN    10
+#endif /* WITH_ORPL_ENERGY */
+
+#if WITH_ORPL_ROUTING_DESC
+/* Compact routing descriptor, placed by 6LoWPAN right after the MAC
+ * header of anycast frames, so that the ack decision can read the
+ * destination IID at a fixed position from the radio interrupt.
+ * The descriptor is a dispatch byte (from the range RFC 4944 keeps
+ * reserved) followed by the 8-byte destination IID. The end-to-end
+ * sequence number is already carried in the anycast MAC address. */
+#define ORPL_DESC_DISPATCH 0x4e
+#define ORPL_DESC_LEN      9
+/* The last bit of the dispatch byte carries the traffic class */
+#define ORPL_DESC_CLASS_MASK 0x01
+#define ORPL_DESC_IS_DISPATCH(d) (((d) & ~ORPL_DESC_CLASS_MASK) == ORPL_DESC_DISPATCH)
+#endif /* WITH_ORPL_ROUTING_DESC */
+
+#if WITH_ORPL_TRAFFIC_CLASS && !WITH_ORPL_ROUTING_DESC
+#error WITH_ORPL_TRAFFIC_CLASS needs WITH_ORPL_ROUTING_DESC, which carries the class
+#endif
+
+#if WITH_ORPL_ACK_SLOTS
+/* Number of ACK slots. When several neighbors want to forward an anycast,
+ * the ones making the most progress ack in the first slot, the others
+ * wait and give up if they hear an ACK first. */
+#ifdef ORPL_CONF_ACK_SLOTS
+#define ORPL_ACK_SLOTS ORPL_CONF_ACK_SLOTS
+#else /* ORPL_CONF_ACK_SLOTS */
+#define ORPL_ACK_SLOTS 2
+#endif /* ORPL_CONF_ACK_SLOTS */
+
+/* Duration of an ACK slot: long enough for the SFD of an ACK sent in the
+ * previous slot to be detected (turnaround, then preamble and SFD) */
+#ifdef ORPL_CONF_ACK_SLOT_TIME
+#define ORPL_ACK_SLOT_TIME ORPL_CONF_ACK_SLOT_TIME
+#else /* ORPL_CONF_ACK_SLOT_TIME */
+#define ORPL_ACK_SLOT_TIME (RTIMER_ARCH_SECOND / 2500)
+#endif /* ORPL_CONF_ACK_SLOT_TIME */
+
+/* Extra EDC progress (beyond ORPL_EDC_W) needed to move up by one slot */
+#ifdef ORPL_CONF_ACK_SLOT_EDC
+#define ORPL_ACK_SLOT_EDC ORPL_CONF_ACK_SLOT_EDC
+#else /* ORPL_CONF_ACK_SLOT_EDC */
+#define ORPL_ACK_SLOT_EDC EDC_DIVISOR
+#endif /* ORPL_CONF_ACK_SLOT_EDC */
+#endif /* WITH_ORPL_ACK_SLOTS */
+
+/* Counters of forwarding decisions, to measure wasted forwarding */
+struct orpl_anycast_stats {
+  uint32_t acked;      /* Anycasts we acked (and took) */
+  uint16_t cancelled;  /* ACKs given up because a better forwarder acked first */
+  uint32_t duplicates; /* Duplicates received, i.e. packets forwarded twice */
+};
+
+#if WITH_ORPL_TRAFFIC_CLASS
+/* Per traffic class counters of the anycasts we sent or forwarded */
+struct orpl_class_stats {
+  uint16_t delivered; /* Acked by a forwarder */
+  uint16_t dropped;   /* Given up after all transmissions */
+  uint32_t delay;     /* Total time from enqueuing to ACK, in clock ticks */
+};
+#endif /* WITH_ORPL_TRAFFIC_CLASS */
 
 /* The different link-layer addresses used for anycast */
 extern rimeaddr_t anycast_addr_up;
 extern rimeaddr_t anycast_addr_down;
 extern rimeaddr_t anycast_addr_nbr;
 extern rimeaddr_t anycast_addr_recover;
+#if WITH_ORPL_MCAST
+extern rimeaddr_t anycast_addr_mcast;
+#endif /* WITH_ORPL_MCAST */
 
 enum anycast_direction_e {
   direction_none,
   direction_up,
   direction_down,
   direction_nbr,
-  direction_recover
+  direction_recover,
+  direction_mcast
 };
 
 struct anycast_parsing_info {
   enum anycast_direction_e direction;
   uint16_t neighbor_edc;
   uint32_t seqno;
+#if WITH_ORPL_PATH_HINT
+  uint8_t hint; /* Path hint band + 1, 0 if none */
+#endif /* WITH_ORPL_PATH_HINT */
+#if WITH_ORPL_TRAFFIC_CLASS
+  uint8_t traffic_class;
+#endif /* WITH_ORPL_TRAFFIC_CLASS */
 };
 
 /* Set the destination link-layer address in packetbuf in case of anycast */
@@ -71,6 +147,19 @@ void orpl_anycast_set_packetbuf_addr();
 struct anycast_parsing_info orpl_anycast_802154_frame_parse(uint8_t *data, uint8_t len);
 /* Parse a modified 802.15.4 frame and decides whether to ack it or not */
 int orpl_anycast_802154_frame_must_ack(uint8_t *data, uint8_t len);
+/* Returns 1 if the anycast in packetbuf is an app-layer duplicate, and
+ * records it otherwise. Also detects loops from upward duplicates. */
+int orpl_anycast_is_duplicate();
+/* Called when a duplicate anycast was received and dropped */
+void orpl_anycast_duplicate_received();
+/* Returns the anycast forwarding counters */
+const struct orpl_anycast_stats *orpl_anycast_get_stats();
+#if WITH_ORPL_TRAFFIC_CLASS
+/* Called by CSMA when it is done with an anycast of a given class */
+void orpl_anycast_class_done(uint8_t traffic_class, int delivered, clock_time_t delay);
+/* Returns the counters of a traffic class */
+const struct orpl_class_stats *orpl_anycast_get_class_stats(uint8_t traffic_class);
+#endif /* WITH_ORPL_TRAFFIC_CLASS */
 /* Anycast-specific inits */
 void orpl_anycast_init();
 
@@ -0,0 +1,336 @@
+/*
+ * Copyright (c) 2014, Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+
+
+/**
+ * \file
+ *         Host side of the split ORPL root (see orpl-br.h). An RDC driver
+ *         that hands unframed packets to the radio over SLIP, and the
+ *         handler of the reports, frames and ACK information the radio
+ *         sends back. The routing set, EDC, blacklist and acked-down
+ *         history all live here; the radio only gets a digest of them.
+ */
+
+#include "contiki.h"
+#include "net/netstack.h"
+#include "net/packetbuf.h"
+#include "net/queuebuf.h"
+#include "net/rpl/rpl.h"
+#include "packetutils.h"
+#include "border-router.h"
+#include "border-router-cmds.h"
+#include "orpl.h"
+#include "orpl-anycast.h"
+#include "orpl-routing-set.h"
+#if WITH_ORPL_ENERGY
+#include "orpl-energy.h"
+#endif /* WITH_ORPL_ENERGY */
+#include "orpl-br.h"
+#include <string.h>
+
+#if WITH_ORPL && WITH_ORPL_BR_HOST
+
+#define DEBUG 0
+#if DEBUG
+#include <stdio.h>
+#define PRINTF(...) printf(__VA_ARGS__)
+#else
+#define PRINTF(...)
+#endif
+
+/* Packets handed to the radio, by session id. The packet is kept
+ * along with its attributes, as csma may send it again from the
+ * callback, e.g. for false positive recovery. */
+#define MAX_CALLBACKS 16
+struct tx_callback {
+  mac_callback_t cback;
+  void *ptr;
+  uint16_t len;
+  uint8_t data[PACKETBUF_SIZE + PACKETBUF_HDR_SIZE];
+  struct packetbuf_attr attrs[PACKETBUF_NUM_ATTRS];
+  struct packetbuf_addr addrs[PACKETBUF_NUM_ADDRS];
+};
+static struct tx_callback callbacks[MAX_CALLBACKS];
+static int callback_pos;
+
+/* The last digest pushed to the radio, and when */
+static uint8_t last_digest[ORPL_BR_DIGEST_LEN];
+static clock_time_t last_push;
+static struct ctimer digest_timer;
+
+/* Apply the neighbor information of an ACK, as ContikiMAC does
+ * when it gets the ACK itself */
+static void
+ack_info_input(const uint8_t *info, int is_broadcast)
+{
+  const rimeaddr_t *addr = (const rimeaddr_t *)info;
+  rpl_set_parent_rank((uip_lladdr_t *)addr, (info[RIMEADDR_SIZE] << 8) | info[RIMEADDR_SIZE + 1]);
+#if WITH_ORPL_ENERGY
+  orpl_energy_set_neighbor((uip_lladdr_t *)addr, info[RIMEADDR_SIZE + 2]);
+#endif /* WITH_ORPL_ENERGY */
+  if(is_broadcast) {
+    orpl_broadcast_acked(addr);
+  } else {
+    orpl_strobe_acked(addr);
+  }
+}
+
+/* The radio is done with a packet. Restore it in packetbuf and call
+ * back csma, with the node that acked it as receiver. */
+static void
+tx_done(uint8_t sid, uint8_t status, uint8_t tx, const uint8_t *ack_info)
+{
+  struct tx_callback *callback;
+  if(sid >= MAX_CALLBACKS) {
+    PRINTF("orpl-br: too high session id %u\n", sid);
+    return;
+  }
+  callback = &callbacks[sid];
+  packetbuf_clear();
+  packetbuf_copyfrom(callback->data, callback->len);
+  packetbuf_attr_copyfrom(callback->attrs, callback->addrs);
+  if(ack_info != NULL && status == MAC_TX_OK
+      && !rimeaddr_cmp(packetbuf_addr(PACKETBUF_ADDR_RECEIVER), &rimeaddr_null)
+      && !rimeaddr_cmp((const rimeaddr_t *)ack_info, &rimeaddr_null)) {
+    ack_info_input(ack_info, 0);
+    /* Set link-layer address of the node that acked the packet */
+    packetbuf_set_addr(PACKETBUF_ADDR_RECEIVER, (const rimeaddr_t *)ack_info);
+    if(packetbuf_attr(PACKETBUF_ATTR_ORPL_DIRECTION) == direction_down) {
+      orpl_acked_down_insert(orpl_packetbuf_seqno(), (const rimeaddr_t *)ack_info);
+    }
+  }
+  mac_call_sent_callback(callback->cback, callback->ptr, status, tx);
+}
+
+/* Report from a plain slip-radio, without ACK information. Called by
+ * border_router_cmd_handler. */
+void
+packet_sent(uint8_t sessionid, uint8_t status, uint8_t tx)
+{
+  tx_done(sessionid, status, tx, NULL);
+}
+
+/* A frame received by the radio: sender and receiver addresses,
+ * attributes, then the frame without its header */
+static void
+frame_input(const uint8_t *data, int len)
+{
+  int pos = 2 + 2 * RIMEADDR_SIZE;
+  int size;
+
+  packetbuf_clear();
+  size = packetutils_deserialize_atts(data + pos, len - pos);
+  if(size < 0) {
+    PRINTF("orpl-br: illegal packet attributes\n");
+    return;
+  }
+  pos += size;
+  if(len - pos > PACKETBUF_SIZE) {
+    PRINTF("orpl-br: too long input %d\n", len - pos);
+    return;
+  }
+  packetbuf_copyfrom(data + pos, len - pos);
+  packetbuf_set_addr(PACKETBUF_ADDR_SENDER, (const rimeaddr_t *)(data + 2));
+  packetbuf_set_addr(PACKETBUF_ADDR_RECEIVER, (const rimeaddr_t *)(data + 2 + RIMEADDR_SIZE));
+  NETSTACK_MAC.input();
+}
+
+/* The digest of our ORPL state that the radio needs to ack anycasts */
+static void
+digest_build(uint8_t *digest)
+{
+  rpl_rank_t edc = orpl_current_edc();
+  digest[ORPL_BR_DIGEST_EDC] = edc >> 8;
+  digest[ORPL_BR_DIGEST_EDC + 1] = edc & 0xff;
+  digest[ORPL_BR_DIGEST_FLAGS] = orpl_is_root() ? ORPL_BR_DIGEST_FLAG_ROOT : 0;
+  memcpy(digest + ORPL_BR_DIGEST_IPADDR, &global_ipv6, sizeof(uip_ipaddr_t));
+  memcpy(digest + ORPL_BR_DIGEST_RS, orpl_routing_set_get_active(), sizeof(struct routing_set_s));
+}
+
+/* Pushes the digest to the radio now */
+void
+orpl_br_host_push_digest()
+{
+  uint8_t buf[2 + ORPL_BR_DIGEST_LEN];
+  buf[0] = '!';
+  buf[1] = ORPL_BR_CMD_DIGEST;
+  digest_build(buf + 2);
+  memcpy(last_digest, buf + 2, ORPL_BR_DIGEST_LEN);
+  last_push = clock_time();
+  write_to_slip(buf, sizeof(buf));
+}
+
+/* Push the digest again if it changed, or if it is getting old */
+static void
+digest_check(void *ptr)
+{
+  uint8_t digest[ORPL_BR_DIGEST_LEN];
+  /* Nothing to push before we are part of a DAG */
+  if(orpl_current_edc() != 0xffff) {
+    digest_build(digest);
+    if(memcmp(digest, last_digest, ORPL_BR_DIGEST_LEN)
+        || clock_time() - last_push >= ORPL_BR_DIGEST_REFRESH) {
+      orpl_br_host_push_digest();
+    }
+  }
+  ctimer_reset(&digest_timer);
+}
+
+/* Handles the ORPL commands coming from the radio */
+int
+orpl_br_host_cmd_handler(const uint8_t *data, int len)
+{
+  if(data[0] != '!' || command_context != CMD_CONTEXT_RADIO) {
+    return 0;
+  }
+  switch(data[1]) {
+  case ORPL_BR_CMD_REPORT:
+    if(len < 5 + ORPL_BR_ACK_INFO_LEN) {
+      /* Plain slip-radio report, left to border_router_cmd_handler */
+      return 0;
+    }
+    tx_done(data[2], data[3], data[4], data + 5);
+    return 1;
+  case ORPL_BR_CMD_INPUT:
+    if(len > 2 + 2 * RIMEADDR_SIZE) {
+      frame_input(data, len);
+    }
+    return 1;
+  case ORPL_BR_CMD_BCAST_DONE:
+    if(len >= 3 + data[2] * ORPL_BR_ACK_INFO_LEN) {
+      int i;
+      for(i = 0; i < data[2]; i++) {
+        ack_info_input(data + 3 + i * ORPL_BR_ACK_INFO_LEN, 1);
+      }
+      orpl_broadcast_done();
+    }
+    return 1;
+  case ORPL_BR_CMD_DIGEST:
+    /* The radio has no digest, e.g. it just booted */
+    orpl_br_host_push_digest();
+    return 1;
+  }
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+static void
+send_packet(mac_callback_t sent, void *ptr)
+{
+  /* Header, receiver, 3 bytes per packet attribute, and the packet */
+  uint8_t buf[3 + RIMEADDR_SIZE + 1 + PACKETBUF_NUM_ATTRS * 3 + PACKETBUF_SIZE];
+  struct tx_callback *callback;
+  int pos, size;
+
+  packetbuf_set_addr(PACKETBUF_ADDR_SENDER, &rimeaddr_node_addr);
+  packetbuf_set_attr(PACKETBUF_ATTR_MAC_ACK, 1);
+
+  buf[0] = '!';
+  buf[1] = ORPL_BR_CMD_SEND;
+  buf[2] = callback_pos;
+  rimeaddr_copy((rimeaddr_t *)(buf + 3), packetbuf_addr(PACKETBUF_ADDR_RECEIVER));
+  pos = 3 + RIMEADDR_SIZE;
+  size = packetutils_serialize_atts(buf + pos, sizeof(buf) - pos);
+  if(size < 0 || pos + size + packetbuf_totlen() > sizeof(buf)) {
+    PRINTF("orpl-br: send failed, too large packet\n");
+    mac_call_sent_callback(sent, ptr, MAC_TX_ERR_FATAL, 1);
+    return;
+  }
+  pos += size;
+  memcpy(buf + pos, packetbuf_hdrptr(), packetbuf_totlen());
+  pos += packetbuf_totlen();
+
+  callback = &callbacks[callback_pos];
+  callback->cback = sent;
+  callback->ptr = ptr;
+  callback->len = packetbuf_copyto(callback->data);
+  packetbuf_attr_copyto(callback->attrs, callback->addrs);
+  callback_pos = (callback_pos + 1) % MAX_CALLBACKS;
+
+  write_to_slip(buf, pos);
+}
+/*---------------------------------------------------------------------------*/
+static void
+send_list(mac_callback_t sent, void *ptr, struct rdc_buf_list *buf_list)
+{
+  if(buf_list != NULL) {
+    queuebuf_to_packetbuf(buf_list->buf);
+    send_packet(sent, ptr);
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+packet_input(void)
+{
+  /* Frames come from the radio as ORPL_BR_CMD_INPUT commands */
+  PRINTF("orpl-br: dropping raw frame %u\n", packetbuf_datalen());
+}
+/*---------------------------------------------------------------------------*/
+static int
+on(void)
+{
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+static int
+off(int keep_radio_on)
+{
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+static unsigned short
+channel_check_interval(void)
+{
+  /* The wake-up interval of the network, used for csma backoffs */
+  return (CLOCK_SECOND * (uint32_t)CONTIKIMAC_CONF_CYCLE_TIME) / RTIMER_ARCH_SECOND;
+}
+/*---------------------------------------------------------------------------*/
+static void
+init(void)
+{
+  callback_pos = 0;
+  ctimer_set(&digest_timer, ORPL_BR_DIGEST_PERIOD, digest_check, NULL);
+}
+/*---------------------------------------------------------------------------*/
+const struct rdc_driver orpl_br_host_rdc_driver = {
+  "orpl-br-host",
+  init,
+  send_packet,
+  send_list,
+  packet_input,
+  on,
+  off,
+  channel_check_interval,
+};
+/*---------------------------------------------------------------------------*/
+
+#endif /* WITH_ORPL && WITH_ORPL_BR_HOST */
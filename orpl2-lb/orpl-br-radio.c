@@ -0,0 +1,413 @@
+/*
+ * Copyright (c) 2014, Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+
+
+/**
+ * \file
+ *         Radio side of the split ORPL root (see orpl-br.h). Runs
+ *         ContikiMAC-ORPL and the anycast module on the mote, and stands
+ *         in for orpl.c: the state they query is taken from the digest
+ *         pushed by the host, and the ACK information they report is
+ *         relayed back to the host.
+ */
+
+#include "contiki.h"
+#include "net/netstack.h"
+#include "net/packetbuf.h"
+#include "net/uip.h"
+#include "cmd.h"
+#include "packetutils.h"
+#include "orpl.h"
+#include "orpl-anycast.h"
+#include "orpl-routing-set.h"
+#if WITH_ORPL_ENERGY
+#include "orpl-energy.h"
+#endif /* WITH_ORPL_ENERGY */
+#include "orpl-br.h"
+#if WITH_ORPL_FRAG
+#include "net/sicslowpan.h"
+#endif /* WITH_ORPL_FRAG */
+#include <string.h>
+
+#if WITH_ORPL && WITH_ORPL_BR_RADIO
+
+#define DEBUG 0
+#if DEBUG
+#include <stdio.h>
+#define PRINTF(...) printf(__VA_ARGS__)
+#else
+#define PRINTF(...)
+#endif
+
+/* The global IPv6 address of the host */
+uip_ipaddr_t global_ipv6;
+
+/* The logging tools report the RPL state of the node, which lives
+ * on the host */
+rpl_instance_t *default_instance;
+int forwarder_set_size;
+
+/* The digest last pushed by the host */
+static int has_digest;
+static rpl_rank_t digest_edc = 0xffff;
+static uint8_t digest_flags;
+
+/* Session ids of the packets being sent for the host */
+#define MAX_SESSIONS 16
+static uint8_t packet_ids[MAX_SESSIONS];
+static int packet_pos;
+
+/* ACK information of the last ACK received, and of all ACKs received
+ * during the current broadcast. Broadcast ACKs are only relayed when
+ * the broadcast is done, as SLIP is not written while strobing. */
+static uint8_t last_ack_info[ORPL_BR_ACK_INFO_LEN];
+#define MAX_BCAST_ACKS 16
+static uint8_t bcast_buf[3 + MAX_BCAST_ACKS * ORPL_BR_ACK_INFO_LEN];
+static int bcast_count;
+
+/* History of packets acked down, for recovery ACKs. The host keeps
+ * its own, this one is fed by ContikiMAC directly. */
+struct packet_acked_down_s {
+  uint32_t seqno;
+  rimeaddr_t child;
+};
+#define ACKED_DOWN_SIZE 8
+static struct packet_acked_down_s acked_down[ACKED_DOWN_SIZE];
+
+/* Frames relayed to the host */
+static uint8_t input_buf[2 + 2 * RIMEADDR_SIZE + 1 + PACKETBUF_NUM_ATTRS * 3 + PACKETBUF_SIZE];
+
+/* Set the 32-bit ORPL sequence number in packetbuf */
+void
+orpl_packetbuf_set_seqno(uint32_t seqno)
+{
+  packetbuf_set_attr(PACKETBUF_ATTR_ORPL_SEQNO0, seqno >> 16);
+  packetbuf_set_attr(PACKETBUF_ATTR_ORPL_SEQNO1, seqno);
+}
+
+/* Get the 32-bit ORPL sequence number from packetbuf */
+uint32_t
+orpl_packetbuf_seqno()
+{
+  return ((uint32_t)packetbuf_attr(PACKETBUF_ATTR_ORPL_SEQNO0) << 16) |
+    packetbuf_attr(PACKETBUF_ATTR_ORPL_SEQNO1);
+}
+
+#if WITH_ORPL_FRAG
+/* Get the offset of the anycast fragment in packetbuf, in 8-byte units,
+ * as orpl.c does. Used by the RDC's duplicate detection. */
+uint8_t
+orpl_packetbuf_frag_offset()
+{
+  uint8_t *data = packetbuf_dataptr();
+  if(packetbuf_datalen() >= ORPL_DESC_LEN + SICSLOWPAN_FRAGN_HDR_LEN
+      && ORPL_DESC_IS_DISPATCH(data[0])
+      && (data[ORPL_DESC_LEN] & 0xf8) == SICSLOWPAN_DISPATCH_FRAGN) {
+    return data[ORPL_DESC_LEN + 4];
+  }
+  return 0;
+}
+#endif /* WITH_ORPL_FRAG */
+
+/* Returns 1 if the host is root of ORPL */
+int
+orpl_is_root()
+{
+  return (digest_flags & ORPL_BR_DIGEST_FLAG_ROOT) != 0;
+}
+
+/* Returns the EDC of the host, 0xffff until we have a digest */
+rpl_rank_t
+orpl_current_edc()
+{
+  return digest_edc;
+}
+
+#if WITH_ORPL_MULTI_SINK
+/* Returns 1 if ipaddr is the virtual sink address */
+int
+orpl_is_sink_ipaddr(const uip_ipaddr_t *ipaddr)
+{
+  return ipaddr->u16[4] == 0 && ipaddr->u16[5] == 0 && ipaddr->u16[6] == 0
+      && ipaddr->u8[14] == (ORPL_SINK_IID >> 8)
+      && ipaddr->u8[15] == (ORPL_SINK_IID & 0xff);
+}
+#endif /* WITH_ORPL_MULTI_SINK */
+
+/* The blacklist is kept on the host. Packets it blacklisted are
+ * recovered downwards, and the root acks all upward anycasts anyway. */
+int
+orpl_blacklist_contains(uint32_t seqno)
+{
+  return 0;
+}
+
+/* Link estimates are kept on the host. Without them, anycasts to
+ * neighbors are only acked when addressed to the host itself. */
+int
+orpl_is_reachable_neighbor(const uip_ipaddr_t *ipaddr)
+{
+  return 0;
+}
+
+/* A packet was routed downwards successfully, insert it into our
+ * history. Used during false positive recovery. */
+void
+orpl_acked_down_insert(uint32_t seqno, const rimeaddr_t *child)
+{
+  int i;
+  for(i = ACKED_DOWN_SIZE - 1; i > 0; --i) {
+    acked_down[i] = acked_down[i - 1];
+  }
+  acked_down[0].seqno = seqno;
+  rimeaddr_copy(&acked_down[0].child, child);
+}
+
+/* Returns 1 if a given packet is in the acked down history */
+int
+orpl_acked_down_contains(uint32_t seqno, const rimeaddr_t *child)
+{
+  int i;
+  for(i = 0; i < ACKED_DOWN_SIZE; ++i) {
+    if(seqno == acked_down[i].seqno && rimeaddr_cmp(child, &acked_down[i].child)) {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+/* Loops are only detected by forwarders, never at the root */
+void
+orpl_loop_detected(uint32_t seqno, const rimeaddr_t *sender)
+{
+}
+
+/* Called by ContikiMAC for every ACK, with the EDC of the acker */
+void
+rpl_set_parent_rank(const uip_lladdr_t *addr, rpl_rank_t rank)
+{
+  rimeaddr_copy((rimeaddr_t *)last_ack_info, (const rimeaddr_t *)addr);
+  last_ack_info[RIMEADDR_SIZE] = rank >> 8;
+  last_ack_info[RIMEADDR_SIZE + 1] = rank & 0xff;
+  last_ack_info[RIMEADDR_SIZE + 2] = 0;
+}
+
+#if WITH_ORPL_ENERGY
+/* Called by ContikiMAC for every ACK, with the energy of the acker */
+void
+orpl_energy_set_neighbor(const uip_lladdr_t *lladdr, uint8_t level)
+{
+  last_ack_info[RIMEADDR_SIZE + 2] = level;
+}
+
+/* The host is mains-powered */
+uint8_t
+orpl_energy_remaining()
+{
+  return ORPL_ENERGY_FULL;
+}
+
+/* The host is mains-powered */
+rpl_rank_t
+orpl_energy_own_penalty()
+{
+  return 0;
+}
+#endif /* WITH_ORPL_ENERGY */
+
+/* Callback function for every ACK received while broadcasting */
+void
+orpl_broadcast_acked(const rimeaddr_t *receiver)
+{
+  if(bcast_count < MAX_BCAST_ACKS) {
+    memcpy(bcast_buf + 3 + bcast_count * ORPL_BR_ACK_INFO_LEN,
+        last_ack_info, ORPL_BR_ACK_INFO_LEN);
+    bcast_count++;
+  }
+}
+
+/* Callback function for every ACK received while strobing an anycast.
+ * Relayed to the host along with the tx report. */
+void
+orpl_strobe_acked(const rimeaddr_t *receiver)
+{
+}
+
+/* Callback function at the end of a every broadcast */
+void
+orpl_broadcast_done()
+{
+  bcast_buf[0] = '!';
+  bcast_buf[1] = ORPL_BR_CMD_BCAST_DONE;
+  bcast_buf[2] = bcast_count;
+  cmd_send(bcast_buf, 3 + bcast_count * ORPL_BR_ACK_INFO_LEN);
+  bcast_count = 0;
+}
+/*---------------------------------------------------------------------------*/
+static void
+packet_sent(void *ptr, int status, int transmissions)
+{
+  uint8_t buf[5 + ORPL_BR_ACK_INFO_LEN];
+  buf[0] = '!';
+  buf[1] = ORPL_BR_CMD_REPORT;
+  buf[2] = *((uint8_t *)ptr);
+  buf[3] = status;
+  buf[4] = transmissions;
+  if(status == MAC_TX_OK) {
+    memcpy(buf + 5, last_ack_info, ORPL_BR_ACK_INFO_LEN);
+  } else {
+    memset(buf + 5, 0, ORPL_BR_ACK_INFO_LEN);
+  }
+  cmd_send(buf, sizeof(buf));
+}
+/*---------------------------------------------------------------------------*/
+static void
+send_input(const uint8_t *data, int len)
+{
+  int pos;
+  int size;
+
+  packet_ids[packet_pos] = data[2];
+
+  packetbuf_clear();
+  pos = 3 + RIMEADDR_SIZE;
+  size = packetutils_deserialize_atts(data + pos, len - pos);
+  if(size < 0) {
+    PRINTF("orpl-br: illegal packet attributes\n");
+    return;
+  }
+  pos += size;
+  len -= pos;
+  if(len > PACKETBUF_SIZE) {
+    len = PACKETBUF_SIZE;
+  }
+  memcpy(packetbuf_dataptr(), data + pos, len);
+  packetbuf_set_datalen(len);
+  packetbuf_set_addr(PACKETBUF_ADDR_SENDER, &rimeaddr_node_addr);
+  packetbuf_set_addr(PACKETBUF_ADDR_RECEIVER, (const rimeaddr_t *)(data + 3));
+
+  memset(last_ack_info, 0, ORPL_BR_ACK_INFO_LEN);
+  NETSTACK_MAC.send(packet_sent, &packet_ids[packet_pos]);
+
+  packet_pos = (packet_pos + 1) % MAX_SESSIONS;
+}
+
+/* Handles the commands coming from the host */
+int
+orpl_br_radio_cmd_handler(const uint8_t *data, int len)
+{
+  if(data[0] != '!') {
+    return 0;
+  }
+  switch(data[1]) {
+  case ORPL_BR_CMD_SEND:
+    if(len > 3 + RIMEADDR_SIZE) {
+      send_input(data, len);
+    }
+    return 1;
+  case ORPL_BR_CMD_DIGEST:
+    if(len == 2 + ORPL_BR_DIGEST_LEN) {
+      data += 2;
+      digest_edc = (data[ORPL_BR_DIGEST_EDC] << 8) | data[ORPL_BR_DIGEST_EDC + 1];
+      digest_flags = data[ORPL_BR_DIGEST_FLAGS];
+      memcpy(&global_ipv6, data + ORPL_BR_DIGEST_IPADDR, sizeof(uip_ipaddr_t));
+      memcpy(orpl_routing_set_get_active(), data + ORPL_BR_DIGEST_RS, sizeof(struct routing_set_s));
+      has_digest = 1;
+    }
+    return 1;
+  }
+  return 0;
+}
+
+/* Returns 1 once the radio got a digest from the host */
+int
+orpl_br_radio_has_digest()
+{
+  return has_digest;
+}
+
+/* Asks the host for a digest */
+void
+orpl_br_radio_request_digest()
+{
+  uint8_t buf[2];
+  buf[0] = '!';
+  buf[1] = ORPL_BR_CMD_DIGEST;
+  cmd_send(buf, sizeof(buf));
+}
+
+/* Initializes the routing set and anycast modules of the radio */
+void
+orpl_br_radio_init()
+{
+  orpl_routing_set_init();
+  orpl_anycast_init();
+}
+/*---------------------------------------------------------------------------*/
+static void
+init(void)
+{
+  packet_pos = 0;
+  bcast_count = 0;
+}
+/*---------------------------------------------------------------------------*/
+static void
+input(void)
+{
+  int pos;
+  int size;
+
+  input_buf[0] = '!';
+  input_buf[1] = ORPL_BR_CMD_INPUT;
+  rimeaddr_copy((rimeaddr_t *)(input_buf + 2), packetbuf_addr(PACKETBUF_ADDR_SENDER));
+  rimeaddr_copy((rimeaddr_t *)(input_buf + 2 + RIMEADDR_SIZE), packetbuf_addr(PACKETBUF_ADDR_RECEIVER));
+  pos = 2 + 2 * RIMEADDR_SIZE;
+  size = packetutils_serialize_atts(input_buf + pos, sizeof(input_buf) - pos);
+  if(size < 0 || pos + size + packetbuf_datalen() > sizeof(input_buf)) {
+    PRINTF("orpl-br: dropping too large input\n");
+    return;
+  }
+  pos += size;
+  memcpy(input_buf + pos, packetbuf_dataptr(), packetbuf_datalen());
+  pos += packetbuf_datalen();
+  cmd_send(input_buf, pos);
+}
+/*---------------------------------------------------------------------------*/
+const struct network_driver orpl_br_radio_driver = {
+  "orpl-br-radio",
+  init,
+  input
+};
+/*---------------------------------------------------------------------------*/
+
+#endif /* WITH_ORPL && WITH_ORPL_BR_RADIO */
@@ -0,0 +1,121 @@
+/*
+ * Copyright (c) 2014, Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+
+
+/**
+ * \file
+ *         Split ORPL root: the ORPL state of the root runs in a Linux
+ *         host daemon (orpl-br-host.c), and a mote relays 802.15.4 frames
+ *         (orpl-br-radio.c). This file defines the commands exchanged over
+ *         SLIP, as slip-cmd messages starting with '!'.
+ *
+ *         The radio acks anycasts itself, in the softack interrupt. It
+ *         takes its decisions from a digest of the host's ORPL state,
+ *         pushed by the host whenever it changes.
+ */
+
+#ifndef __ORPL_BR_H__
+#define __ORPL_BR_H__
+
+#include "contiki.h"
+#include "net/netstack.h"
+#include "orpl-routing-set.h"
+
+/* host->radio: !S sid receiver[8] atts payload
+ * The payload is not framed: the radio adds the ContikiMAC and
+ * 802.15.4 headers, and the anycast address. */
+#define ORPL_BR_CMD_SEND         'S'
+/* radio->host: !R sid status transmissions acker[8] edc[2] energy[1]
+ * acker is the node that acked the anycast, if any */
+#define ORPL_BR_CMD_REPORT       'R'
+/* radio->host: !I sender[8] receiver[8] atts payload
+ * A frame the radio acked or received as broadcast, header removed */
+#define ORPL_BR_CMD_INPUT        'I'
+/* radio->host: !B count {addr[8] edc[2] energy[1]}*count
+ * End of a broadcast, with the neighbors that acked it */
+#define ORPL_BR_CMD_BCAST_DONE   'B'
+/* host->radio: !O digest
+ * radio->host: !O without payload, a digest request sent by the radio
+ * at boot (slip-dev drops the '?' messages of the radio) */
+#define ORPL_BR_CMD_DIGEST       'O'
+
+/* Per-neighbor information relayed from the ACKs, as in the
+ * reports and broadcast done commands */
+#define ORPL_BR_ACK_INFO_LEN     11
+
+/* Digest of the ORPL state the radio needs to ack anycasts:
+ * edc[2] flags[1] global_ipv6[16] routing_set[ROUTING_SET_M/8] */
+#define ORPL_BR_DIGEST_EDC       0
+#define ORPL_BR_DIGEST_FLAGS     2
+#define ORPL_BR_DIGEST_IPADDR    3
+#define ORPL_BR_DIGEST_RS        19
+#define ORPL_BR_DIGEST_LEN       (ORPL_BR_DIGEST_RS + sizeof(struct routing_set_s))
+
+#define ORPL_BR_DIGEST_FLAG_ROOT 0x01
+
+/* Interval at which the host checks whether the digest changed */
+#ifdef ORPL_CONF_BR_DIGEST_PERIOD
+#define ORPL_BR_DIGEST_PERIOD ORPL_CONF_BR_DIGEST_PERIOD
+#else /* ORPL_CONF_BR_DIGEST_PERIOD */
+#define ORPL_BR_DIGEST_PERIOD (2 * CLOCK_SECOND)
+#endif /* ORPL_CONF_BR_DIGEST_PERIOD */
+
+/* The digest is pushed at least this often, in case the radio rebooted */
+#ifdef ORPL_CONF_BR_DIGEST_REFRESH
+#define ORPL_BR_DIGEST_REFRESH ORPL_CONF_BR_DIGEST_REFRESH
+#else /* ORPL_CONF_BR_DIGEST_REFRESH */
+#define ORPL_BR_DIGEST_REFRESH (60 * CLOCK_SECOND)
+#endif /* ORPL_CONF_BR_DIGEST_REFRESH */
+
+/* Host side */
+/* RDC driver handing the packets to the radio */
+extern const struct rdc_driver orpl_br_host_rdc_driver;
+/* Handles the ORPL commands coming from the radio, to be listed before
+ * the border router's own handler in CMD_HANDLERS */
+int orpl_br_host_cmd_handler(const uint8_t *data, int len);
+/* Pushes the digest to the radio now */
+void orpl_br_host_push_digest();
+
+/* Radio side */
+/* Network driver relaying the frames received to the host */
+extern const struct network_driver orpl_br_radio_driver;
+/* Initializes the routing set and anycast modules of the radio */
+void orpl_br_radio_init();
+/* Handles the commands coming from the host */
+int orpl_br_radio_cmd_handler(const uint8_t *data, int len);
+/* Returns 1 once the radio got a digest from the host */
+int orpl_br_radio_has_digest();
+/* Asks the host for a digest */
+void orpl_br_radio_request_digest();
+
+#endif /* __ORPL_BR_H__ */
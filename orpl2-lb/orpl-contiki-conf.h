@@ -46,28 +46,162 @@
 #define WITH_ORPL_LB 1
 
 #if WITH_ORPL_LB
-#define WITH_ORPL_LB_DIO_TARGET 0
+/* Network-wide duty-cycle objective computed by the root, carried by DIOs */
+#define WITH_ORPL_LB_DIO_TARGET 1
+/* Fixed-point PI control of the wake-up interval */
+#define WITH_ORPL_LB_CTRL 1
 #else /*WITH_ORPL_LB*/
 #define WITH_ORPL_LB_DIO_TARGET 0
+#define WITH_ORPL_LB_CTRL 0
 #endif /*WITH_ORPL_LB*/
 
 #define WITH_VARIABLE_TXRATE 0
 
 #define WITH_BOOST_CPU 0
 
+/* Residual energy model, used to bias forwarder selection */
+#define WITH_ORPL_ENERGY 1
+
+/* Per-activity radio-on time accounting in ContikiMAC-ORPL */
+#define WITH_ORPL_RADIO_STATS 1
+
+/* Per-hop queueing and strobing delay, cumulated in the app_data trace */
+#define WITH_ORPL_DELAY_TRACE 1
+
+/* Fixed-position routing descriptor in anycast frames, allowing
+ * full 6LoWPAN IPHC/NHC compression of the IPv6 and UDP headers */
+#define WITH_ORPL_ROUTING_DESC 1
+
+/* Forward anycast frames from the RDC layer, without decompressing
+ * them into uip_buf. Needs WITH_ORPL_ROUTING_DESC. */
+#define WITH_ORPL_FAST_FORWARD WITH_ORPL_ROUTING_DESC
+
+/* Multiple roots sharing a virtual sink address (ORPL_SINK_IID).
+ * Roots need a second unicast address for it. */
+#define WITH_ORPL_MULTI_SINK 1
+#if WITH_ORPL_MULTI_SINK
+#undef UIP_CONF_DS6_ADDR_NBU
+#define UIP_CONF_DS6_ADDR_NBU 2
+#endif /* WITH_ORPL_MULTI_SINK */
+
+/* Score-based admission and eviction of neighbors, for deployments
+ * denser than NBR_TABLE_CONF_MAX_NEIGHBORS */
+#define WITH_ORPL_NBR_POLICY 1
+
+/* High beacon and routing set rates right after boot or joining, and
+ * link estimates seeded from the RSSI/LQI of the first frames */
+#define WITH_ORPL_BOOTSTRAP 1
+
+/* EDC-ordered ACK slots, so that the best forwarder takes anycasts
+ * and the others back off */
+#define WITH_ORPL_ACK_SLOTS 1
+
+/* Receiver-initiated duty cycling (orpl-rimac.c) instead of ContikiMAC-ORPL:
+ * nodes beacon their EDC, senders wait for a suitable forwarder */
+#define WITH_ORPL_RIMAC 0
+
+/* Latency statistics for each stage of the softack path, from the SFD
+ * to the ACK in the TX FIFO. Logged when "softack" is read on serial. */
+#define WITH_ORPL_SOFTACK_PROF 0
+
+/* Park anycast packets that csma gives up on in a Coffee file, and send
+ * them again once forwarders are back (orpl-dtn.c) */
+#define WITH_ORPL_DTN 0
+
+/* Nodes that turn an any-to-any flow down send the source a hint, which
+ * then lets forwarders turn the flow down earlier. Needs ACK slots. */
+#define WITH_ORPL_PATH_HINT WITH_ORPL_ACK_SLOTS
+
+/* Periodic compact reports of the ORPL state of each node, printed by the
+ * sink in the collect-view format (orpl-telemetry.c) */
+#define WITH_ORPL_TELEMETRY 0
+
+/* Multicast to groups of nodes advertised in routing sets, forwarded
+ * opportunistically down the DODAG (orpl-mcast.c). Needs fast forwarding. */
+#define WITH_ORPL_MCAST 0
+#if WITH_ORPL_MCAST
+#undef UIP_CONF_DS6_MADDR_NBU
+#define UIP_CONF_DS6_MADDR_NBU 2
+#endif /* WITH_ORPL_MCAST */
+
+/* Reliable datagrams for applications, with aggregated end-to-end ACKs
+ * piggybacked on traffic going back (orpl-rdgram.c) */
+#define WITH_ORPL_RDGRAM 0
+
+/* Traffic class in the routing descriptor of anycast frames. Urgent
+ * frames go first in CSMA queues and skip the ACK slots. */
+#define WITH_ORPL_TRAFFIC_CLASS 0
+
+/* 6LoWPAN fragmentation of anycast packets. Every fragment carries the
+ * routing descriptor and is forwarded on its own, only the destination
+ * reassembles them. Needs fast forwarding. */
+#define WITH_ORPL_FRAG 0
+#if WITH_ORPL_FRAG
+#undef SICSLOWPAN_CONF_FRAG
+#define SICSLOWPAN_CONF_FRAG 1
+#if !defined(UIP_CONF_BUFFER_SIZE) || UIP_CONF_BUFFER_SIZE < 256
+#undef UIP_CONF_BUFFER_SIZE
+#define UIP_CONF_BUFFER_SIZE 256
+#endif /* UIP_CONF_BUFFER_SIZE */
+#endif /* WITH_ORPL_FRAG */
+
+#if WITH_ORPL_PATH_HINT || WITH_ORPL_TELEMETRY
+/* Hint messages and reports need their own UDP connection */
+#undef UIP_CONF_UDP_CONNS
+#define UIP_CONF_UDP_CONNS (2 + WITH_ORPL_PATH_HINT + WITH_ORPL_TELEMETRY)
+#endif /* WITH_ORPL_PATH_HINT || WITH_ORPL_TELEMETRY */
 
 #else /*WITH_ORPL*/
 #define WITH_ORPL_LB 1
 #define WITH_ORPL_LB_DIO_TARGET 0
 #define WITH_VARIABLE_TXRATE 0
+#define WITH_ORPL_ENERGY 0
+#define WITH_ORPL_RADIO_STATS 0
+#define WITH_ORPL_DELAY_TRACE 0
+#define WITH_ORPL_ROUTING_DESC 0
+#define WITH_ORPL_FAST_FORWARD 0
+#define WITH_ORPL_MULTI_SINK 0
+#define WITH_ORPL_NBR_POLICY 0
+#define WITH_ORPL_BOOTSTRAP 0
+#define WITH_ORPL_ACK_SLOTS 0
+#define WITH_ORPL_RIMAC 0
+#define WITH_ORPL_SOFTACK_PROF 0
+#define WITH_ORPL_DTN 0
+#define WITH_ORPL_PATH_HINT 0
+#define WITH_ORPL_TELEMETRY 0
+#define WITH_ORPL_MCAST 0
+#define WITH_ORPL_RDGRAM 0
+#define WITH_ORPL_TRAFFIC_CLASS 0
+#define WITH_ORPL_FRAG 0
 
 #endif /*WITH_ORPL*/
 
+/* Root split between a Linux host running the ORPL state and a mote
+ * relaying frames (orpl-br.h). Set by the project-conf of each side. */
+#ifndef WITH_ORPL_BR_HOST
+#define WITH_ORPL_BR_HOST 0
+#endif /* WITH_ORPL_BR_HOST */
+#ifndef WITH_ORPL_BR_RADIO
+#define WITH_ORPL_BR_RADIO 0
+#endif /* WITH_ORPL_BR_RADIO */
+
 #define WITH_ORPL_LOADCTRL 0
 #ifdef WITH_ORPL_LOADCTRL
 #define QUEUEBUF_CONF_STATS 1
 #endif
 
+/* Store queued packets in managed memory, using only their actual
+ * length and the attributes that are set. Queuebuf descriptors are
+ * cheap, so we allow many more of them; the actual limit is the
+ * size of the mmem pool, about the RAM of 4 fixed-size queuebufs. */
+#define QUEUEBUF_CONF_MMEM 1
+#if QUEUEBUF_CONF_MMEM
+#undef QUEUEBUF_CONF_NUM
+#define QUEUEBUF_CONF_NUM 16
+#undef MMEM_CONF_SIZE
+#define MMEM_CONF_SIZE 1024
+#endif /* QUEUEBUF_CONF_MMEM */
+
 //#############################################################################"
 
 /* EDC is the objective function used by ORPL */
@@ -122,7 +256,11 @@
 
 /* Contiki netstack: RDC */
 #undef NETSTACK_CONF_RDC
+#if WITH_ORPL_RIMAC
+#define NETSTACK_CONF_RDC     orpl_rimac_driver
+#else /* WITH_ORPL_RIMAC */
 #define NETSTACK_CONF_RDC     contikimac_orpl_driver
+#endif /* WITH_ORPL_RIMAC */
 
 /* Contiki netstack: RADIO */
 #undef NETSTACK_CONF_RADIO
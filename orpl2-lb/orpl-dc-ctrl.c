@@ -0,0 +1,183 @@
+/*
+ * Copyright (c) 2014, Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+
+/**
+ * \file
+ *         A fixed-point PI controller for the ContikiMAC wake-up interval.
+ *         The controller is fed every period with the measured duty cycle
+ *         and a duty-cycle objective, and outputs a wake-up interval
+ *         bounded by [min, max]. The error is normalized by the objective,
+ *         so that the same gains apply whatever the traffic pattern.
+ *         The integral term is protected against windup: it is frozen
+ *         whenever the output saturates in the direction of the error.
+ */
+
+#include "orpl-dc-ctrl.h"
+
+/* Clamp a relative error to +/- 100% */
+static int16_t
+clamp_error(int32_t e)
+{
+  if(e > ORPL_DC_CTRL_UNIT) {
+    return ORPL_DC_CTRL_UNIT;
+  } else if(e < -ORPL_DC_CTRL_UNIT) {
+    return -ORPL_DC_CTRL_UNIT;
+  }
+  return (int16_t)e;
+}
+
+/* Maximum absolute value of the integral term, such that the integral
+ * alone can span the whole output range but not more */
+static int32_t
+integral_max(const struct orpl_dc_ctrl *c)
+{
+  int32_t n_steps = (c->max - c->min) / c->step + 1;
+  return n_steps * ORPL_DC_CTRL_UNIT * ORPL_DC_CTRL_UNIT / (ORPL_DC_CTRL_KI > 0 ? ORPL_DC_CTRL_KI : 1);
+}
+
+/* Compute the controller output for a given error and integral */
+static int32_t
+compute_output(const struct orpl_dc_ctrl *c, int16_t e, int32_t integral)
+{
+  /* u is expressed in 1/65536th of a step */
+  int32_t u = (int32_t)ORPL_DC_CTRL_KP * e + (int32_t)ORPL_DC_CTRL_KI * integral;
+  /* Scale down in two stages to stay within 32 bits */
+  return (int32_t)c->nominal + (u / ORPL_DC_CTRL_UNIT) * (int32_t)c->step / ORPL_DC_CTRL_UNIT;
+}
+
+/* Initialize a controller with a nominal output and output bounds */
+void
+orpl_dc_ctrl_init(struct orpl_dc_ctrl *c, uint32_t nominal,
+    uint32_t min, uint32_t max, uint32_t step)
+{
+  c->min = min;
+  c->max = max;
+  c->nominal = nominal;
+  c->step = step > 0 ? step : 1;
+  orpl_dc_ctrl_reset(c);
+}
+
+/* Reset the controller state, and output the nominal value */
+void
+orpl_dc_ctrl_reset(struct orpl_dc_ctrl *c)
+{
+  c->output = c->nominal;
+  c->integral = 0;
+  c->error = 0;
+  c->updates = 0;
+  c->saturations = 0;
+  c->periods_on_target = 0;
+  c->converged_at = 0;
+}
+
+/* Run one control period. Measured and target duty cycles are in the
+ * same unit (e.g. 1/100th of percent). Returns the new output. */
+uint32_t
+orpl_dc_ctrl_update(struct orpl_dc_ctrl *c, uint16_t measured, uint16_t target)
+{
+  int16_t e;
+  int32_t integral;
+  int32_t imax;
+  int32_t out;
+  int32_t prev = (int32_t)c->output;
+
+  if(target == 0) {
+    /* No objective, nothing to control */
+    return c->output;
+  }
+
+  /* Relative error, positive when we spend too much energy. A too high
+   * duty cycle results in a longer wake-up interval. */
+  e = clamp_error(((int32_t)measured - (int32_t)target) * ORPL_DC_CTRL_UNIT / (int32_t)target);
+  c->error = e;
+  c->updates++;
+
+  if(e <= ORPL_DC_CTRL_DEADBAND && e >= -ORPL_DC_CTRL_DEADBAND) {
+    /* On target: hold output and integral */
+    if(c->periods_on_target < 0xffff) {
+      c->periods_on_target++;
+    }
+    if(c->periods_on_target == ORPL_DC_CTRL_CONVERGED_PERIODS) {
+      c->converged_at = c->updates;
+    }
+    return c->output;
+  }
+  c->periods_on_target = 0;
+
+  /* Tentative integration */
+  imax = integral_max(c);
+  integral = c->integral + e;
+  if(integral > imax) {
+    integral = imax;
+  } else if(integral < -imax) {
+    integral = -imax;
+  }
+
+  out = compute_output(c, e, integral);
+
+  /* Limit the slew rate to one step per period */
+  if(out > prev + (int32_t)c->step) {
+    out = prev + (int32_t)c->step;
+  } else if(out < prev - (int32_t)c->step) {
+    out = prev - (int32_t)c->step;
+  }
+
+  /* Saturate, and freeze the integral if the saturation is in the
+   * direction of the error (anti-windup by conditional integration) */
+  if(out >= (int32_t)c->max) {
+    out = c->max;
+    c->saturations++;
+    if(e < 0) {
+      c->integral = integral;
+    }
+  } else if(out <= (int32_t)c->min) {
+    out = c->min;
+    c->saturations++;
+    if(e > 0) {
+      c->integral = integral;
+    }
+  } else {
+    c->integral = integral;
+  }
+
+  c->output = (uint32_t)out;
+  return c->output;
+}
+
+/* Returns 1 if the controller has been on target for
+ * ORPL_DC_CTRL_CONVERGED_PERIODS periods */
+int
+orpl_dc_ctrl_is_converged(const struct orpl_dc_ctrl *c)
+{
+  return c->periods_on_target >= ORPL_DC_CTRL_CONVERGED_PERIODS;
+}
@@ -0,0 +1,116 @@
+/*
+ * Copyright (c) 2014, Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+
+/**
+ * \file
+ *         Header file for orpl-dc-ctrl.c, a fixed-point PI controller
+ *         that adapts the ContikiMAC wake-up interval so that the
+ *         measured duty cycle of the node tracks a duty-cycle objective.
+ */
+
+#ifndef __ORPL_DC_CTRL_H__
+#define __ORPL_DC_CTRL_H__
+
+#include "contiki.h"
+
+/* Proportional gain, in 1/256th of a wake-up interval step per
+ * 100% relative duty-cycle error */
+#ifdef ORPL_CONF_DC_CTRL_KP
+#define ORPL_DC_CTRL_KP ORPL_CONF_DC_CTRL_KP
+#else /* ORPL_CONF_DC_CTRL_KP */
+#define ORPL_DC_CTRL_KP 256
+#endif /* ORPL_CONF_DC_CTRL_KP */
+
+/* Integral gain, in 1/256th of a wake-up interval step per
+ * 100% relative duty-cycle error and per control period */
+#ifdef ORPL_CONF_DC_CTRL_KI
+#define ORPL_DC_CTRL_KI ORPL_CONF_DC_CTRL_KI
+#else /* ORPL_CONF_DC_CTRL_KI */
+#define ORPL_DC_CTRL_KI 192
+#endif /* ORPL_CONF_DC_CTRL_KI */
+
+/* Relative error (in 1/256th) under which we consider the
+ * duty cycle to be on target */
+#ifdef ORPL_CONF_DC_CTRL_DEADBAND
+#define ORPL_DC_CTRL_DEADBAND ORPL_CONF_DC_CTRL_DEADBAND
+#else /* ORPL_CONF_DC_CTRL_DEADBAND */
+#define ORPL_DC_CTRL_DEADBAND 8
+#endif /* ORPL_CONF_DC_CTRL_DEADBAND */
+
+/* Number of consecutive periods on target before we report convergence */
+#ifdef ORPL_CONF_DC_CTRL_CONVERGED_PERIODS
+#define ORPL_DC_CTRL_CONVERGED_PERIODS ORPL_CONF_DC_CTRL_CONVERGED_PERIODS
+#else /* ORPL_CONF_DC_CTRL_CONVERGED_PERIODS */
+#define ORPL_DC_CTRL_CONVERGED_PERIODS 5
+#endif /* ORPL_CONF_DC_CTRL_CONVERGED_PERIODS */
+
+/* Fixed point unit used for relative errors and gains */
+#define ORPL_DC_CTRL_UNIT 256
+
+/* State of a duty-cycle controller. All values are integers, no
+ * floating point is needed at runtime. */
+struct orpl_dc_ctrl {
+  /* Output bounds and nominal output, in rtimer ticks */
+  uint32_t min;
+  uint32_t max;
+  uint32_t nominal;
+  /* Maximum output change per period, also used as output scale */
+  uint32_t step;
+  /* Current output (wake-up interval), in rtimer ticks */
+  uint32_t output;
+  /* Accumulated relative error (anti-windup protected) */
+  int32_t integral;
+  /* Last relative error, in 1/256th */
+  int16_t error;
+  /* Telemetry: number of updates, number of updates where the output
+   * saturated, consecutive updates within the deadband, and update
+   * count at which convergence was last reached */
+  uint16_t updates;
+  uint16_t saturations;
+  uint16_t periods_on_target;
+  uint16_t converged_at;
+};
+
+/* Initialize a controller with a nominal output and output bounds */
+void orpl_dc_ctrl_init(struct orpl_dc_ctrl *c, uint32_t nominal,
+    uint32_t min, uint32_t max, uint32_t step);
+/* Reset the controller state, and output the nominal value */
+void orpl_dc_ctrl_reset(struct orpl_dc_ctrl *c);
+/* Run one control period. Measured and target duty cycles are in the
+ * same unit (e.g. 1/100th of percent). Returns the new output. */
+uint32_t orpl_dc_ctrl_update(struct orpl_dc_ctrl *c, uint16_t measured, uint16_t target);
+/* Returns 1 if the controller has been on target for
+ * ORPL_DC_CTRL_CONVERGED_PERIODS periods */
+int orpl_dc_ctrl_is_converged(const struct orpl_dc_ctrl *c);
+
+#endif /* __ORPL_DC_CTRL_H__ */
@@ -0,0 +1,203 @@
+/*
+ * Copyright (c) 2014, Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+
+/**
+ * \file
+ *         Root-side duty-cycle objective for ORPL load balancing.
+ *         Every node reports its measured duty cycle to the root in its
+ *         data packets. The root periodically takes the mean duty cycle of
+ *         the ORPL_DC_OBJ_BOTTLENECK_K highest reports, i.e. of the nodes
+ *         that will die first, and uses it as the network-wide objective:
+ *         nodes that spend less than the bottleneck may shorten their
+ *         wake-up interval (which also makes forwarding to them cheaper)
+ *         without reducing the network lifetime. The objective is
+ *         disseminated in DIOs along with a lollipop sequence number.
+ */
+
+#include "orpl.h"
+#include "orpl-dc-objective.h"
+#include "net/rpl/rpl-private.h"
+#include <string.h>
+
+#if WITH_ORPL && WITH_ORPL_LB && WITH_ORPL_LB_DIO_TARGET
+
+#define DEBUG DEBUG_NONE
+#include "net/uip-debug.h"
+
+/* The current duty-cycle objective, in 1/100th of percent */
+uint16_t dio_dc_objective = 0;
+/* Sequence number (lollipop) of the current objective */
+uint8_t dio_dc_obj_sn = RPL_LOLLIPOP_INIT;
+
+/* Root only: the highest reports received during the current period,
+ * in decreasing order, plus the sum and count of all reports */
+static uint16_t top_reports[ORPL_DC_OBJ_BOTTLENECK_K];
+static uint8_t top_count;
+static uint32_t report_sum;
+static uint16_t report_count;
+
+/* Timer for periodic computation of the objective at the root */
+static struct ctimer objective_timer;
+
+/* Lollipop sequence number comparison, as defined in RFC 6550 7.2.
+ * Returns 1 if a is greater than b */
+static int
+lollipop_greater_than(uint8_t a, uint8_t b)
+{
+  int a_linear = a > RPL_LOLLIPOP_CIRCULAR_REGION;
+  int b_linear = b > RPL_LOLLIPOP_CIRCULAR_REGION;
+  if(a_linear && !b_linear) {
+    return (256 + b - a) > RPL_LOLLIPOP_SEQUENCE_WINDOWS;
+  } else if(!a_linear && b_linear) {
+    return (256 + a - b) <= RPL_LOLLIPOP_SEQUENCE_WINDOWS;
+  } else if(a_linear) {
+    return a > b;
+  } else {
+    uint8_t diff = (a - b) & RPL_LOLLIPOP_CIRCULAR_REGION;
+    return diff != 0 && diff <= RPL_LOLLIPOP_CIRCULAR_REGION / 2;
+  }
+}
+
+/* Root only: report the duty cycle measured by a node */
+void
+orpl_dc_objective_report(uint16_t node_dc)
+{
+  int i;
+  if(node_dc == 0 || !orpl_is_root()) {
+    return;
+  }
+  report_sum += node_dc;
+  report_count++;
+  /* Insert in the sorted array of highest reports */
+  for(i = top_count; i > 0 && top_reports[i - 1] < node_dc; i--) {
+    if(i < ORPL_DC_OBJ_BOTTLENECK_K) {
+      top_reports[i] = top_reports[i - 1];
+    }
+  }
+  if(i < ORPL_DC_OBJ_BOTTLENECK_K) {
+    top_reports[i] = node_dc;
+    if(top_count < ORPL_DC_OBJ_BOTTLENECK_K) {
+      top_count++;
+    }
+  }
+}
+
+/* Root only: compute a new objective from the reports of the last period */
+static void
+update_objective(void *ptr)
+{
+  ctimer_reset(&objective_timer);
+
+  if(top_count > 0) {
+    int i;
+    uint32_t bottleneck = 0;
+    uint16_t new_objective;
+
+    for(i = 0; i < top_count; i++) {
+      bottleneck += top_reports[i];
+    }
+    bottleneck /= top_count;
+
+    if(dio_dc_objective == 0) {
+      new_objective = bottleneck;
+    } else {
+      new_objective = (ORPL_DC_OBJ_ALPHA * bottleneck
+          + (100 - ORPL_DC_OBJ_ALPHA) * (uint32_t)dio_dc_objective) / 100;
+    }
+    if(new_objective < ORPL_DC_OBJ_MIN) {
+      new_objective = ORPL_DC_OBJ_MIN;
+    } else if(new_objective > ORPL_DC_OBJ_MAX) {
+      new_objective = ORPL_DC_OBJ_MAX;
+    }
+
+    ORPL_LOG("ORPL_LB: dc_objective %u -> %u (bottleneck %lu mean %lu n %u)\n",
+        dio_dc_objective, new_objective, bottleneck,
+        report_sum / report_count, report_count);
+
+    if(dio_dc_objective == 0
+        || (new_objective > dio_dc_objective && new_objective - dio_dc_objective >= ORPL_DC_OBJ_MIN_CHANGE)
+        || (new_objective < dio_dc_objective && dio_dc_objective - new_objective >= ORPL_DC_OBJ_MIN_CHANGE)) {
+      /* Disseminate the new objective right away */
+      dio_dc_objective = new_objective;
+      RPL_LOLLIPOP_INCREMENT(dio_dc_obj_sn);
+      if(default_instance != NULL) {
+        rpl_reset_dio_timer(default_instance);
+      }
+    }
+  }
+
+  /* Start a new period */
+  top_count = 0;
+  report_sum = 0;
+  report_count = 0;
+}
+
+/* Returns the objective as encoded in DIOs */
+uint8_t
+orpl_dc_objective_to_dio()
+{
+  uint16_t wire = dio_dc_objective / ORPL_DC_OBJ_WIRE_UNIT;
+  return wire > 0xff ? 0xff : wire;
+}
+
+/* Non-root: process an objective received in a DIO. Returns 1 if adopted */
+int
+orpl_dc_objective_dio_input(uint8_t sn, uint8_t dio_objective)
+{
+  if(orpl_is_root() || dio_objective == 0) {
+    return 0;
+  }
+  if(dio_dc_objective == 0 || lollipop_greater_than(sn, dio_dc_obj_sn)) {
+    dio_dc_objective = (uint16_t)dio_objective * ORPL_DC_OBJ_WIRE_UNIT;
+    dio_dc_obj_sn = sn;
+    PRINTF("ORPL_LB: adopting dc_objective %u (sn %u)\n", dio_dc_objective, sn);
+    return 1;
+  }
+  return 0;
+}
+
+/* Initialization. The root starts the periodic objective computation */
+void
+orpl_dc_objective_init(int is_root)
+{
+  dio_dc_objective = 0;
+  dio_dc_obj_sn = RPL_LOLLIPOP_INIT;
+  top_count = 0;
+  report_sum = 0;
+  report_count = 0;
+  if(is_root) {
+    ctimer_set(&objective_timer, ORPL_DC_OBJ_PERIOD, update_objective, NULL);
+  }
+}
+
+#endif /* WITH_ORPL && WITH_ORPL_LB && WITH_ORPL_LB_DIO_TARGET */
@@ -0,0 +1,99 @@
+/*
+ * Copyright (c) 2014, Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+
+/**
+ * \file
+ *         Header file for orpl-dc-objective.c, the root-side computation
+ *         of the network-wide duty-cycle objective used for load balancing,
+ *         and its dissemination in DIOs.
+ */
+
+#ifndef __ORPL_DC_OBJECTIVE_H__
+#define __ORPL_DC_OBJECTIVE_H__
+
+#include "contiki.h"
+
+/* Period at which the root recomputes the objective */
+#ifdef ORPL_CONF_DC_OBJ_PERIOD
+#define ORPL_DC_OBJ_PERIOD ORPL_CONF_DC_OBJ_PERIOD
+#else /* ORPL_CONF_DC_OBJ_PERIOD */
+#define ORPL_DC_OBJ_PERIOD (10 * 60 * CLOCK_SECOND)
+#endif /* ORPL_CONF_DC_OBJ_PERIOD */
+
+/* Number of highest reports considered as the bottleneck nodes */
+#ifdef ORPL_CONF_DC_OBJ_BOTTLENECK_K
+#define ORPL_DC_OBJ_BOTTLENECK_K ORPL_CONF_DC_OBJ_BOTTLENECK_K
+#else /* ORPL_CONF_DC_OBJ_BOTTLENECK_K */
+#define ORPL_DC_OBJ_BOTTLENECK_K 4
+#endif /* ORPL_CONF_DC_OBJ_BOTTLENECK_K */
+
+/* Bounds of the objective, in 1/100th of percent */
+#ifdef ORPL_CONF_DC_OBJ_MIN
+#define ORPL_DC_OBJ_MIN ORPL_CONF_DC_OBJ_MIN
+#else /* ORPL_CONF_DC_OBJ_MIN */
+#define ORPL_DC_OBJ_MIN 50
+#endif /* ORPL_CONF_DC_OBJ_MIN */
+
+#ifdef ORPL_CONF_DC_OBJ_MAX
+#define ORPL_DC_OBJ_MAX ORPL_CONF_DC_OBJ_MAX
+#else /* ORPL_CONF_DC_OBJ_MAX */
+#define ORPL_DC_OBJ_MAX 500
+#endif /* ORPL_CONF_DC_OBJ_MAX */
+
+/* Smoothing of the objective, in percent of the new value */
+#define ORPL_DC_OBJ_ALPHA 50
+
+/* Minimum change (in 1/100th of percent) before we bump the sequence
+ * number and disseminate a new objective */
+#define ORPL_DC_OBJ_MIN_CHANGE 10
+
+/* The DIO carries the objective on a single byte, in units of
+ * ORPL_DC_OBJ_WIRE_UNIT 1/100th of percent (i.e. up to 5.10%) */
+#define ORPL_DC_OBJ_WIRE_UNIT 2
+
+/* The current duty-cycle objective, in 1/100th of percent. 0 means
+ * the root has not set any, and nodes use their local default */
+extern uint16_t dio_dc_objective;
+/* Sequence number (lollipop) of the current objective */
+extern uint8_t dio_dc_obj_sn;
+
+/* Root only: report the duty cycle measured by a node */
+void orpl_dc_objective_report(uint16_t node_dc);
+/* Returns the objective as encoded in DIOs */
+uint8_t orpl_dc_objective_to_dio();
+/* Non-root: process an objective received in a DIO. Returns 1 if adopted */
+int orpl_dc_objective_dio_input(uint8_t sn, uint8_t dio_objective);
+/* Initialization. The root starts the periodic objective computation */
+void orpl_dc_objective_init(int is_root);
+
+#endif /* __ORPL_DC_OBJECTIVE_H__ */
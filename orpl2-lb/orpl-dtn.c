@@ -0,0 +1,326 @@
+/*
+ * Copyright (c) 2014, Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+
+
+/**
+ * \file
+ *         Delay-tolerant store-and-forward for ORPL. Anycast packets that
+ *         csma gives up on are parked in a Coffee file instead of being
+ *         dropped, and sent again at a controlled rate once forwarders are
+ *         reachable. A packet is parked with its payload and packetbuf
+ *         attributes, in one fixed-size record per slot. Only the slot
+ *         state and park time are kept in RAM.
+ *
+ *         During an outage, a single parked packet is tried with an
+ *         exponentially growing interval, up to ORPL_DTN_PROBE_MAX. Any
+ *         anycast acked by a forwarder, drained or not, resumes draining.
+ */
+
+#include "contiki.h"
+#include "cfs/cfs.h"
+#include "cfs/cfs-coffee.h"
+#include "net/netstack.h"
+#include "net/packetbuf.h"
+#include "net/queuebuf.h"
+#include "orpl.h"
+#include "orpl-anycast.h"
+#include "orpl-routing-set.h"
+#include "orpl-dtn.h"
+#include <string.h>
+
+#if WITH_ORPL && WITH_ORPL_DTN
+
+#define DTN_FILE "orpl-dtn"
+
+struct dtn_record {
+  uint8_t len;
+  uint8_t data[PACKETBUF_SIZE];
+  struct packetbuf_attr attrs[PACKETBUF_NUM_ATTRS];
+  struct packetbuf_addr addrs[PACKETBUF_NUM_ADDRS];
+};
+
+struct dtn_slot {
+  uint8_t used;
+  unsigned long park_time;
+};
+
+static struct dtn_slot slots[ORPL_DTN_SLOTS];
+/* Scratch record for slot reads and writes, one at a time */
+static struct dtn_record record;
+/* Slot being drained, and its sequence number, -1 if none */
+static int inflight_slot = -1;
+static uint32_t inflight_seqno;
+static clock_time_t probe_interval;
+static struct ctimer drain_timer;
+static struct orpl_dtn_stats stats;
+static int store_ok;
+
+static void drain(void *ptr);
+
+/* Schedule the next drain attempt */
+static void
+schedule_drain(clock_time_t delay)
+{
+  if(orpl_dtn_count() > 0 && inflight_slot == -1) {
+    ctimer_set(&drain_timer, delay, drain, NULL);
+  }
+}
+
+/* Write the record of a slot from packetbuf */
+static int
+write_slot(int slot)
+{
+  int fd;
+  int ret;
+
+  record.len = packetbuf_datalen();
+  memcpy(record.data, packetbuf_dataptr(), record.len);
+  packetbuf_attr_copyto(record.attrs, record.addrs);
+
+  fd = cfs_open(DTN_FILE, CFS_READ | CFS_WRITE);
+  if(fd < 0) {
+    return 0;
+  }
+  ret = cfs_seek(fd, slot * sizeof(record), CFS_SEEK_SET) != -1
+      && cfs_write(fd, &record, sizeof(record)) == sizeof(record);
+  cfs_close(fd);
+
+  if(ret) {
+    stats.writes++;
+    stats.bytes += sizeof(record);
+  }
+  return ret;
+}
+
+/* Read the record of a slot into packetbuf */
+static int
+read_slot(int slot)
+{
+  int fd;
+  int ret;
+
+  fd = cfs_open(DTN_FILE, CFS_READ);
+  if(fd < 0) {
+    return 0;
+  }
+  ret = cfs_seek(fd, slot * sizeof(record), CFS_SEEK_SET) != -1
+      && cfs_read(fd, &record, sizeof(record)) == sizeof(record);
+  cfs_close(fd);
+
+  if(ret) {
+    packetbuf_clear();
+    packetbuf_copyfrom(record.data, record.len);
+    packetbuf_attr_copyfrom(record.attrs, record.addrs);
+  }
+  return ret;
+}
+
+/* Log the counters, with the delivery ratio of parked packets */
+static void
+log_stats()
+{
+  ORPL_LOG("ORPL: dtn parked %u delivered %u expired %u full %u count %u writes %u bytes %lu\n",
+      stats.parked, stats.delivered, stats.expired, stats.full,
+      orpl_dtn_count(), stats.writes, stats.bytes);
+}
+
+/* Called after a drained packet was sent. On failure, csma has parked
+ * it again in the same slot. */
+static void
+drain_sent(void *ptr, int status, int num_tx)
+{
+  int slot = inflight_slot;
+  inflight_slot = -1;
+  if(status == MAC_TX_OK) {
+    if(slot != -1) {
+      slots[slot].used = 0;
+    }
+    stats.delivered++;
+    probe_interval = ORPL_DTN_DRAIN_INTERVAL;
+    log_stats();
+  } else if(probe_interval < ORPL_DTN_PROBE_MAX / 2) {
+    probe_interval *= 2;
+  } else {
+    probe_interval = ORPL_DTN_PROBE_MAX;
+  }
+  schedule_drain(probe_interval);
+}
+
+/* Returns 1 if we have forwarders for a direction */
+static int
+is_reachable(enum anycast_direction_e direction)
+{
+  if(orpl_current_edc() == 0xffff) {
+    return 0;
+  }
+  if(direction == direction_down) {
+    return orpl_are_routing_set_active();
+  }
+  return 1;
+}
+
+/* Send the oldest parked packet again, dropping expired ones */
+static void
+drain(void *ptr)
+{
+  unsigned long now = clock_seconds();
+  int i;
+  int oldest = -1;
+
+  for(i = 0; i < ORPL_DTN_SLOTS; i++) {
+    if(slots[i].used) {
+      if(now - slots[i].park_time > ORPL_DTN_MAX_AGE) {
+        slots[i].used = 0;
+        stats.expired++;
+      } else if(oldest == -1 || slots[i].park_time < slots[oldest].park_time) {
+        oldest = i;
+      }
+    }
+  }
+
+  if(oldest == -1) {
+    return;
+  }
+
+  if(!read_slot(oldest)) {
+    slots[oldest].used = 0;
+    schedule_drain(ORPL_DTN_DRAIN_INTERVAL);
+    return;
+  }
+
+  if(!is_reachable(packetbuf_attr(PACKETBUF_ATTR_ORPL_DIRECTION))) {
+    schedule_drain(probe_interval);
+    return;
+  }
+
+  inflight_slot = oldest;
+  inflight_seqno = orpl_packetbuf_seqno();
+  ORPL_LOG_FROM_PACKETBUF("Dtn: drain from slot %d", oldest);
+  NETSTACK_MAC.send(&drain_sent, NULL);
+}
+
+/* Called by csma when it gives up on an anycast. Returns 1 if the packet
+ * was parked. Leaves the packet of q in packetbuf. */
+int
+orpl_dtn_park(struct queuebuf *q)
+{
+  int i;
+  int slot = -1;
+
+  queuebuf_to_packetbuf(q);
+
+  if(!store_ok || orpl_is_root()) {
+    return 0;
+  }
+  switch(packetbuf_attr(PACKETBUF_ATTR_ORPL_DIRECTION)) {
+    case direction_up:
+    case direction_down:
+      break;
+    default:
+      return 0;
+  }
+
+  if(inflight_slot != -1 && orpl_packetbuf_seqno() == inflight_seqno) {
+    /* A drained packet failed again. It is still in its slot, don't
+     * wear the flash writing it again. */
+    return 1;
+  }
+
+  for(i = 0; i < ORPL_DTN_SLOTS; i++) {
+    if(!slots[i].used) {
+      slot = i;
+      break;
+    }
+  }
+  if(slot == -1) {
+    stats.full++;
+    return 0;
+  }
+  if(!write_slot(slot)) {
+    return 0;
+  }
+  stats.parked++;
+  slots[slot].used = 1;
+  slots[slot].park_time = clock_seconds();
+  ORPL_LOG_FROM_PACKETBUF("Dtn: parked in slot %d", slot);
+  schedule_drain(probe_interval);
+  return 1;
+}
+
+/* Called by csma when an anycast was acked, forwarders are reachable */
+void
+orpl_dtn_link_up()
+{
+  if(probe_interval != ORPL_DTN_DRAIN_INTERVAL) {
+    probe_interval = ORPL_DTN_DRAIN_INTERVAL;
+    schedule_drain(probe_interval);
+  }
+}
+
+/* Number of packets currently parked */
+int
+orpl_dtn_count()
+{
+  int i;
+  int count = 0;
+  for(i = 0; i < ORPL_DTN_SLOTS; i++) {
+    count += slots[i].used;
+  }
+  return count;
+}
+
+/* Returns the store-and-forward counters */
+const struct orpl_dtn_stats *
+orpl_dtn_get_stats()
+{
+  return &stats;
+}
+
+/* Initialize the flash store, dropping packets parked before a reboot */
+void
+orpl_dtn_init()
+{
+  memset(slots, 0, sizeof(slots));
+  probe_interval = ORPL_DTN_DRAIN_INTERVAL;
+  cfs_remove(DTN_FILE);
+  /* Records are rewritten in place: reserve the whole file, with a
+   * Coffee micro log sized for one record per write */
+  store_ok = cfs_coffee_reserve(DTN_FILE, ORPL_DTN_SLOTS * sizeof(struct dtn_record)) == 0
+      && cfs_coffee_configure_log(DTN_FILE, 4 * sizeof(struct dtn_record),
+          sizeof(struct dtn_record)) == 0;
+  if(!store_ok) {
+    ORPL_LOG("ORPL: dtn failed to reserve flash\n");
+  }
+}
+
+#endif /* WITH_ORPL && WITH_ORPL_DTN */
@@ -0,0 +1,96 @@
+/*
+ * Copyright (c) 2014, Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+
+
+/**
+ * \file
+ *         Header file for orpl-dtn.c, delay-tolerant store-and-forward
+ *         of anycast packets in a Coffee file
+ */
+
+#ifndef __ORPL_DTN_H__
+#define __ORPL_DTN_H__
+
+#include "contiki.h"
+#include "net/queuebuf.h"
+
+/* Number of packets that can be parked in flash */
+#ifdef ORPL_CONF_DTN_SLOTS
+#define ORPL_DTN_SLOTS ORPL_CONF_DTN_SLOTS
+#else /* ORPL_CONF_DTN_SLOTS */
+#define ORPL_DTN_SLOTS 16
+#endif /* ORPL_CONF_DTN_SLOTS */
+
+/* Parked packets older than this are dropped, in seconds */
+#ifdef ORPL_CONF_DTN_MAX_AGE
+#define ORPL_DTN_MAX_AGE ORPL_CONF_DTN_MAX_AGE
+#else /* ORPL_CONF_DTN_MAX_AGE */
+#define ORPL_DTN_MAX_AGE (30 * 60)
+#endif /* ORPL_CONF_DTN_MAX_AGE */
+
+/* Interval between two drained packets once forwarders are back */
+#ifdef ORPL_CONF_DTN_DRAIN_INTERVAL
+#define ORPL_DTN_DRAIN_INTERVAL ORPL_CONF_DTN_DRAIN_INTERVAL
+#else /* ORPL_CONF_DTN_DRAIN_INTERVAL */
+#define ORPL_DTN_DRAIN_INTERVAL (2 * CLOCK_SECOND)
+#endif /* ORPL_CONF_DTN_DRAIN_INTERVAL */
+
+/* Longest interval between two drain attempts during an outage */
+#ifdef ORPL_CONF_DTN_PROBE_MAX
+#define ORPL_DTN_PROBE_MAX ORPL_CONF_DTN_PROBE_MAX
+#else /* ORPL_CONF_DTN_PROBE_MAX */
+#define ORPL_DTN_PROBE_MAX (120 * CLOCK_SECOND)
+#endif /* ORPL_CONF_DTN_PROBE_MAX */
+
+struct orpl_dtn_stats {
+  uint16_t parked;      /* Packets stored after csma gave up */
+  uint16_t delivered;   /* Parked packets acked by a forwarder */
+  uint16_t expired;     /* Parked packets dropped at ORPL_DTN_MAX_AGE */
+  uint16_t full;        /* Packets dropped because all slots were used */
+  uint16_t writes;      /* Records written to flash */
+  uint32_t bytes;       /* Bytes written to flash */
+};
+
+/* Called by csma when it gives up on an anycast. Returns 1 if the packet
+ * was parked. Leaves the packet of q in packetbuf. */
+int orpl_dtn_park(struct queuebuf *q);
+/* Called by csma when an anycast was acked, forwarders are reachable */
+void orpl_dtn_link_up();
+/* Number of packets currently parked */
+int orpl_dtn_count();
+/* Returns the store-and-forward counters */
+const struct orpl_dtn_stats *orpl_dtn_get_stats();
+/* Initialize the flash store, dropping packets parked before a reboot */
+void orpl_dtn_init();
+
+#endif /* __ORPL_DTN_H__ */
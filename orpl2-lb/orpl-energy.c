@@ -0,0 +1,158 @@
+/*
+ * Copyright (c) 2014, Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+
+/**
+ * \file
+ *         Residual energy model for ORPL. The remaining energy of the node
+ *         is estimated from the radio-on time reported by energest, against
+ *         a configurable budget. It is advertised to neighbors in routing
+ *         set broadcasts and in extended ACKs. Depleted nodes are less eager
+ *         to ack anycast traffic, and neighbors penalize them when building
+ *         their forwarder set, so that traffic shifts to fresher relays.
+ */
+
+#include "orpl.h"
+#include "orpl-energy.h"
+#include "net/rpl/rpl-private.h"
+#include "sys/energest.h"
+
+#if WITH_ORPL && WITH_ORPL_ENERGY
+
+#if ORPL_ENERGY_BUDGET == 0 || ORPL_ENERGY_BUDGET > 0xfffffffful - ORPL_ENERGY_FULL
+#error ORPL_ENERGY_BUDGET out of range, it is in seconds and must fit in 32 bits
+#endif
+
+/* Radio-on time spent so far, in seconds. Energest ticks wrap after a
+ * few hours with a 32-bit counter, so we only keep the ticks of the
+ * last, incomplete second. */
+static uint32_t spent;
+static uint32_t spent_ticks;
+static uint32_t last_radio;
+/* Current energy level */
+static uint8_t remaining = ORPL_ENERGY_FULL;
+/* EDC penalty corresponding to our current energy level */
+static rpl_rank_t own_penalty;
+/* Timer for periodic update of the energy estimate */
+static struct ctimer energy_timer;
+
+/* Update our energy estimate */
+static void
+update_energy(void *ptr)
+{
+  uint32_t curr_radio;
+  uint32_t budget = ORPL_ENERGY_BUDGET;
+
+  ctimer_reset(&energy_timer);
+
+  energest_flush();
+  curr_radio = energest_type_time(ENERGEST_TYPE_TRANSMIT)
+      + energest_type_time(ENERGEST_TYPE_LISTEN);
+  spent_ticks += curr_radio - last_radio;
+  last_radio = curr_radio;
+  spent += spent_ticks / RTIMER_ARCH_SECOND;
+  spent_ticks %= RTIMER_ARCH_SECOND;
+
+  if(spent >= budget) {
+    remaining = 0;
+  } else {
+    /* Divide by the budget of one energy level rather than multiplying
+     * by ORPL_ENERGY_FULL, which would overflow for large budgets */
+    remaining = (budget - spent) / ((budget + ORPL_ENERGY_FULL - 1) / ORPL_ENERGY_FULL);
+  }
+
+  own_penalty = orpl_energy_penalty(remaining);
+
+  ORPL_LOG("ORPL: energy %u/%u penalty %u (spent %lu s)\n", remaining, ORPL_ENERGY_FULL,
+      own_penalty, spent);
+}
+
+/* Returns our remaining energy, from 0 (empty) to ORPL_ENERGY_FULL */
+uint8_t
+orpl_energy_remaining()
+{
+  return remaining;
+}
+
+/* Returns the EDC penalty associated to our own energy level */
+rpl_rank_t
+orpl_energy_own_penalty()
+{
+  return own_penalty;
+}
+
+/* Returns the EDC penalty associated to a given energy level */
+rpl_rank_t
+orpl_energy_penalty(uint8_t level)
+{
+  uint32_t depletion = ORPL_ENERGY_FULL - level;
+  return (uint32_t)ORPL_ENERGY_PENALTY_MAX * depletion * depletion
+      / ((uint32_t)ORPL_ENERGY_FULL * ORPL_ENERGY_FULL);
+}
+
+/* Store the energy level advertised by a neighbor */
+void
+orpl_energy_set_neighbor(const uip_lladdr_t *lladdr, uint8_t level)
+{
+  rpl_parent_t *p = rpl_get_parent(lladdr);
+  if(p != NULL) {
+    p->energy = level;
+  }
+}
+
+/* Returns the EDC of a neighbor, as seen when selecting forwarders */
+rpl_rank_t
+orpl_energy_neighbor_rank(const rpl_parent_t *p)
+{
+  uint32_t rank = p->rank;
+  if(rank == 0xffff) {
+    return rank;
+  }
+  rank += orpl_energy_penalty(p->energy);
+  return rank >= 0xffff ? 0xfffe : rank;
+}
+
+/* Initialize the energy model */
+void
+orpl_energy_init()
+{
+  energest_flush();
+  last_radio = energest_type_time(ENERGEST_TYPE_TRANSMIT)
+      + energest_type_time(ENERGEST_TYPE_LISTEN);
+  spent = 0;
+  spent_ticks = 0;
+  remaining = ORPL_ENERGY_FULL;
+  own_penalty = 0;
+  ctimer_set(&energy_timer, ORPL_ENERGY_PERIOD, update_energy, NULL);
+}
+
+#endif /* WITH_ORPL && WITH_ORPL_ENERGY */
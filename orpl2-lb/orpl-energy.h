@@ -0,0 +1,83 @@
+/*
+ * Copyright (c) 2014, Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+
+/**
+ * \file
+ *         Header file for orpl-energy.c, a simple residual energy model
+ *         used to steer anycast traffic away from depleted forwarders.
+ */
+
+#ifndef __ORPL_ENERGY_H__
+#define __ORPL_ENERGY_H__
+
+#include "contiki.h"
+#include "net/rpl/rpl.h"
+
+/* Energy budget of a node, expressed in seconds of radio-on time
+ * (the radio dominates the consumption of our platforms) */
+#ifdef ORPL_CONF_ENERGY_BUDGET
+#define ORPL_ENERGY_BUDGET ORPL_CONF_ENERGY_BUDGET
+#else /* ORPL_CONF_ENERGY_BUDGET */
+#define ORPL_ENERGY_BUDGET (24ul * 3600)
+#endif /* ORPL_CONF_ENERGY_BUDGET */
+
+/* Maximum EDC penalty of an empty node. The penalty grows
+ * quadratically as the energy decreases, so that fresh nodes are
+ * virtually unaffected. */
+#ifdef ORPL_CONF_ENERGY_PENALTY_MAX
+#define ORPL_ENERGY_PENALTY_MAX ORPL_CONF_ENERGY_PENALTY_MAX
+#else /* ORPL_CONF_ENERGY_PENALTY_MAX */
+#define ORPL_ENERGY_PENALTY_MAX (2 * EDC_DIVISOR)
+#endif /* ORPL_CONF_ENERGY_PENALTY_MAX */
+
+/* Period at which the energy estimate is updated */
+#define ORPL_ENERGY_PERIOD (60 * CLOCK_SECOND)
+
+/* Energy level of a full node */
+#define ORPL_ENERGY_FULL 255
+
+/* Returns our remaining energy, from 0 (empty) to ORPL_ENERGY_FULL */
+uint8_t orpl_energy_remaining();
+/* Returns the EDC penalty associated to our own energy level. Cached,
+ * so that it can be used from the softack interrupt. */
+rpl_rank_t orpl_energy_own_penalty();
+/* Returns the EDC penalty associated to a given energy level */
+rpl_rank_t orpl_energy_penalty(uint8_t level);
+/* Store the energy level advertised by a neighbor */
+void orpl_energy_set_neighbor(const uip_lladdr_t *lladdr, uint8_t level);
+/* Returns the EDC of a neighbor, as seen when selecting forwarders */
+rpl_rank_t orpl_energy_neighbor_rank(const rpl_parent_t *p);
+/* Initialize the energy model */
+void orpl_energy_init();
+
+#endif /* __ORPL_ENERGY_H__ */
@@ -0,0 +1,338 @@
+/*
+ * Copyright (c) 2014, Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+
+
+/**
+ * \file
+ *         Layer-2.5 fast forwarding of anycast frames. A frame that we
+ *         acked but that is not for us is normally decompressed into
+ *         uip_buf, routed by tcpip_ipv6_output(), recompressed into
+ *         packetbuf and queued. Thanks to the ORPL routing descriptor,
+ *         the destination is readily available in the frame: we take the
+ *         routing decision right away, decrement the hop limit in place
+ *         and hand the frame back to the MAC layer, without leaving
+ *         packetbuf. Frames that can't be handled this way (local
+ *         destination, root routing upwards, hop limit expiring...) take
+ *         the regular path. With WITH_ORPL_FRAG, each fragment of an
+ *         anycast is forwarded on its own: all of them carry the routing
+ *         descriptor, and only the destination reassembles them.
+ */
+
+#include "orpl.h"
+#include "orpl-anycast.h"
+#include "orpl-routing-set.h"
+#include "orpl-fast-forward.h"
+#if WITH_ORPL_MCAST
+#include "orpl-mcast.h"
+#include "net/queuebuf.h"
+#endif /* WITH_ORPL_MCAST */
+#include "net/netstack.h"
+#include "net/packetbuf.h"
+#include "net/sicslowpan.h"
+#include "net/uip-ds6.h"
+#include "sys/rtimer.h"
+#include <string.h>
+
+#if WITH_ORPL && WITH_ORPL_FAST_FORWARD
+
+#if !WITH_ORPL_ROUTING_DESC
+#error orpl-fast-forward.c needs the ORPL routing descriptor (WITH_ORPL_ROUTING_DESC)
+#endif
+
+/* Number of fast forwarded frames between two stats logs */
+#define STATS_LOG_PERIOD 32
+
+/* Same payload limit as in sicslowpan.c */
+#ifdef SICSLOWPAN_CONF_MAC_MAX_PAYLOAD
+#define MAC_MAX_PAYLOAD SICSLOWPAN_CONF_MAC_MAX_PAYLOAD
+#else /* SICSLOWPAN_CONF_MAC_MAX_PAYLOAD */
+#define MAC_MAX_PAYLOAD 102
+#endif /* SICSLOWPAN_CONF_MAC_MAX_PAYLOAD */
+
+/* Same number of MAC transmissions as in sicslowpan.c */
+#ifdef SICSLOWPAN_CONF_MAX_MAC_TRANSMISSIONS
+#define SICSLOWPAN_MAX_MAC_TRANSMISSIONS SICSLOWPAN_CONF_MAX_MAC_TRANSMISSIONS
+#else /* SICSLOWPAN_CONF_MAX_MAC_TRANSMISSIONS */
+#define SICSLOWPAN_MAX_MAC_TRANSMISSIONS 4
+#endif /* SICSLOWPAN_CONF_MAX_MAC_TRANSMISSIONS */
+
+static struct orpl_fast_forward_stats stats;
+
+/* Callback function for the MAC packet sent callback. Same as
+ * the one of sicslowpan.c, for the link statistics. */
+static void
+packet_sent(void *ptr, int status, int transmissions)
+{
+  uip_ds6_link_neighbor_callback(status, transmissions);
+}
+
+/* Returns the offset of the inline hop limit field in an IPHC header,
+ * i.e. the size of the fields that come before it */
+static uint8_t
+iphc_hop_limit_offset(const uint8_t *iphc)
+{
+  uint8_t offset = 2;
+  if(iphc[1] & SICSLOWPAN_IPHC_CID) {
+    offset += 1;
+  }
+  switch(iphc[0] & (SICSLOWPAN_IPHC_TC_C | SICSLOWPAN_IPHC_FL_C)) {
+    case 0: /* Traffic class and flow label inline */
+      offset += 4;
+      break;
+    case SICSLOWPAN_IPHC_TC_C: /* Flow label inline */
+      offset += 3;
+      break;
+    case SICSLOWPAN_IPHC_FL_C: /* Traffic class inline */
+      offset += 1;
+      break;
+    default: /* Both elided */
+      break;
+  }
+  if(!(iphc[0] & SICSLOWPAN_IPHC_NH_C)) {
+    offset += 1;
+  }
+  return offset;
+}
+
+/* Decrement the IPv6 hop limit of the IPHC header in packetbuf.
+ * A compressed hop limit (64 or 255) can't be decremented in the
+ * IPHC bits, in which case it is moved inline, which needs one more
+ * byte. Returns 0 if the hop limit can't be decremented this way. */
+static int
+decrement_hop_limit(uint8_t *iphc, uint8_t iphc_len)
+{
+  uint8_t offset = iphc_hop_limit_offset(iphc);
+  uint8_t hop_limit;
+
+  if(offset >= iphc_len) {
+    return 0;
+  }
+
+  switch(iphc[0] & 0x03) {
+    case SICSLOWPAN_IPHC_TTL_I:
+      if(iphc[offset] <= 1) {
+        return 0;
+      }
+      iphc[offset]--;
+      return 1;
+    case SICSLOWPAN_IPHC_TTL_64:
+      hop_limit = 63;
+      break;
+    case SICSLOWPAN_IPHC_TTL_255:
+      hop_limit = 254;
+      break;
+    default:
+      return 0;
+  }
+
+  if(packetbuf_datalen() + 1 > MAC_MAX_PAYLOAD) {
+    return 0;
+  }
+  /* Make room for the inline hop limit */
+  memmove(iphc + offset + 1, iphc + offset, iphc_len - offset);
+  iphc[offset] = hop_limit;
+  iphc[0] &= ~0x03;
+  packetbuf_set_datalen(packetbuf_datalen() + 1);
+  return 1;
+}
+
+/* Try to forward the anycast frame in packetbuf without going through
+ * the IPv6 stack. Returns 1 if the frame was forwarded (or dropped),
+ * 0 if it must be passed to the upper layers. */
+int
+orpl_fast_forward(void)
+{
+  rtimer_clock_t start = RTIMER_NOW();
+  uint8_t *data = packetbuf_dataptr();
+  uint8_t len = packetbuf_datalen();
+  uint8_t iphc_pos = ORPL_DESC_LEN;
+  uint32_t seqno = orpl_packetbuf_seqno();
+#if WITH_ORPL_PATH_HINT
+  uint8_t hint = packetbuf_attr(PACKETBUF_ATTR_ORPL_HINT);
+#endif /* WITH_ORPL_PATH_HINT */
+  uip_ipaddr_t dest_ipaddr;
+  const rimeaddr_t *anycast_addr;
+  enum anycast_direction_e direction;
+#if WITH_ORPL_MCAST
+  int is_member = 0;
+  struct queuebuf *local_copy = NULL;
+#endif /* WITH_ORPL_MCAST */
+
+  /* We need the routing descriptor, followed by an IPHC header */
+  if(len < ORPL_DESC_LEN + 2 || !ORPL_DESC_IS_DISPATCH(data[0])) {
+    return 0;
+  }
+#if WITH_ORPL_FRAG
+  /* Fragments are forwarded on their own, we never reassemble them.
+   * Only the first one has the IPHC header, and the hop limit. */
+  if((data[ORPL_DESC_LEN] & 0xf8) == SICSLOWPAN_DISPATCH_FRAG1) {
+    iphc_pos += SICSLOWPAN_FRAG1_HDR_LEN;
+  } else if((data[ORPL_DESC_LEN] & 0xf8) == SICSLOWPAN_DISPATCH_FRAGN) {
+    iphc_pos = 0;
+  }
+#endif /* WITH_ORPL_FRAG */
+  if(iphc_pos != 0 && (len < iphc_pos + 2
+      || (data[iphc_pos] & 0xe0) != SICSLOWPAN_DISPATCH_IPHC)) {
+    return 0;
+  }
+  /* A source IID elided by the sender is rebuilt from the link-layer
+   * sender, which is the source only on this first hop. uIP decompresses
+   * it here, and the next hops get it inline. */
+  if(iphc_pos != 0 && (data[iphc_pos + 1] & SICSLOWPAN_IPHC_SAM_11) == SICSLOWPAN_IPHC_SAM_11) {
+    stats.slow++;
+    return 0;
+  }
+
+  memcpy(&dest_ipaddr, &global_ipv6, 8);
+  memcpy(dest_ipaddr.u8 + 8, data + 1, 8);
+
+#if WITH_ORPL_MCAST
+  if(orpl_mcast_is_group_iid(data + 1)) {
+    /* Group message: members deliver it, and we strobe it again if
+     * there are members below us. uIP never forwards multicast. */
+    is_member = orpl_mcast_is_member_iid(data + 1);
+    if(!orpl_routing_set_contains(&dest_ipaddr)) {
+      /* Nobody below us: deliver or drop */
+      return !is_member;
+    }
+    if(is_member) {
+      /* Keep the received frame, to deliver it after forwarding */
+      local_copy = queuebuf_new_from_packetbuf();
+      if(local_copy == NULL) {
+        return 0;
+      }
+    }
+    anycast_addr = &anycast_addr_mcast;
+    direction = direction_mcast;
+  } else
+#endif /* WITH_ORPL_MCAST */
+  /* Packets for us go up the stack */
+  if(uip_ds6_is_my_addr(&dest_ipaddr)) {
+    return 0;
+  /* Same routing decision as in tcpip_ipv6_output() */
+  } else if(orpl_is_reachable_neighbor(&dest_ipaddr)) {
+    anycast_addr = &anycast_addr_nbr;
+    direction = direction_nbr;
+  } else if(orpl_routing_set_contains(&dest_ipaddr) && !orpl_blacklist_contains(seqno)
+#if WITH_ORPL_MULTI_SINK
+      && !orpl_is_sink_ipaddr(&dest_ipaddr)
+#endif /* WITH_ORPL_MULTI_SINK */
+      ) {
+    anycast_addr = &anycast_addr_down;
+    direction = direction_down;
+#if WITH_ORPL_PATH_HINT
+    /* We turn the flow down, uIP knows the source to send a hint to */
+    if(packetbuf_attr(PACKETBUF_ATTR_ORPL_DIRECTION) == direction_up) {
+      stats.slow++;
+      return 0;
+    }
+#endif /* WITH_ORPL_PATH_HINT */
+  } else if(!orpl_is_root()) {
+    anycast_addr = &anycast_addr_up;
+    direction = direction_up;
+  } else {
+    /* The root needs the fallback interface */
+    stats.slow++;
+    return 0;
+  }
+
+  if(iphc_pos != 0 && !decrement_hop_limit(data + iphc_pos, len - iphc_pos)) {
+#if WITH_ORPL_MCAST
+    if(direction == direction_mcast) {
+      /* Deliver or drop, uIP doesn't forward multicast anyway */
+      if(local_copy != NULL) {
+        queuebuf_free(local_copy);
+      }
+      return !is_member;
+    }
+#endif /* WITH_ORPL_MCAST */
+    /* Let uIP drop the packet */
+    stats.slow++;
+    return 0;
+  }
+
+  /* Turn the received frame into an outgoing one. Only the end-to-end
+   * sequence number is kept, the rest of the attributes are reset. */
+  packetbuf_attr_clear();
+  orpl_packetbuf_set_seqno(seqno);
+  packetbuf_set_attr(PACKETBUF_ATTR_ORPL_DIRECTION, direction);
+#if WITH_ORPL_TRAFFIC_CLASS
+  /* The class stays in the descriptor, CSMA needs it too */
+  packetbuf_set_attr(PACKETBUF_ATTR_ORPL_CLASS, data[0] & ORPL_DESC_CLASS_MASK);
+#endif /* WITH_ORPL_TRAFFIC_CLASS */
+#if WITH_ORPL_PATH_HINT
+  if(direction == direction_up) {
+    packetbuf_set_attr(PACKETBUF_ATTR_ORPL_HINT, hint);
+  }
+#endif /* WITH_ORPL_PATH_HINT */
+  packetbuf_set_attr(PACKETBUF_ATTR_MAX_MAC_TRANSMISSIONS,
+                     SICSLOWPAN_MAX_MAC_TRANSMISSIONS);
+#if WITH_ORPL_RADIO_STATS
+  packetbuf_set_attr(PACKETBUF_ATTR_ORPL_FORWARDED, 1);
+#endif /* WITH_ORPL_RADIO_STATS */
+  packetbuf_set_addr(PACKETBUF_ADDR_RECEIVER, anycast_addr);
+  /* Move the frame to the start of the buffer, where the MAC header
+   * of the received frame was */
+  packetbuf_compact();
+
+  ORPL_LOG_FROM_PACKETBUF("Fwd: fast %s",
+      direction == direction_up ? "up" : (direction == direction_down ? "down"
+          : (direction == direction_nbr ? "nbr" : "mcast")));
+
+  NETSTACK_MAC.send(&packet_sent, NULL);
+
+  stats.fast++;
+  stats.fast_time += RTIMER_NOW() - start;
+  if(stats.fast % STATS_LOG_PERIOD == 0) {
+    ORPL_LOG("Fwd: %u fast (%lu ticks), %u slow\n",
+        stats.fast, stats.fast_time, stats.slow);
+  }
+#if WITH_ORPL_MCAST
+  if(local_copy != NULL) {
+    /* Members also pass the message to uIP */
+    queuebuf_to_packetbuf(local_copy);
+    queuebuf_free(local_copy);
+    return 0;
+  }
+#endif /* WITH_ORPL_MCAST */
+  return 1;
+}
+
+/* Returns the counters of the fast forwarding path */
+const struct orpl_fast_forward_stats *
+orpl_fast_forward_get_stats(void)
+{
+  return &stats;
+}
+
+#endif /* WITH_ORPL && WITH_ORPL_FAST_FORWARD */
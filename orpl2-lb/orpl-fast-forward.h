@@ -0,0 +1,59 @@
+/*
+ * Copyright (c) 2014, Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+
+/**
+ * \file
+ *         Header file for orpl-fast-forward.c, a layer-2.5 forwarding
+ *         path for anycast frames that bypasses 6LoWPAN and uIP.
+ */
+
+#ifndef __ORPL_FAST_FORWARD_H__
+#define __ORPL_FAST_FORWARD_H__
+
+#include "contiki.h"
+
+/* Counters of the fast forwarding path */
+struct orpl_fast_forward_stats {
+  uint16_t fast;      /* Frames forwarded without leaving packetbuf */
+  uint16_t slow;      /* Forwarded frames handed over to uIP */
+  uint32_t fast_time; /* Total rtimer ticks spent in the fast path */
+};
+
+/* Try to forward the anycast frame in packetbuf without going through
+ * the IPv6 stack. Returns 1 if the frame was forwarded (or dropped),
+ * 0 if it must be passed to the upper layers. */
+int orpl_fast_forward(void);
+/* Returns the counters of the fast forwarding path */
+const struct orpl_fast_forward_stats *orpl_fast_forward_get_stats(void);
+
+#endif /* __ORPL_FAST_FORWARD_H__ */
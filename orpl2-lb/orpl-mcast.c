@@ -0,0 +1,160 @@
+/*
+ * Copyright (c) 2014, Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+
+
+/**
+ * \file
+ *         Opportunistic multicast to groups of nodes. Members of a group
+ *         advertise it in the routing set they broadcast, so that their
+ *         ancestors have it in their routing set just like a destination.
+ *         Group messages are anycast with a dedicated direction (mcast).
+ *         The sender strobes for a whole wake-up interval, as for
+ *         broadcasts. Every neighbor that is a member or that is deeper
+ *         in the DODAG with the group in its routing set takes the
+ *         message. Members deliver it to uIP, and nodes with members
+ *         below them forward it again from the fast forwarding path.
+ *         This costs one transmission per branch instead of one
+ *         unicast per member.
+ */
+
+#include "contiki.h"
+#include "net/uip.h"
+#include "net/uip-ds6.h"
+#include "orpl.h"
+#include "orpl-routing-set.h"
+#include "orpl-mcast.h"
+#include <string.h>
+
+#if WITH_ORPL && WITH_ORPL_MCAST
+
+/* Build the address of a group */
+void
+orpl_mcast_group_ipaddr(uip_ipaddr_t *ipaddr, uint16_t group)
+{
+  uip_ip6addr(ipaddr, 0xff05, 0, 0, 0, 0, 0, ORPL_MCAST_MARK, group);
+}
+
+/* Returns 1 if an IID (e.g. from the routing descriptor) is that of a group */
+int
+orpl_mcast_is_group_iid(const uint8_t *iid)
+{
+  return iid[0] == 0 && iid[1] == 0 && iid[2] == 0 && iid[3] == 0
+      && iid[4] == (ORPL_MCAST_MARK >> 8) && iid[5] == (ORPL_MCAST_MARK & 0xff);
+}
+
+/* Returns 1 if an address is a group address */
+int
+orpl_mcast_is_group(const uip_ipaddr_t *ipaddr)
+{
+  return ipaddr->u16[0] == UIP_HTONS(0xff05) && ipaddr->u16[1] == 0
+      && ipaddr->u16[2] == 0 && ipaddr->u16[3] == 0
+      && orpl_mcast_is_group_iid(ipaddr->u8 + 8);
+}
+
+/* Returns 1 if we are a member of the group of an IID */
+int
+orpl_mcast_is_member_iid(const uint8_t *iid)
+{
+  uip_ipaddr_t group_ipaddr;
+  orpl_mcast_group_ipaddr(&group_ipaddr, (iid[6] << 8) + iid[7]);
+  return uip_ds6_is_my_maddr(&group_ipaddr);
+}
+
+/* Groups are inserted in routing sets with our global prefix, as the
+ * ack decision builds destinations from the IID of the frame */
+static void
+routing_ipaddr(uip_ipaddr_t *ipaddr, const uip_ipaddr_t *group_ipaddr)
+{
+  memcpy(ipaddr, &global_ipv6, 8);
+  memcpy(ipaddr->u8 + 8, group_ipaddr->u8 + 8, 8);
+}
+
+/* Returns 1 if there are members of a group in our sub-DODAG */
+int
+orpl_mcast_has_members(const uip_ipaddr_t *ipaddr)
+{
+  uip_ipaddr_t rs_ipaddr;
+  routing_ipaddr(&rs_ipaddr, ipaddr);
+  return orpl_routing_set_contains(&rs_ipaddr);
+}
+
+/* Join a group: we receive its messages, and advertise it to our parents */
+int
+orpl_mcast_join(uint16_t group)
+{
+  uip_ipaddr_t group_ipaddr;
+  orpl_mcast_group_ipaddr(&group_ipaddr, group);
+  if(uip_ds6_is_my_maddr(&group_ipaddr)) {
+    return 1;
+  }
+  if(uip_ds6_maddr_add(&group_ipaddr) == NULL) {
+    ORPL_LOG("ORPL: can't join group %u\n", group);
+    return 0;
+  }
+  ORPL_LOG("ORPL: joined group %u\n", group);
+  orpl_request_routing_set_broadcast();
+  return 1;
+}
+
+/* Leave a group. Parents forget it after routing set ageing. */
+void
+orpl_mcast_leave(uint16_t group)
+{
+  uip_ipaddr_t group_ipaddr;
+  uip_ds6_maddr_t *maddr;
+  orpl_mcast_group_ipaddr(&group_ipaddr, group);
+  maddr = uip_ds6_maddr_lookup(&group_ipaddr);
+  if(maddr != NULL) {
+    uip_ds6_maddr_rm(maddr);
+    ORPL_LOG("ORPL: left group %u\n", group);
+  }
+}
+
+/* Add the groups we are member of to a routing set about to be broadcast.
+ * They are not in our own routing set, which only tells whether there
+ * are members below us. */
+void
+orpl_mcast_add_groups(struct routing_set_s *rs)
+{
+  int i;
+  uip_ipaddr_t rs_ipaddr;
+  for(i = 0; i < UIP_DS6_MADDR_NB; i++) {
+    if(uip_ds6_if.maddr_list[i].isused
+        && orpl_mcast_is_group(&uip_ds6_if.maddr_list[i].ipaddr)) {
+      routing_ipaddr(&rs_ipaddr, &uip_ds6_if.maddr_list[i].ipaddr);
+      orpl_routing_set_add(rs, &rs_ipaddr);
+    }
+  }
+}
+
+#endif /* WITH_ORPL && WITH_ORPL_MCAST */
@@ -0,0 +1,78 @@
+/*
+ * Copyright (c) 2014, Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+
+
+/**
+ * \file
+ *         Header file for orpl-mcast.c, opportunistic multicast to
+ *         groups of nodes through routing sets
+ */
+
+#ifndef __ORPL_MCAST_H__
+#define __ORPL_MCAST_H__
+
+#include "contiki.h"
+#include "net/uip.h"
+#include "orpl-routing-set.h"
+
+#if WITH_ORPL_MCAST && !WITH_ORPL_FAST_FORWARD
+#error WITH_ORPL_MCAST needs WITH_ORPL_FAST_FORWARD, which forwards group messages
+#endif
+
+#if WITH_ORPL_MCAST && WITH_ORPL_RIMAC
+#error WITH_ORPL_MCAST needs the strobes of ContikiMAC-ORPL
+#endif
+
+/* Groups are the site-local multicast addresses ff05::ORPL_MCAST_MARK:<group>.
+ * Within the PAN, they are routed on their IID, like unicast destinations,
+ * and members advertise them in their routing set. */
+#define ORPL_MCAST_MARK 0x4d43
+
+/* Build the address of a group */
+void orpl_mcast_group_ipaddr(uip_ipaddr_t *ipaddr, uint16_t group);
+/* Returns 1 if an address is a group address */
+int orpl_mcast_is_group(const uip_ipaddr_t *ipaddr);
+/* Returns 1 if an IID (e.g. from the routing descriptor) is that of a group */
+int orpl_mcast_is_group_iid(const uint8_t *iid);
+/* Returns 1 if we are a member of the group of an IID */
+int orpl_mcast_is_member_iid(const uint8_t *iid);
+/* Returns 1 if there are members of a group in our sub-DODAG */
+int orpl_mcast_has_members(const uip_ipaddr_t *ipaddr);
+/* Join a group: we receive its messages, and advertise it to our parents */
+int orpl_mcast_join(uint16_t group);
+/* Leave a group. Parents forget it after routing set ageing. */
+void orpl_mcast_leave(uint16_t group);
+/* Add the groups we are member of to a routing set about to be broadcast */
+void orpl_mcast_add_groups(struct routing_set_s *rs);
+
+#endif /* __ORPL_MCAST_H__ */
@@ -0,0 +1,145 @@
+/*
+ * Copyright (c) 2014, Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+
+
+/**
+ * \file
+ *         Neighbor table policy for ORPL. In dense deployments, nodes hear
+ *         more neighbors than NBR_TABLE_MAX_NEIGHBORS, and the table would
+ *         otherwise be filled first-come. We score neighbors by their
+ *         contribution to the EDC: forwarder set members first, then
+ *         routing set children, each weighted by link quality. A new
+ *         neighbor only replaces the least useful one if it scores
+ *         significantly better, and never before that one has been
+ *         evaluated over a few broadcasts.
+ */
+
+#include "orpl.h"
+#include "orpl-nbr-policy.h"
+#include "net/uip-ds6.h"
+#include "net/rpl/rpl-private.h"
+
+#if WITH_ORPL && WITH_ORPL_NBR_POLICY
+
+/* Score bonus of forwarder set members and routing set children.
+ * Link quality adds up to 100 on top of it. */
+#define SCORE_FORWARDER 200
+#define SCORE_CHILD 100
+
+/* Returns the score of a neighbor from its rank and link quality
+ * (ack count normalized to ORPL_LINK_WINDOW) */
+static uint16_t
+score(rpl_rank_t rank, uint16_t ackcount, int evaluated)
+{
+  rpl_rank_t curr_edc = orpl_current_edc();
+  uint16_t prr = 100 * ackcount / ORPL_LINK_WINDOW;
+  if(rank != 0xffff && rank < curr_edc) {
+    /* Potential forwarder, lower EDC first */
+    return SCORE_FORWARDER + prr + (curr_edc - rank) / EDC_DIVISOR;
+  }
+  if(evaluated && rank > ORPL_EDC_W && (rank - ORPL_EDC_W) > curr_edc
+      && prr >= NEIGHBOR_PRR_THRESHOLD) {
+    /* Routing set child */
+    return SCORE_CHILD + prr;
+  }
+  return prr;
+}
+
+/* Returns the usefulness score of a neighbor, the higher the better */
+uint16_t
+orpl_nbr_score(const rpl_parent_t *p)
+{
+  return score(p->rank, orpl_link_ackcount(p), p->bc_samples >= 4);
+}
+
+/* Called before adding a new neighbor with a given rank. Returns 1 if
+ * there is room for it, possibly after evicting a less useful neighbor,
+ * 0 if the neighbor should be ignored. */
+int
+orpl_nbr_admit(const uip_ipaddr_t *ipaddr, rpl_rank_t rank)
+{
+  uip_ds6_nbr_t *nbr;
+  rpl_parent_t *p;
+  rpl_parent_t *worst = NULL;
+  uint16_t worst_score = 0xffff;
+  uint16_t new_score;
+  int count = 0;
+
+  if(uip_ds6_nbr_lookup(ipaddr) != NULL) {
+    /* Already known */
+    return 1;
+  }
+
+  /* All neighbor tables share the same entries, count the ones in use */
+  for(nbr = nbr_table_head(ds6_neighbors);
+      nbr != NULL;
+      nbr = nbr_table_next(ds6_neighbors, nbr)) {
+    count++;
+  }
+  if(count < NBR_TABLE_MAX_NEIGHBORS) {
+    return 1;
+  }
+
+  /* Table full, look for the least useful neighbor that has been
+   * evaluated long enough */
+  for(p = nbr_table_head(rpl_parents);
+      p != NULL;
+      p = nbr_table_next(rpl_parents, p)) {
+    if(p->bc_samples >= ORPL_NBR_PROBATION) {
+      uint16_t s = orpl_nbr_score(p);
+      if(s < worst_score) {
+        worst = p;
+        worst_score = s;
+      }
+    }
+  }
+
+  /* Unknown link quality: assume the same 50% as orpl_link_ackcount */
+  new_score = score(rank, ORPL_LINK_WINDOW / 2, 0);
+  if(worst == NULL || new_score < worst_score + ORPL_NBR_HYSTERESIS) {
+    return 0;
+  }
+
+  ORPL_LOG("ORPL: evicting neighbor %u (score %u) for %u (score %u)\n",
+      ORPL_LOG_NODEID_FROM_RIMEADDR(nbr_table_get_lladdr(rpl_parents, worst)), worst_score,
+      ORPL_LOG_NODEID_FROM_IPADDR(ipaddr), new_score);
+
+  nbr = uip_ds6_nbr_lookup(rpl_get_parent_ipaddr(worst));
+  rpl_remove_parent(worst);
+  if(nbr != NULL) {
+    uip_ds6_nbr_rm(nbr);
+  }
+  return 1;
+}
+
+#endif /* WITH_ORPL && WITH_ORPL_NBR_POLICY */
@@ -0,0 +1,71 @@
+/*
+ * Copyright (c) 2014, Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+
+
+/**
+ * \file
+ *         Header file for orpl-nbr-policy.c, the admission and eviction
+ *         policy of the neighbor table in dense deployments.
+ */
+
+#ifndef __ORPL_NBR_POLICY_H__
+#define __ORPL_NBR_POLICY_H__
+
+#include "contiki.h"
+#include "net/uip.h"
+#include "net/rpl/rpl.h"
+
+/* Score margin a new neighbor must have over the least useful one
+ * before we evict it. Avoids churn among neighbors of similar value. */
+#ifdef ORPL_CONF_NBR_HYSTERESIS
+#define ORPL_NBR_HYSTERESIS ORPL_CONF_NBR_HYSTERESIS
+#else /* ORPL_CONF_NBR_HYSTERESIS */
+#define ORPL_NBR_HYSTERESIS 40
+#endif /* ORPL_CONF_NBR_HYSTERESIS */
+
+/* Number of broadcasts a neighbor is given to prove its usefulness
+ * before it can be evicted */
+#ifdef ORPL_CONF_NBR_PROBATION
+#define ORPL_NBR_PROBATION ORPL_CONF_NBR_PROBATION
+#else /* ORPL_CONF_NBR_PROBATION */
+#define ORPL_NBR_PROBATION 4
+#endif /* ORPL_CONF_NBR_PROBATION */
+
+/* Returns the usefulness score of a neighbor, the higher the better */
+uint16_t orpl_nbr_score(const rpl_parent_t *p);
+/* Called before adding a new neighbor with a given rank. Returns 1 if
+ * there is room for it, possibly after evicting a less useful neighbor,
+ * 0 if the neighbor should be ignored. */
+int orpl_nbr_admit(const uip_ipaddr_t *ipaddr, rpl_rank_t rank);
+
+#endif /* __ORPL_NBR_POLICY_H__ */
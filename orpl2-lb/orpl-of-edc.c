@@ -43,6 +43,9 @@
 #include "net/uip-debug.h"
 #include "orpl.h"
 #include "orpl-anycast.h"
+#if WITH_ORPL_ENERGY
+#include "orpl-energy.h"
+#endif /* WITH_ORPL_ENERGY */
 #include "packetbuf.h"
 
 #if WITH_ORPL
@@ -86,16 +89,8 @@ add_to_forwarder_set(rpl_parent_t *curr_p, rpl_rank_t curr_p_rank, uint16_t ackc
   uint16_t tentative_edc;
   uint32_t total_tx_count;
 
-  if(ackcount > orpl_broadcast_count) {
-    ackcount = orpl_broadcast_count;
-  }
-
-  total_tx_count = orpl_broadcast_count;
-  if(total_tx_count == 0) {
-    /* No broadcast sent yet: assume a reception rate of 50% */
-    ackcount = 1;
-    total_tx_count = 2;
-  }
+  /* Ack counts are normalized to the link estimation window */
+  total_tx_count = ORPL_LINK_WINDOW;
 
   *curr_ackcount_sum += ackcount;
   *curr_ackcount_edc_sum += ackcount * curr_p_rank;
@@ -168,11 +163,16 @@ orpl_calculate_edc(int verbose)
     for(p = nbr_table_head(rpl_parents), index = 0;
         p != NULL;
         p = nbr_table_next(rpl_parents, p), index++) {
+#if WITH_ORPL_ENERGY
+      /* Depleted neighbors are seen as worse forwarders */
+      uint16_t rank = orpl_energy_neighbor_rank(p);
+#else /* WITH_ORPL_ENERGY */
       uint16_t rank = p->rank;
-      uint16_t ackcount = p->bc_ackcount;
+#endif /* WITH_ORPL_ENERGY */
+      uint16_t ackcount = orpl_link_ackcount(p);
 
       if(rank != 0xffff
-          && !(orpl_broadcast_count > 0 && ackcount == 0)
+          && ackcount != 0
           && (curr_p == NULL || rank < curr_p_rank)
           && (rank > prev_min_rank || (rank == prev_min_rank && index > prev_index))
       ) {
@@ -189,7 +189,7 @@ orpl_calculate_edc(int verbose)
       rpl_rank_t tentative_edc;
 
 //      if(verbose) {
-//       printf("ORPL: EDC -> node %3u rank: %5u ack %u/%u ", curr_id, curr_p_rank, curr_p_ackcount, orpl_broadcast_count);
+//       printf("ORPL: EDC -> node %3u rank: %5u ack %u/%u ", curr_id, curr_p_rank, curr_p_ackcount, ORPL_LINK_WINDOW);
 //      }
 
       tentative_edc = add_to_forwarder_set(curr_p, curr_p_rank, curr_p_ackcount,
@@ -222,6 +222,10 @@ orpl_calculate_edc(int verbose)
 //    printf("ORPL: final edc %u\n", edc);
 //  }
 
+#if !FREEZE_TOPOLOGY
+  edc = orpl_edc_hysteresis(prev_edc, edc);
+#endif /* !FREEZE_TOPOLOGY */
+
   if(edc != prev_edc) {
     ANNOTATE("#A edc=%u.%u\n", edc/EDC_DIVISOR,
         (10 * (edc % EDC_DIVISOR)) / EDC_DIVISOR);
@@ -0,0 +1,210 @@
+/*
+ * Copyright (c) 2014, Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+
+
+/**
+ * \file
+ *         Path hints for any-to-any flows. Upwards traffic normally climbs
+ *         until an ancestor with the destination in its routing set turns
+ *         it down. That ancestor sends the source a hint with its EDC. The
+ *         source then marks further packets of the flow with the EDC band
+ *         of the turn, in the upwards anycast address. Forwarders with the
+ *         destination in their routing set take marked packets in the first
+ *         ACK slot, and upwards forwarders that would climb past the turn
+ *         take the last one, so flows turn down as early as they can.
+ */
+
+#include "contiki.h"
+#include "net/uip.h"
+#include "net/uip-ds6.h"
+#include "net/simple-udp.h"
+#include "orpl.h"
+#include "orpl-path-hint.h"
+#include <string.h>
+
+#if WITH_ORPL && WITH_ORPL_PATH_HINT
+
+struct hint_msg_s {
+  uint8_t dest_iid[8];
+  rpl_rank_t turn_edc;
+};
+
+/* Hints received, at the source */
+struct hint_entry {
+  uint8_t dest_iid[8];
+  uint8_t band;
+  unsigned long time;
+};
+static struct hint_entry hints[ORPL_PATH_HINT_CACHE];
+
+/* Flows we recently sent a hint for, at the turning node */
+struct turn_entry {
+  uint16_t src_id;
+  uint16_t dest_id;
+  unsigned long time;
+};
+static struct turn_entry turns[ORPL_PATH_HINT_CACHE];
+
+/* Hint waiting to be sent, uip_buf is busy when we turn a flow */
+static uip_ipaddr_t pending_src;
+static struct hint_msg_s pending_msg;
+static uint8_t pending;
+static struct ctimer send_timer;
+
+static struct simple_udp_connection hint_connection;
+static uint8_t curr_hint;
+
+/* Returns the hint we have for a destination, as a value of
+ * PACKETBUF_ATTR_ORPL_HINT: band + 1, or 0 if none */
+uint8_t
+orpl_path_hint_lookup(const uip_ipaddr_t *dest)
+{
+  int i;
+  for(i = 0; i < ORPL_PATH_HINT_CACHE; i++) {
+    if(hints[i].time != 0 && !memcmp(hints[i].dest_iid, dest->u8 + 8, 8)) {
+      if(clock_seconds() - hints[i].time > ORPL_PATH_HINT_LIFETIME) {
+        hints[i].time = 0;
+        return 0;
+      }
+      return hints[i].band + 1;
+    }
+  }
+  return 0;
+}
+
+/* Set the hint of the packet being sent, as with orpl_set_curr_seqno */
+void
+orpl_path_hint_set_curr(uint8_t hint)
+{
+  curr_hint = hint;
+}
+
+/* Get the hint of the packet being sent */
+uint8_t
+orpl_path_hint_curr()
+{
+  return curr_hint;
+}
+
+static void
+send_pending(void *ptr)
+{
+  if(pending) {
+    simple_udp_sendto(&hint_connection, &pending_msg, sizeof(pending_msg), &pending_src);
+    pending = 0;
+  }
+}
+
+/* Called when we turn a flow from upwards to downwards. Sends a hint to
+ * the source, at most once per ORPL_PATH_HINT_REFRESH. */
+void
+orpl_path_hint_turned(const uip_ipaddr_t *src, const uip_ipaddr_t *dest)
+{
+  unsigned long now = clock_seconds();
+  uint16_t src_id = (src->u8[14] << 8) + src->u8[15];
+  uint16_t dest_id = (dest->u8[14] << 8) + dest->u8[15];
+  int i;
+  int oldest = 0;
+
+  if(pending) {
+    return;
+  }
+  for(i = 0; i < ORPL_PATH_HINT_CACHE; i++) {
+    if(turns[i].time != 0 && turns[i].src_id == src_id && turns[i].dest_id == dest_id
+        && now - turns[i].time < ORPL_PATH_HINT_REFRESH) {
+      return;
+    }
+    if(turns[i].time < turns[oldest].time) {
+      oldest = i;
+    }
+  }
+  turns[oldest].src_id = src_id;
+  turns[oldest].dest_id = dest_id;
+  turns[oldest].time = now;
+
+  uip_ipaddr_copy(&pending_src, src);
+  memcpy(pending_msg.dest_iid, dest->u8 + 8, 8);
+  pending_msg.turn_edc = orpl_current_edc();
+  pending = 1;
+  ORPL_LOG("ORPL: path hint to %u for %u edc %u\n",
+      ORPL_LOG_NODEID_FROM_IPADDR(src), ORPL_LOG_NODEID_FROM_IPADDR(dest), pending_msg.turn_edc);
+  ctimer_set(&send_timer, 0, send_pending, NULL);
+}
+
+/* A turning node sent us a hint for a destination */
+static void
+udp_received_hint(struct simple_udp_connection *c,
+         const uip_ipaddr_t *sender_addr,
+         uint16_t sender_port,
+         const uip_ipaddr_t *receiver_addr,
+         uint16_t receiver_port,
+         const uint8_t *data,
+         uint16_t datalen)
+{
+  struct hint_msg_s msg;
+  int i;
+  int slot = 0;
+
+  if(datalen != sizeof(msg)) {
+    return;
+  }
+  memcpy(&msg, data, sizeof(msg));
+
+  /* Replace the hint for this destination, or the oldest one */
+  for(i = 0; i < ORPL_PATH_HINT_CACHE; i++) {
+    if(hints[i].time != 0 && !memcmp(hints[i].dest_iid, msg.dest_iid, 8)) {
+      slot = i;
+      break;
+    }
+    if(hints[i].time < hints[slot].time) {
+      slot = i;
+    }
+  }
+  memcpy(hints[slot].dest_iid, msg.dest_iid, 8);
+  hints[slot].band = ORPL_PATH_HINT_EDC_TO_BAND(msg.turn_edc);
+  hints[slot].time = clock_seconds();
+  if(hints[slot].time == 0) {
+    hints[slot].time = 1;
+  }
+}
+
+/* Register the hint UDP port */
+void
+orpl_path_hint_init()
+{
+  simple_udp_register(&hint_connection, ORPL_PATH_HINT_PORT,
+                        NULL, ORPL_PATH_HINT_PORT,
+                        udp_received_hint);
+}
+
+#endif /* WITH_ORPL && WITH_ORPL_PATH_HINT */
@@ -0,0 +1,99 @@
+/*
+ * Copyright (c) 2014, Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+
+
+/**
+ * \file
+ *         Header file for orpl-path-hint.c, path hints for any-to-any flows
+ */
+
+#ifndef __ORPL_PATH_HINT_H__
+#define __ORPL_PATH_HINT_H__
+
+#include "contiki.h"
+#include "net/uip.h"
+
+#if WITH_ORPL_PATH_HINT && !WITH_ORPL_ACK_SLOTS
+#error WITH_ORPL_PATH_HINT needs WITH_ORPL_ACK_SLOTS
+#endif
+
+/* UDP port of hint messages */
+#define ORPL_PATH_HINT_PORT 4445
+
+/* Hints carry the EDC at which a flow turned down, in bands of
+ * ORPL_PATH_HINT_BAND. Bands fit in the second byte of the upwards
+ * anycast address, where ORPL_PATH_HINT_ADDR_NONE means no hint. */
+#define ORPL_PATH_HINT_BAND ORPL_EDC_W
+#define ORPL_PATH_HINT_MAX_BAND 0xf0
+#define ORPL_PATH_HINT_ADDR_NONE 0xfa
+
+/* Hints cached at the source expire after this time, in seconds */
+#ifdef ORPL_CONF_PATH_HINT_LIFETIME
+#define ORPL_PATH_HINT_LIFETIME ORPL_CONF_PATH_HINT_LIFETIME
+#else /* ORPL_CONF_PATH_HINT_LIFETIME */
+#define ORPL_PATH_HINT_LIFETIME (10 * 60)
+#endif /* ORPL_CONF_PATH_HINT_LIFETIME */
+
+/* A turning node sends at most one hint per flow per period, in seconds */
+#ifdef ORPL_CONF_PATH_HINT_REFRESH
+#define ORPL_PATH_HINT_REFRESH ORPL_CONF_PATH_HINT_REFRESH
+#else /* ORPL_CONF_PATH_HINT_REFRESH */
+#define ORPL_PATH_HINT_REFRESH (ORPL_PATH_HINT_LIFETIME / 2)
+#endif /* ORPL_CONF_PATH_HINT_REFRESH */
+
+/* Number of destinations a source keeps hints for, and of flows
+ * a turning node remembers */
+#ifdef ORPL_CONF_PATH_HINT_CACHE
+#define ORPL_PATH_HINT_CACHE ORPL_CONF_PATH_HINT_CACHE
+#else /* ORPL_CONF_PATH_HINT_CACHE */
+#define ORPL_PATH_HINT_CACHE 4
+#endif /* ORPL_CONF_PATH_HINT_CACHE */
+
+/* Returns the band of an EDC */
+#define ORPL_PATH_HINT_EDC_TO_BAND(edc) ((edc) / ORPL_PATH_HINT_BAND > ORPL_PATH_HINT_MAX_BAND \
+    ? ORPL_PATH_HINT_MAX_BAND : (edc) / ORPL_PATH_HINT_BAND)
+
+/* Returns the hint we have for a destination, as a value of
+ * PACKETBUF_ATTR_ORPL_HINT: band + 1, or 0 if none */
+uint8_t orpl_path_hint_lookup(const uip_ipaddr_t *dest);
+/* Set the hint of the packet being sent, as with orpl_set_curr_seqno */
+void orpl_path_hint_set_curr(uint8_t hint);
+/* Get the hint of the packet being sent */
+uint8_t orpl_path_hint_curr();
+/* Called when we turn a flow from upwards to downwards. Sends a hint to
+ * the source, at most once per ORPL_PATH_HINT_REFRESH. */
+void orpl_path_hint_turned(const uip_ipaddr_t *src, const uip_ipaddr_t *dest);
+/* Register the hint UDP port */
+void orpl_path_hint_init();
+
+#endif /* __ORPL_PATH_HINT_H__ */
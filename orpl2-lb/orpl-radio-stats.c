@@ -0,0 +1,194 @@
+/*
+ * Copyright (c) 2014, Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+
+/**
+ * \file
+ *         Per-activity radio-on time accounting for ContikiMAC-ORPL.
+ *         The RDC reports radio on/off transitions and tags them with
+ *         the current activity. Radio-on periods are measured in rtimer
+ *         ticks, which is sufficient as the RDC never keeps the radio on
+ *         for more than a strobe while duty cycling.
+ */
+
+#include "orpl.h"
+#include "orpl-radio-stats.h"
+#include "sys/rtimer.h"
+
+#if WITH_ORPL && WITH_ORPL_RADIO_STATS
+
+/* Cumulated radio-on time per activity and origin, in rtimer ticks */
+static uint32_t radio_time[ORPL_RADIO_ACTIVITY_COUNT][ORPL_RADIO_ORIGIN_COUNT];
+/* Number of radio-on periods per activity */
+static uint16_t radio_count[ORPL_RADIO_ACTIVITY_COUNT];
+/* Radio time at the last report */
+static uint32_t last_report[ORPL_RADIO_ACTIVITY_COUNT][ORPL_RADIO_ORIGIN_COUNT];
+/* Current activity and origin */
+static uint8_t curr_activity = ORPL_RADIO_CCA;
+static uint8_t curr_origin = ORPL_RADIO_OWN;
+/* Whether the radio is on, and since when */
+static uint8_t is_on;
+static rtimer_clock_t segment_start;
+/* Last segment of the last radio-on period */
+static uint8_t last_activity = ORPL_RADIO_ACTIVITY_COUNT;
+static uint8_t last_origin;
+static rtimer_clock_t last_duration;
+/* Timer for periodic reports */
+static struct ctimer report_timer;
+
+static const char *activity_names[ORPL_RADIO_ACTIVITY_COUNT] = {
+  "cca", "false", "rx", "overhear", "burst", "ucast", "acast", "bcast"
+};
+
+/* Attribute the time spent since the start of the current segment */
+static void
+account_segment(rtimer_clock_t now)
+{
+  radio_time[curr_activity][curr_origin] += (rtimer_clock_t)(now - segment_start);
+  segment_start = now;
+}
+
+/* Called by the RDC whenever the radio is turned on */
+void
+orpl_radio_stats_on()
+{
+  if(!is_on) {
+    is_on = 1;
+    segment_start = RTIMER_NOW();
+    radio_count[curr_activity]++;
+  }
+}
+
+/* Called by the RDC whenever the radio is turned off */
+void
+orpl_radio_stats_off()
+{
+  if(is_on) {
+    rtimer_clock_t now = RTIMER_NOW();
+    last_activity = curr_activity;
+    last_origin = curr_origin;
+    last_duration = now - segment_start;
+    account_segment(now);
+    is_on = 0;
+  }
+}
+
+/* Set the current activity */
+void
+orpl_radio_stats_set_activity(enum orpl_radio_activity activity,
+    enum orpl_radio_origin origin)
+{
+  if(activity == curr_activity && origin == curr_origin) {
+    return;
+  }
+  if(is_on) {
+    account_segment(RTIMER_NOW());
+    radio_count[activity]++;
+  }
+  curr_activity = activity;
+  curr_origin = origin;
+}
+
+/* Attribute the ongoing segment, from its start, to a new activity.
+ * Nothing has been accounted for the segment yet, so we only
+ * need to switch the activity. */
+void
+orpl_radio_stats_reclassify(enum orpl_radio_activity activity)
+{
+  if(is_on && activity != curr_activity) {
+    radio_count[curr_activity]--;
+    radio_count[activity]++;
+    curr_activity = activity;
+  }
+}
+
+/* Attribute the last segment of the last radio-on period to a new activity */
+void
+orpl_radio_stats_reclassify_last(enum orpl_radio_activity from,
+    enum orpl_radio_activity to)
+{
+  if(last_activity == from && from != to) {
+    radio_time[from][last_origin] -= last_duration;
+    radio_time[to][last_origin] += last_duration;
+    radio_count[from]--;
+    radio_count[to]++;
+    last_activity = to;
+  }
+}
+
+/* Returns the total radio-on time spent for an activity */
+uint32_t
+orpl_radio_stats_time(enum orpl_radio_activity activity,
+    enum orpl_radio_origin origin)
+{
+  return radio_time[activity][origin];
+}
+
+/* Returns the number of radio-on periods attributed to an activity */
+uint16_t
+orpl_radio_stats_count(enum orpl_radio_activity activity)
+{
+  return radio_count[activity];
+}
+
+/* Log the radio-on time spent per activity since the last report */
+void
+orpl_radio_stats_report()
+{
+  int i;
+  for(i = 0; i < ORPL_RADIO_ACTIVITY_COUNT; i++) {
+    uint32_t own = radio_time[i][ORPL_RADIO_OWN] - last_report[i][ORPL_RADIO_OWN];
+    uint32_t fw = radio_time[i][ORPL_RADIO_FORWARDED] - last_report[i][ORPL_RADIO_FORWARDED];
+    last_report[i][ORPL_RADIO_OWN] = radio_time[i][ORPL_RADIO_OWN];
+    last_report[i][ORPL_RADIO_FORWARDED] = radio_time[i][ORPL_RADIO_FORWARDED];
+    /* Own and forwarded time in rtimer ticks, and number of periods */
+    ORPL_LOG("ORPL: radio %s %lu +%lu (%u)\n", activity_names[i],
+        own, fw, radio_count[i]);
+  }
+}
+
+/* Periodic report */
+static void
+report_timer_callback(void *ptr)
+{
+  ctimer_reset(&report_timer);
+  orpl_radio_stats_report();
+}
+
+/* Initialize radio accounting and start periodic reports */
+void
+orpl_radio_stats_init()
+{
+  ctimer_set(&report_timer, ORPL_RADIO_STATS_PERIOD, report_timer_callback, NULL);
+}
+
+#endif /* WITH_ORPL && WITH_ORPL_RADIO_STATS */
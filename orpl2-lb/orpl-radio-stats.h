@@ -0,0 +1,106 @@
+/*
+ * Copyright (c) 2014, Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+
+/**
+ * \file
+ *         Per-activity radio-on time accounting for ContikiMAC-ORPL.
+ *         Attributes every radio-on period to an activity class
+ *         (channel checks, false wake-ups, reception, overhearing,
+ *         bursts, strobing) and, for transmissions, to the origin
+ *         of the packet (own or forwarded).
+ */
+
+#ifndef __ORPL_RADIO_STATS_H__
+#define __ORPL_RADIO_STATS_H__
+
+#include "contiki.h"
+
+/* Wrapper for RDC hooks, compiled out when accounting is disabled */
+#if WITH_ORPL_RADIO_STATS
+#define ORPL_RADIO_STATS(x) x
+#else /* WITH_ORPL_RADIO_STATS */
+#define ORPL_RADIO_STATS(x)
+#endif /* WITH_ORPL_RADIO_STATS */
+
+/* Period at which the radio statistics are logged */
+#ifdef ORPL_CONF_RADIO_STATS_PERIOD
+#define ORPL_RADIO_STATS_PERIOD ORPL_CONF_RADIO_STATS_PERIOD
+#else /* ORPL_CONF_RADIO_STATS_PERIOD */
+#define ORPL_RADIO_STATS_PERIOD (60 * CLOCK_SECOND)
+#endif /* ORPL_CONF_RADIO_STATS_PERIOD */
+
+/* The activities radio-on time is attributed to */
+enum orpl_radio_activity {
+  ORPL_RADIO_CCA,          /* Periodic wake-up channel checks */
+  ORPL_RADIO_FALSE_WAKEUP, /* Listening after a CCA, nothing received */
+  ORPL_RADIO_RX,           /* Receiving a frame addressed to us */
+  ORPL_RADIO_OVERHEAR,     /* Receiving a frame that was not for us */
+  ORPL_RADIO_RX_BURST,     /* Waiting for the next frame of a burst */
+  ORPL_RADIO_TX_UNICAST,   /* Strobing a unicast frame */
+  ORPL_RADIO_TX_ANYCAST,   /* Strobing an anycast frame, waiting for softacks */
+  ORPL_RADIO_TX_BROADCAST, /* Strobing a broadcast frame */
+  ORPL_RADIO_ACTIVITY_COUNT
+};
+
+/* The origin of the traffic radio-on time is spent for */
+enum orpl_radio_origin {
+  ORPL_RADIO_OWN,
+  ORPL_RADIO_FORWARDED,
+  ORPL_RADIO_ORIGIN_COUNT
+};
+
+/* Called by the RDC whenever the radio is turned on */
+void orpl_radio_stats_on();
+/* Called by the RDC whenever the radio is turned off */
+void orpl_radio_stats_off();
+/* Set the current activity. Radio-on time spent so far is attributed
+ * to the previous activity. */
+void orpl_radio_stats_set_activity(enum orpl_radio_activity activity,
+    enum orpl_radio_origin origin);
+/* Attribute the ongoing segment, from its start, to a new activity */
+void orpl_radio_stats_reclassify(enum orpl_radio_activity activity);
+/* Attribute the last segment of the last radio-on period to a new
+ * activity, if it was attributed to 'from' */
+void orpl_radio_stats_reclassify_last(enum orpl_radio_activity from,
+    enum orpl_radio_activity to);
+/* Returns the total radio-on time (in rtimer ticks) spent for an activity */
+uint32_t orpl_radio_stats_time(enum orpl_radio_activity activity,
+    enum orpl_radio_origin origin);
+/* Returns the number of radio-on periods attributed to an activity */
+uint16_t orpl_radio_stats_count(enum orpl_radio_activity activity);
+/* Log the radio-on time spent per activity since the last report */
+void orpl_radio_stats_report();
+/* Initialize radio accounting and start periodic reports */
+void orpl_radio_stats_init();
+
+#endif /* __ORPL_RADIO_STATS_H__ */
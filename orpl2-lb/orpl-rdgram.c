@@ -0,0 +1,407 @@
+/*
+ * Copyright (c) 2014, Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+
+
+/**
+ * \file
+ *         Reliable datagrams on top of simple-udp, for downwards and
+ *         any-to-any traffic that ORPL only delivers hop by hop. Each
+ *         datagram starts with a small header that carries a per-peer
+ *         sequence number, a selective ACK of the last datagrams received
+ *         from the destination, and the EDC of the sender. Receivers delay
+ *         their ACKs for ORPL_RDGRAM_ACK_DELAY, so that the ACKs of several
+ *         datagrams are aggregated and can ride on any datagram going
+ *         back, typically upwards collect traffic sent with
+ *         orpl_rdgram_sendto_unreliable(). The retransmission timeout is
+ *         derived from the EDC of both ends, i.e. from the expected number
+ *         of wake-up intervals to the peer and back.
+ *         The application data stays at the end of the datagram, where
+ *         the ORPL logs look for it.
+ */
+
+#include "contiki.h"
+#include "net/uip.h"
+#include "net/netstack.h"
+#include "net/simple-udp.h"
+#include "lib/random.h"
+#include "orpl.h"
+#include "orpl-rdgram.h"
+#include <string.h>
+
+#if WITH_ORPL && WITH_ORPL_RDGRAM
+
+#define RDGRAM_FLAG_RELIABLE 0x01 /* seqno is valid, the datagram must be acked */
+#define RDGRAM_FLAG_ACK      0x02 /* ack_seqno and ack_bits are valid */
+
+struct rdgram_hdr {
+  uint8_t flags;
+  uint8_t seqno;
+  /* Last sequence number received from the destination. Bit i of
+   * ack_bits is set if ack_seqno - 1 - i was received as well. */
+  uint8_t ack_seqno;
+  uint8_t ack_bits;
+  rpl_rank_t edc;
+};
+
+#define PEER_USED        0x01
+#define PEER_RX_VALID    0x02
+#define PEER_ACK_PENDING 0x04
+
+struct peer {
+  uip_ipaddr_t ipaddr;
+  /* Connection to send standalone ACKs on */
+  struct orpl_rdgram_conn *conn;
+  rpl_rank_t edc;
+  uint8_t tx_seqno;
+  uint8_t rx_seqno;
+  uint8_t rx_bits;
+  uint8_t flags;
+  unsigned long last_used;
+  struct ctimer ack_timer;
+};
+static struct peer peers[ORPL_RDGRAM_PEERS];
+
+/* Reliable datagrams awaiting an ACK */
+struct pending {
+  struct orpl_rdgram_conn *conn; /* NULL if the entry is free */
+  struct peer *peer;
+  uint8_t seqno;
+  uint8_t retx;
+  uint16_t len;
+  uint8_t data[ORPL_RDGRAM_MAX_LEN];
+  struct ctimer retx_timer;
+};
+static struct pending queue[ORPL_RDGRAM_QUEUE];
+
+static uint8_t buf[sizeof(struct rdgram_hdr) + ORPL_RDGRAM_MAX_LEN];
+
+/* Returns 1 if a datagram awaiting an ACK refers to a peer */
+static int
+peer_has_pending(const struct peer *p)
+{
+  int i;
+  for(i = 0; i < ORPL_RDGRAM_QUEUE; i++) {
+    if(queue[i].conn != NULL && queue[i].peer == p) {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+/* Look a peer up, and add it if create is set. Peers with datagrams
+ * awaiting an ACK are never evicted. */
+static struct peer *
+peer_lookup(const uip_ipaddr_t *ipaddr, int create)
+{
+  int i;
+  struct peer *p = NULL;
+  for(i = 0; i < ORPL_RDGRAM_PEERS; i++) {
+    if((peers[i].flags & PEER_USED) && uip_ipaddr_cmp(&peers[i].ipaddr, ipaddr)) {
+      peers[i].last_used = clock_seconds();
+      return &peers[i];
+    }
+  }
+  if(!create) {
+    return NULL;
+  }
+  /* Take a free entry, or the least recently used one */
+  for(i = 0; i < ORPL_RDGRAM_PEERS; i++) {
+    if(!(peers[i].flags & PEER_USED)) {
+      p = &peers[i];
+      break;
+    }
+    if(!peer_has_pending(&peers[i]) && (p == NULL || peers[i].last_used < p->last_used)) {
+      p = &peers[i];
+    }
+  }
+  if(p == NULL) {
+    return NULL;
+  }
+  ctimer_stop(&p->ack_timer);
+  uip_ipaddr_copy(&p->ipaddr, ipaddr);
+  p->conn = NULL;
+  /* Until we hear from the peer, assume a symmetric path */
+  p->edc = orpl_current_edc();
+  p->tx_seqno = random_rand();
+  p->flags = PEER_USED;
+  p->last_used = clock_seconds();
+  return p;
+}
+
+/* Retransmission timeout for a peer: twice the expected time to the
+ * peer and back plus the ACK delay, with exponential backoff. Our EDC
+ * and that of the peer bound the path through their common ancestor. */
+static clock_time_t
+rto(const struct peer *p, uint8_t retx)
+{
+  uint32_t path_edc = (uint32_t)orpl_current_edc() + p->edc;
+  uint32_t timeout = ORPL_RDGRAM_ACK_DELAY
+      + (4 * path_edc * NETSTACK_RDC.channel_check_interval()) / EDC_DIVISOR;
+  timeout <<= retx;
+  if(timeout < ORPL_RDGRAM_MIN_RTO) {
+    timeout = ORPL_RDGRAM_MIN_RTO;
+  }
+  if(timeout > ORPL_RDGRAM_MAX_RTO) {
+    timeout = ORPL_RDGRAM_MAX_RTO;
+  }
+  return (clock_time_t)timeout;
+}
+
+/* Send a datagram with our header, carrying the pending ACK of the peer */
+static void
+rdgram_send(struct orpl_rdgram_conn *c, struct peer *p, const uip_ipaddr_t *dest,
+    uint8_t flags, uint8_t seqno, const void *data, uint16_t datalen)
+{
+  struct rdgram_hdr hdr;
+  memset(&hdr, 0, sizeof(hdr));
+  hdr.flags = flags;
+  hdr.seqno = seqno;
+  hdr.edc = orpl_current_edc();
+  if(p != NULL && (p->flags & PEER_ACK_PENDING)) {
+    hdr.flags |= RDGRAM_FLAG_ACK;
+    hdr.ack_seqno = p->rx_seqno;
+    hdr.ack_bits = p->rx_bits;
+    p->flags &= ~PEER_ACK_PENDING;
+    ctimer_stop(&p->ack_timer);
+  }
+  memcpy(buf, &hdr, sizeof(hdr));
+  if(datalen > 0) {
+    memcpy(buf + sizeof(hdr), data, datalen);
+  }
+  simple_udp_sendto(&c->udp, buf, sizeof(hdr) + datalen, dest);
+}
+
+/* No datagram went back to the peer in time, send the ACK alone */
+static void
+ack_timeout(void *ptr)
+{
+  struct peer *p = ptr;
+  if((p->flags & PEER_ACK_PENDING) && p->conn != NULL) {
+    ORPL_LOG("RDG: ack to %u seq %u\n", ORPL_LOG_NODEID_FROM_IPADDR(&p->ipaddr), p->rx_seqno);
+    orpl_set_curr_seqno(0);
+    rdgram_send(p->conn, p, &p->ipaddr, 0, 0, NULL, 0);
+  }
+}
+
+static void
+retx_timeout(void *ptr)
+{
+  struct pending *q = ptr;
+  struct orpl_rdgram_conn *c = q->conn;
+  if(c == NULL) {
+    return;
+  }
+  if(q->retx >= ORPL_RDGRAM_MAX_RETX) {
+    ORPL_LOG("RDG:! giving up seq %u to %u\n", q->seqno,
+        ORPL_LOG_NODEID_FROM_IPADDR(&q->peer->ipaddr));
+    if(c->sent_callback != NULL) {
+      c->sent_callback(c, &q->peer->ipaddr, q->data, q->len, ORPL_RDGRAM_TIMEOUT);
+    }
+    q->conn = NULL;
+    return;
+  }
+  q->retx++;
+  ORPL_LOG("RDG: retx %u seq %u to %u\n", q->retx, q->seqno,
+      ORPL_LOG_NODEID_FROM_IPADDR(&q->peer->ipaddr));
+  /* Retransmissions need a new ORPL sequence number, or forwarders
+   * that saw the first copy drop them as duplicates */
+  orpl_set_curr_seqno(0);
+  rdgram_send(c, q->peer, &q->peer->ipaddr, RDGRAM_FLAG_RELIABLE, q->seqno, q->data, q->len);
+  ctimer_set(&q->retx_timer, rto(q->peer, q->retx), retx_timeout, q);
+}
+
+/* Release the datagrams to a peer covered by a selective ACK */
+static void
+ack_received(struct peer *p, uint8_t ack_seqno, uint8_t ack_bits)
+{
+  int i;
+  for(i = 0; i < ORPL_RDGRAM_QUEUE; i++) {
+    struct pending *q = &queue[i];
+    uint8_t diff = ack_seqno - q->seqno;
+    if(q->conn != NULL && q->peer == p
+        && (diff == 0 || (diff <= 8 && (ack_bits & (1 << (diff - 1)))))) {
+      ctimer_stop(&q->retx_timer);
+      ORPL_LOG("RDG: acked seq %u by %u after %u retx\n", q->seqno,
+          ORPL_LOG_NODEID_FROM_IPADDR(&p->ipaddr), q->retx);
+      if(q->conn->sent_callback != NULL) {
+        q->conn->sent_callback(q->conn, &p->ipaddr, q->data, q->len, ORPL_RDGRAM_ACKED);
+      }
+      q->conn = NULL;
+    }
+  }
+}
+
+/* Record a sequence number received from a peer.
+ * Returns 0 if it is a duplicate. */
+static int
+rx_register(struct peer *p, uint8_t seqno)
+{
+  int8_t diff = seqno - p->rx_seqno;
+  if(!(p->flags & PEER_RX_VALID) || diff < -8) {
+    /* First datagram, or the peer rebooted */
+    p->rx_seqno = seqno;
+    p->rx_bits = 0;
+    p->flags |= PEER_RX_VALID;
+    return 1;
+  }
+  if(diff > 0) {
+    /* Slide the window, the previous last seqno is now at diff - 1 */
+    p->rx_bits = diff > 8 ? 0 : (uint8_t)((((uint16_t)p->rx_bits << 1) | 1) << (diff - 1));
+    p->rx_seqno = seqno;
+    return 1;
+  }
+  if(diff == 0 || (p->rx_bits & (1 << (-diff - 1)))) {
+    return 0;
+  }
+  p->rx_bits |= 1 << (-diff - 1);
+  return 1;
+}
+
+static void
+udp_received(struct simple_udp_connection *udp,
+         const uip_ipaddr_t *sender_addr,
+         uint16_t sender_port,
+         const uip_ipaddr_t *receiver_addr,
+         uint16_t receiver_port,
+         const uint8_t *data,
+         uint16_t datalen)
+{
+  struct orpl_rdgram_conn *c = (struct orpl_rdgram_conn *)udp;
+  struct rdgram_hdr hdr;
+  struct peer *p;
+
+  if(datalen < sizeof(hdr)) {
+    return;
+  }
+  memcpy(&hdr, data, sizeof(hdr));
+
+  p = peer_lookup(sender_addr, hdr.flags & RDGRAM_FLAG_RELIABLE);
+  if(p != NULL) {
+    p->conn = c;
+    p->edc = hdr.edc;
+  }
+
+  if(hdr.flags & RDGRAM_FLAG_RELIABLE) {
+    int is_new;
+    if(p == NULL) {
+      /* We can't track it, the sender will try again */
+      return;
+    }
+    is_new = rx_register(p, hdr.seqno);
+    /* Duplicates are acked again, our ACK was probably lost. A reply
+     * from the input callback carries the ACK right away. */
+    if(!(p->flags & PEER_ACK_PENDING)) {
+      p->flags |= PEER_ACK_PENDING;
+      ctimer_set(&p->ack_timer, ORPL_RDGRAM_ACK_DELAY, ack_timeout, p);
+    }
+    if(!is_new) {
+      ORPL_LOG("RDG: duplicate seq %u from %u\n", hdr.seqno,
+          ORPL_LOG_NODEID_FROM_IPADDR(sender_addr));
+    } else if(datalen > sizeof(hdr) && c->input_callback != NULL) {
+      c->input_callback(c, sender_addr, data + sizeof(hdr), datalen - sizeof(hdr));
+    }
+  } else if(datalen > sizeof(hdr) && c->input_callback != NULL) {
+    c->input_callback(c, sender_addr, data + sizeof(hdr), datalen - sizeof(hdr));
+  }
+
+  /* Done with uip_buf, the sent callbacks may send */
+  if(p != NULL && (hdr.flags & RDGRAM_FLAG_ACK)) {
+    ORPL_LOG("RDG: %s ack from %u seq %u\n",
+        datalen > sizeof(hdr) ? "piggybacked" : "standalone",
+        ORPL_LOG_NODEID_FROM_IPADDR(sender_addr), hdr.ack_seqno);
+    ack_received(p, hdr.ack_seqno, hdr.ack_bits);
+  }
+}
+
+/* Register a reliable datagram connection. Both ends must use it. */
+int
+orpl_rdgram_register(struct orpl_rdgram_conn *c, uint16_t port,
+    orpl_rdgram_input_callback input_callback,
+    orpl_rdgram_sent_callback sent_callback)
+{
+  c->input_callback = input_callback;
+  c->sent_callback = sent_callback;
+  return simple_udp_register(&c->udp, port, NULL, port, udp_received);
+}
+
+/* Send a datagram, retransmitted until acked. The application calls
+ * orpl_set_curr_seqno() right before, as with simple-udp; retransmissions
+ * take a fresh ORPL sequence number. Returns 0 if the queue is full. */
+int
+orpl_rdgram_sendto(struct orpl_rdgram_conn *c, const void *data,
+    uint16_t datalen, const uip_ipaddr_t *dest)
+{
+  int i;
+  struct pending *q = NULL;
+  struct peer *p;
+
+  if(datalen > ORPL_RDGRAM_MAX_LEN) {
+    return 0;
+  }
+  for(i = 0; i < ORPL_RDGRAM_QUEUE; i++) {
+    if(queue[i].conn == NULL) {
+      q = &queue[i];
+      break;
+    }
+  }
+  p = peer_lookup(dest, 1);
+  if(q == NULL || p == NULL) {
+    ORPL_LOG("RDG:! queue full\n");
+    return 0;
+  }
+
+  q->conn = c;
+  q->peer = p;
+  q->seqno = p->tx_seqno++;
+  q->retx = 0;
+  q->len = datalen;
+  memcpy(q->data, data, datalen);
+  rdgram_send(c, p, dest, RDGRAM_FLAG_RELIABLE, q->seqno, q->data, q->len);
+  ctimer_set(&q->retx_timer, rto(p, 0), retx_timeout, q);
+  return 1;
+}
+
+/* Send a datagram without reliability, e.g. collect traffic. It carries
+ * the ACKs we owe to the destination. */
+int
+orpl_rdgram_sendto_unreliable(struct orpl_rdgram_conn *c, const void *data,
+    uint16_t datalen, const uip_ipaddr_t *dest)
+{
+  if(datalen > ORPL_RDGRAM_MAX_LEN) {
+    return 0;
+  }
+  rdgram_send(c, peer_lookup(dest, 0), dest, 0, 0, data, datalen);
+  return 1;
+}
+
+#endif /* WITH_ORPL && WITH_ORPL_RDGRAM */
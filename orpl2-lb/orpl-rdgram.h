@@ -0,0 +1,127 @@
+/*
+ * Copyright (c) 2014, Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+
+
+/**
+ * \file
+ *         Header file for orpl-rdgram.c, reliable datagrams on top of
+ *         simple-udp
+ */
+
+#ifndef __ORPL_RDGRAM_H__
+#define __ORPL_RDGRAM_H__
+
+#include "contiki.h"
+#include "net/uip.h"
+#include "net/simple-udp.h"
+
+/* Number of reliable datagrams awaiting an ACK */
+#ifdef ORPL_CONF_RDGRAM_QUEUE
+#define ORPL_RDGRAM_QUEUE ORPL_CONF_RDGRAM_QUEUE
+#else /* ORPL_CONF_RDGRAM_QUEUE */
+#define ORPL_RDGRAM_QUEUE 2
+#endif /* ORPL_CONF_RDGRAM_QUEUE */
+
+/* Maximum payload of a reliable datagram, copied for retransmissions */
+#ifdef ORPL_CONF_RDGRAM_MAX_LEN
+#define ORPL_RDGRAM_MAX_LEN ORPL_CONF_RDGRAM_MAX_LEN
+#else /* ORPL_CONF_RDGRAM_MAX_LEN */
+#define ORPL_RDGRAM_MAX_LEN 48
+#endif /* ORPL_CONF_RDGRAM_MAX_LEN */
+
+/* Number of peers we keep sequence numbers, ACK state and EDC for */
+#ifdef ORPL_CONF_RDGRAM_PEERS
+#define ORPL_RDGRAM_PEERS ORPL_CONF_RDGRAM_PEERS
+#else /* ORPL_CONF_RDGRAM_PEERS */
+#define ORPL_RDGRAM_PEERS 4
+#endif /* ORPL_CONF_RDGRAM_PEERS */
+
+/* Retransmissions before giving up on a datagram */
+#ifdef ORPL_CONF_RDGRAM_MAX_RETX
+#define ORPL_RDGRAM_MAX_RETX ORPL_CONF_RDGRAM_MAX_RETX
+#else /* ORPL_CONF_RDGRAM_MAX_RETX */
+#define ORPL_RDGRAM_MAX_RETX 3
+#endif /* ORPL_CONF_RDGRAM_MAX_RETX */
+
+/* Time a receiver waits for traffic to the sender to piggyback its
+ * ACK on, before sending it alone. ACKs of all datagrams received from
+ * that sender in the meantime are aggregated. */
+#ifdef ORPL_CONF_RDGRAM_ACK_DELAY
+#define ORPL_RDGRAM_ACK_DELAY ORPL_CONF_RDGRAM_ACK_DELAY
+#else /* ORPL_CONF_RDGRAM_ACK_DELAY */
+#define ORPL_RDGRAM_ACK_DELAY (4 * CLOCK_SECOND)
+#endif /* ORPL_CONF_RDGRAM_ACK_DELAY */
+
+/* Bounds of the retransmission timeout */
+#define ORPL_RDGRAM_MIN_RTO (2 * CLOCK_SECOND)
+#define ORPL_RDGRAM_MAX_RTO (120 * CLOCK_SECOND)
+
+/* Status passed to the sent callback */
+enum {
+  ORPL_RDGRAM_ACKED,
+  ORPL_RDGRAM_TIMEOUT,
+};
+
+struct orpl_rdgram_conn;
+
+/* Called for every datagram received, without duplicates */
+typedef void (* orpl_rdgram_input_callback)(struct orpl_rdgram_conn *c,
+    const uip_ipaddr_t *sender_addr,
+    const uint8_t *data, uint16_t datalen);
+
+/* Called once a reliable datagram was acked, or given up on */
+typedef void (* orpl_rdgram_sent_callback)(struct orpl_rdgram_conn *c,
+    const uip_ipaddr_t *dest_addr,
+    const uint8_t *data, uint16_t datalen, int status);
+
+struct orpl_rdgram_conn {
+  struct simple_udp_connection udp;
+  orpl_rdgram_input_callback input_callback;
+  orpl_rdgram_sent_callback sent_callback;
+};
+
+/* Register a reliable datagram connection. Both ends must use it. */
+int orpl_rdgram_register(struct orpl_rdgram_conn *c, uint16_t port,
+    orpl_rdgram_input_callback input_callback,
+    orpl_rdgram_sent_callback sent_callback);
+/* Send a datagram, retransmitted until acked. The application calls
+ * orpl_set_curr_seqno() right before, as with simple-udp; retransmissions
+ * take a fresh ORPL sequence number. Returns 0 if the queue is full. */
+int orpl_rdgram_sendto(struct orpl_rdgram_conn *c, const void *data,
+    uint16_t datalen, const uip_ipaddr_t *dest);
+/* Send a datagram without reliability, e.g. collect traffic. It carries
+ * the ACKs we owe to the destination. */
+int orpl_rdgram_sendto_unreliable(struct orpl_rdgram_conn *c, const void *data,
+    uint16_t datalen, const uip_ipaddr_t *dest);
+
+#endif /* __ORPL_RDGRAM_H__ */
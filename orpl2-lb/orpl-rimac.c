@@ -0,0 +1,648 @@
+/*
+ * Copyright (c) 2014, Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+
+
+/**
+ * \file
+ *         Receiver-initiated radio duty cycling for ORPL, an alternative to
+ *         ContikiMAC-ORPL selected with WITH_ORPL_RIMAC.
+ *
+ *         Every cycle, nodes wake up, broadcast a short wake-up beacon
+ *         carrying their EDC and a digest of their routing set, and listen
+ *         for a few ms. A sender keeps its radio on until it hears the
+ *         beacon of a suitable forwarder, and only then transmits. The
+ *         receiver decides whether to take the frame with the usual anycast
+ *         ack decision from the softack interrupt, so routing is unchanged.
+ *         Broadcasts are sent after every beacon heard during a full cycle.
+ *
+ *         Beacons are 802.15.4 beacon frames, which the softack driver never
+ *         acks: FCF (2), seqno, source PAN ID (2), source address (8), then
+ *         ORPL_RIMAC_BEACON_ID, our EDC (2) and routing set digest (1).
+ */
+
+#include "contiki-conf.h"
+#include "dev/radio.h"
+#include "dev/watchdog.h"
+#include "lib/random.h"
+#include "net/netstack.h"
+#include "net/rime.h"
+#include "net/mac/frame802154.h"
+#include "sys/pt.h"
+#include "sys/rtimer.h"
+#include "orpl.h"
+#include "orpl-anycast.h"
+#include "orpl-routing-set.h"
+#include "orpl-rimac.h"
+#include "orpl-radio-stats.h"
+#include "orpl-fast-forward.h"
+#if WITH_ORPL_ENERGY
+#include "orpl-energy.h"
+#endif /* WITH_ORPL_ENERGY */
+#include "net/rpl/rpl-private.h"
+#include "deployment.h"
+#include "orpl-log.h"
+#include <string.h>
+
+#if WITH_ORPL && WITH_ORPL_RIMAC
+
+#define DEBUG 0
+#if DEBUG
+#include <stdio.h>
+#define PRINTF(...) printf(__VA_ARGS__)
+#else
+#define PRINTF(...)
+#endif
+
+/* Wake-up period, same as ContikiMAC-ORPL for comparison */
+#ifdef CONTIKIMAC_CONF_CYCLE_TIME
+#define CYCLE_TIME (CONTIKIMAC_CONF_CYCLE_TIME)
+#else
+#define CYCLE_TIME (RTIMER_ARCH_SECOND / NETSTACK_RDC_CHANNEL_CHECK_RATE)
+#endif
+
+/* How long a sender listens for beacons before giving up. All neighbors
+ * beacon once per cycle. */
+#define LISTEN_TIME (CYCLE_TIME + CYCLE_TIME / 8)
+
+/* How long we wait for an ACK after transmitting */
+#if WITH_ORPL_ACK_SLOTS
+#define ACK_WAIT_TIME (RTIMER_ARCH_SECOND / 1000 + (ORPL_ACK_SLOTS - 1) * ORPL_ACK_SLOT_TIME)
+#else /* WITH_ORPL_ACK_SLOTS */
+#define ACK_WAIT_TIME (RTIMER_ARCH_SECOND / 1000)
+#endif /* WITH_ORPL_ACK_SLOTS */
+
+/* Senders woken up by the same beacon back off for a random number of
+ * slots before transmitting, and yield to whoever started first */
+#define BACKOFF_SLOT_TIME (RTIMER_ARCH_SECOND / 2000)
+#define BACKOFF_SLOTS 4
+
+/* Same header as ContikiMAC-ORPL, so that anycast frames have the same
+ * layout and can be parsed from the softack interrupt */
+#if CONTIKIMAC_CONF_WITH_CONTIKIMAC_HEADER
+#define CONTIKIMAC_ID 0x00
+struct hdr {
+  uint8_t id;
+  uint8_t len;
+};
+#endif /* CONTIKIMAC_CONF_WITH_CONTIKIMAC_HEADER */
+
+#define ACK_LEN (3 + EXTRA_ACK_LEN)
+
+/* Wake-up beacon */
+#define ORPL_RIMAC_BEACON_ID 0x52
+#define BEACON_LEN 17
+
+struct beacon_info {
+  rimeaddr_t src;
+  rpl_rank_t edc;
+  uint8_t digest;
+};
+
+/* Shared with ContikiMAC-ORPL and the softack driver */
+extern volatile uint8_t contikimac_keep_radio_on;
+extern volatile unsigned char we_are_sending;
+
+static volatile uint8_t rimac_is_on = 0;
+static volatile uint8_t radio_is_on = 0;
+static struct rtimer rt;
+static struct pt pt;
+static volatile rtimer_clock_t cycle_start;
+static uint8_t beacon_seqno;
+
+/* Link-layer duplicate detection, for broadcasts */
+struct seqno {
+  rimeaddr_t sender;
+  uint8_t seqno;
+};
+#define MAX_SEQNOS_LL 8
+static struct seqno received_seqnos[MAX_SEQNOS_LL];
+
+/*---------------------------------------------------------------------------*/
+static void
+on(void)
+{
+  if(rimac_is_on && radio_is_on == 0) {
+    radio_is_on = 1;
+    NETSTACK_RADIO.on();
+    ORPL_RADIO_STATS(orpl_radio_stats_on());
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+off(void)
+{
+  if(rimac_is_on && radio_is_on != 0 &&
+     contikimac_keep_radio_on == 0) {
+    radio_is_on = 0;
+    NETSTACK_RADIO.off();
+    ORPL_RADIO_STATS(orpl_radio_stats_off());
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* Returns a digest of our routing set: the number of bits set, 0 when
+ * routing sets are not in use. Senders skip leaves for downward traffic. */
+static uint8_t
+routing_set_digest(void)
+{
+  int bits;
+  if(!orpl_are_routing_set_active()) {
+    return 0;
+  }
+  bits = orpl_routing_set_count_bits();
+  return bits > 0xff ? 0xff : bits;
+}
+/*---------------------------------------------------------------------------*/
+static void
+send_beacon(void)
+{
+  uint8_t beacon[BEACON_LEN];
+  rpl_rank_t edc = orpl_current_edc();
+  int i;
+
+  beacon[0] = FRAME802154_BEACONFRAME;
+  beacon[1] = FRAME802154_LONGADDRMODE << 6;
+  beacon[2] = beacon_seqno++;
+  beacon[3] = 0xff; /* Broadcast PAN ID */
+  beacon[4] = 0xff;
+  for(i = 0; i < 8; i++) {
+    beacon[5 + i] = rimeaddr_node_addr.u8[7 - i];
+  }
+  beacon[13] = ORPL_RIMAC_BEACON_ID;
+  beacon[14] = edc & 0xff;
+  beacon[15] = edc >> 8;
+  beacon[16] = routing_set_digest();
+
+  NETSTACK_RADIO.prepare(beacon, BEACON_LEN);
+  NETSTACK_RADIO.transmit(BEACON_LEN);
+}
+/*---------------------------------------------------------------------------*/
+/* Returns 1 if buf is a wake-up beacon, and parses it */
+static int
+parse_beacon(const uint8_t *buf, int len, struct beacon_info *b)
+{
+  int i;
+  if(len != BEACON_LEN || (buf[0] & 7) != FRAME802154_BEACONFRAME
+      || buf[13] != ORPL_RIMAC_BEACON_ID) {
+    return 0;
+  }
+  for(i = 0; i < 8; i++) {
+    b->src.u8[i] = buf[5 + 7 - i];
+  }
+  b->edc = buf[14] | (buf[15] << 8);
+  b->digest = buf[16];
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+/* Returns 1 if the node that sent a beacon may take our packet. This only
+ * filters out hopeless forwarders, the receiver makes the final decision. */
+static int
+is_suitable_forwarder(const struct beacon_info *b, int is_broadcast)
+{
+  rpl_rank_t curr_edc = orpl_current_edc();
+  if(is_broadcast) {
+    return 1;
+  }
+  switch(packetbuf_attr(PACKETBUF_ATTR_ORPL_DIRECTION)) {
+    case direction_up:
+      /* Same progress the receiver requires */
+      return curr_edc > ORPL_EDC_W && b->edc < curr_edc - ORPL_EDC_W;
+    case direction_down:
+      /* Forwarders are deeper than us and have children. The destination
+       * itself may be a leaf, only a leaf can ack for itself. */
+      return b->edc != 0xffff && (b->digest != 0 || b->edc > curr_edc);
+    case direction_none:
+      /* Plain unicast: wait for the receiver */
+      return rimeaddr_cmp(&b->src, packetbuf_addr(PACKETBUF_ADDR_RECEIVER));
+    default:
+      return 1;
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void schedule_powercycle(struct rtimer *t, rtimer_clock_t time);
+static char
+powercycle(struct rtimer *t, void *ptr)
+{
+  PT_BEGIN(&pt);
+
+  cycle_start = RTIMER_NOW();
+
+  while(1) {
+    static uint8_t extended;
+
+    /* Don't beacon while sending (we are listening for beacons) or while
+     * a frame is waiting to be read */
+    if(we_are_sending == 0 && !NETSTACK_RADIO.receiving_packet()
+        && !NETSTACK_RADIO.pending_packet()) {
+      ORPL_RADIO_STATS(orpl_radio_stats_set_activity(ORPL_RADIO_CCA, ORPL_RADIO_OWN));
+      on();
+      send_beacon();
+      ORPL_RADIO_STATS(orpl_radio_stats_set_activity(ORPL_RADIO_FALSE_WAKEUP, ORPL_RADIO_OWN));
+
+      /* Listen for data. Stay a bit longer if we are receiving. */
+      extended = 0;
+      schedule_powercycle(t, ORPL_RIMAC_DWELL_TIME);
+      PT_YIELD(&pt);
+      while(we_are_sending == 0 && extended < 2
+          && (NETSTACK_RADIO.receiving_packet() || NETSTACK_RADIO.pending_packet())) {
+        if(extended++ == 0) {
+          ORPL_RADIO_STATS(orpl_radio_stats_reclassify(ORPL_RADIO_RX));
+        }
+        schedule_powercycle(t, ORPL_RIMAC_DWELL_TIME);
+        PT_YIELD(&pt);
+      }
+      if(we_are_sending == 0) {
+        off();
+      }
+    }
+
+    /* Jitter the next wake-up, so that neighbors' beacons don't keep colliding */
+    cycle_start += CYCLE_TIME - CYCLE_TIME / 32 + (random_rand() % (CYCLE_TIME / 16));
+    schedule_powercycle(t, cycle_start - RTIMER_TIME(t));
+    PT_YIELD(&pt);
+  }
+
+  PT_END(&pt);
+}
+/*---------------------------------------------------------------------------*/
+static void
+schedule_powercycle(struct rtimer *t, rtimer_clock_t time)
+{
+  if(rimac_is_on) {
+    if(RTIMER_CLOCK_LT(RTIMER_TIME(t) + time, RTIMER_NOW() + 2)) {
+      time = RTIMER_NOW() - RTIMER_TIME(t) + 2;
+    }
+    if(rtimer_set(t, RTIMER_TIME(t) + time, 1,
+                  (void (*)(struct rtimer *, void *))powercycle, NULL) != RTIMER_OK) {
+      PRINTF("orpl-rimac: could not set rtimer\n");
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+static int
+send_packet(void)
+{
+  rtimer_clock_t t0, wt, bt;
+  uint8_t buf[ACK_LEN > BEACON_LEN ? ACK_LEN : BEACON_LEN];
+  struct beacon_info b;
+  rimeaddr_t dest;
+  uint8_t is_broadcast = 0;
+  uint8_t got_ack = 0;
+  uint8_t seqno;
+  int hdrlen, transmit_len, len;
+  uint16_t wait_time;
+#if CONTIKIMAC_CONF_WITH_CONTIKIMAC_HEADER
+  struct hdr *chdr;
+#endif /* CONTIKIMAC_CONF_WITH_CONTIKIMAC_HEADER */
+
+  if(!rimac_is_on && !contikimac_keep_radio_on) {
+    return MAC_TX_ERR_FATAL;
+  }
+  if(packetbuf_totlen() == 0) {
+    return MAC_TX_ERR_FATAL;
+  }
+
+  packetbuf_set_addr(PACKETBUF_ADDR_SENDER, &rimeaddr_node_addr);
+  if(rimeaddr_cmp(packetbuf_addr(PACKETBUF_ADDR_RECEIVER), &rimeaddr_null)) {
+    is_broadcast = 1;
+  } else {
+    orpl_anycast_set_packetbuf_addr();
+  }
+  packetbuf_set_attr(PACKETBUF_ATTR_MAC_ACK, 1);
+
+#if WITH_ORPL_DELAY_TRACE
+  {
+    uint16_t strobe_ms = packetbuf_attr(PACKETBUF_ATTR_ORPL_STROBE_TIME);
+    clock_time_t residence = clock_time() - (clock_time_t)packetbuf_attr(PACKETBUF_ATTR_ORPL_ENQUEUE_TIME);
+    uint16_t hop_ms = (uint16_t)(((uint32_t)residence * 1000) / CLOCK_SECOND);
+    ORPL_LOG_ADD_DELAY_FROM_PACKETBUF(hop_ms > strobe_ms ? hop_ms - strobe_ms : 0, strobe_ms);
+  }
+#endif /* WITH_ORPL_DELAY_TRACE */
+
+#if CONTIKIMAC_CONF_WITH_CONTIKIMAC_HEADER
+  hdrlen = packetbuf_totlen();
+  if(packetbuf_hdralloc(sizeof(struct hdr)) == 0) {
+    return MAC_TX_ERR_FATAL;
+  }
+  chdr = packetbuf_hdrptr();
+  chdr->id = CONTIKIMAC_ID;
+  chdr->len = hdrlen;
+  hdrlen = NETSTACK_FRAMER.create();
+  if(hdrlen < 0) {
+    packetbuf_hdr_remove(sizeof(struct hdr));
+    return MAC_TX_ERR_FATAL;
+  }
+  hdrlen += sizeof(struct hdr);
+#else /* CONTIKIMAC_CONF_WITH_CONTIKIMAC_HEADER */
+  hdrlen = NETSTACK_FRAMER.create();
+  if(hdrlen < 0) {
+    return MAC_TX_ERR_FATAL;
+  }
+#endif /* CONTIKIMAC_CONF_WITH_CONTIKIMAC_HEADER */
+  packetbuf_compact();
+  transmit_len = packetbuf_totlen();
+  seqno = packetbuf_attr(PACKETBUF_ATTR_MAC_SEQNO);
+
+  /* Keep the powercycle from beaconing, and the softack driver from
+   * turning the radio off, while we listen */
+  we_are_sending = 1;
+#if WITH_ORPL_RADIO_STATS
+  orpl_radio_stats_set_activity(is_broadcast ? ORPL_RADIO_TX_BROADCAST
+      : (packetbuf_attr(PACKETBUF_ATTR_ORPL_DIRECTION) != direction_none ? ORPL_RADIO_TX_ANYCAST
+      : ORPL_RADIO_TX_UNICAST),
+      packetbuf_attr(PACKETBUF_ATTR_ORPL_FORWARDED) ? ORPL_RADIO_FORWARDED : ORPL_RADIO_OWN);
+#endif /* WITH_ORPL_RADIO_STATS */
+  on();
+
+  t0 = RTIMER_NOW();
+  while(RTIMER_CLOCK_LT(RTIMER_NOW(), t0 + LISTEN_TIME)) {
+    watchdog_periodic();
+
+    if(!NETSTACK_RADIO.pending_packet()) {
+      continue;
+    }
+    len = NETSTACK_RADIO.read(buf, sizeof(buf));
+    if(!parse_beacon(buf, len, &b) || !is_suitable_forwarder(&b, is_broadcast)) {
+      continue;
+    }
+
+    bt = RTIMER_NOW() + (random_rand() % BACKOFF_SLOTS) * BACKOFF_SLOT_TIME;
+    while(RTIMER_CLOCK_LT(RTIMER_NOW(), bt));
+    if(NETSTACK_RADIO.receiving_packet() || NETSTACK_RADIO.pending_packet()
+        || !NETSTACK_RADIO.channel_clear()) {
+      /* Another sender got the beacon first, wait for the next one */
+      continue;
+    }
+
+    /* The TX FIFO may hold an ACK we sent meanwhile, prepare every time */
+    NETSTACK_RADIO.prepare(packetbuf_hdrptr(), transmit_len);
+    if(NETSTACK_RADIO.transmit(transmit_len) != RADIO_TX_OK) {
+      continue;
+    }
+
+    /* Wait for the ACK of the forwarder (or of the broadcast receiver) */
+    wt = RTIMER_NOW();
+    while(RTIMER_CLOCK_LT(RTIMER_NOW(), wt + ACK_WAIT_TIME)) {
+      if(NETSTACK_RADIO.pending_packet()) {
+        len = NETSTACK_RADIO.read(buf, sizeof(buf));
+        if(len == ACK_LEN && buf[2] == seqno) {
+          memcpy(&dest, buf + 3, 8);
+          rpl_set_parent_rank((uip_lladdr_t *)&dest, (buf[3+8+1] << 8) + buf[3+8]);
+#if WITH_ORPL_ENERGY
+          orpl_energy_set_neighbor((uip_lladdr_t *)&dest, buf[3+8+2]);
+#endif /* WITH_ORPL_ENERGY */
+          if(is_broadcast) {
+            orpl_broadcast_acked(&dest);
+          } else {
+            orpl_strobe_acked(&dest);
+            got_ack = 1;
+          }
+          break;
+        }
+      }
+    }
+    if(got_ack) {
+      break;
+    }
+  }
+
+  if(is_broadcast) {
+    orpl_broadcast_done();
+  }
+
+  /* The waiting time is the cost of the hop, as the strobing time is in
+   * ContikiMAC-ORPL */
+  wait_time = EDC_TICKS_TO_METRIC(RTIMER_NOW() - t0);
+  if(wait_time < EDC_DIVISOR/16) {
+    wait_time = EDC_DIVISOR/16;
+  }
+  packetbuf_set_attr(PACKETBUF_ATTR_EDC, packetbuf_attr(PACKETBUF_ATTR_EDC) + wait_time);
+#if WITH_ORPL_DELAY_TRACE
+  packetbuf_set_attr(PACKETBUF_ATTR_ORPL_STROBE_TIME, packetbuf_attr(PACKETBUF_ATTR_ORPL_STROBE_TIME)
+      + (uint16_t)(((uint32_t)(rtimer_clock_t)(RTIMER_NOW() - t0) * 1000) / RTIMER_ARCH_SECOND));
+#endif /* WITH_ORPL_DELAY_TRACE */
+
+  we_are_sending = 0;
+  off();
+  packetbuf_hdr_remove(hdrlen);
+
+  if(is_broadcast) {
+    return MAC_TX_OK;
+  }
+  if(got_ack) {
+    ORPL_LOG_FROM_PACKETBUF("Cmac: acked by %u s %u c %d seq %u",
+        ORPL_LOG_NODEID_FROM_RIMEADDR(&dest), wait_time, 0, seqno);
+    packetbuf_set_addr(PACKETBUF_ADDR_RECEIVER, &dest);
+    if(packetbuf_attr(PACKETBUF_ATTR_ORPL_DIRECTION) == direction_down) {
+      orpl_acked_down_insert(orpl_packetbuf_seqno(), &dest);
+    }
+    return MAC_TX_OK;
+  }
+  ORPL_LOG_FROM_PACKETBUF("Cmac:! noack s %u c %d seq %u", wait_time, 0, seqno);
+  return MAC_TX_NOACK;
+}
+/*---------------------------------------------------------------------------*/
+static void
+qsend_packet(mac_callback_t sent, void *ptr)
+{
+  mac_call_sent_callback(sent, ptr, send_packet(), 1);
+}
+/*---------------------------------------------------------------------------*/
+static void
+qsend_list(mac_callback_t sent, void *ptr, struct rdc_buf_list *buf_list)
+{
+  /* No bursts, send packets one by one */
+  if(buf_list != NULL) {
+    queuebuf_to_packetbuf(buf_list->buf);
+    mac_call_sent_callback(sent, ptr, send_packet(), 1);
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* Returns 1 if the packet in packetbuf is a duplicate */
+static int
+is_duplicate(void)
+{
+  int i;
+  if(packetbuf_attr(PACKETBUF_ATTR_ORPL_DIRECTION) != direction_none) {
+    /* App-layer, with the same loop detection as ContikiMAC-ORPL */
+    return orpl_anycast_is_duplicate();
+  } else {
+    for(i = 0; i < MAX_SEQNOS_LL; i++) {
+      if(packetbuf_attr(PACKETBUF_ATTR_PACKET_ID) == received_seqnos[i].seqno &&
+         rimeaddr_cmp(packetbuf_addr(PACKETBUF_ADDR_SENDER), &received_seqnos[i].sender)) {
+        return 1;
+      }
+    }
+    memmove(&received_seqnos[1], &received_seqnos[0],
+        (MAX_SEQNOS_LL - 1) * sizeof(received_seqnos[0]));
+    received_seqnos[0].seqno = packetbuf_attr(PACKETBUF_ATTR_PACKET_ID);
+    rimeaddr_copy(&received_seqnos[0].sender, packetbuf_addr(PACKETBUF_ADDR_SENDER));
+  }
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+static void
+input_packet(void)
+{
+  struct anycast_parsing_info ret;
+  uint8_t *frame = packetbuf_dataptr();
+
+  /* Beacons are read by senders, and ACKs while waiting for them */
+  if(packetbuf_datalen() < 3 || (frame[0] & 7) != FRAME802154_DATAFRAME) {
+    return;
+  }
+
+  ret = orpl_anycast_802154_frame_parse(frame, packetbuf_datalen());
+  packetbuf_set_attr(PACKETBUF_ATTR_ORPL_DIRECTION, ret.direction);
+  if(ret.direction != direction_none) {
+    packetbuf_set_attr(PACKETBUF_ATTR_EDC, ret.neighbor_edc);
+    orpl_packetbuf_set_seqno(ret.seqno);
+#if WITH_ORPL_PATH_HINT
+    packetbuf_set_attr(PACKETBUF_ATTR_ORPL_HINT, ret.hint);
+#endif /* WITH_ORPL_PATH_HINT */
+#if WITH_ORPL_TRAFFIC_CLASS
+    packetbuf_set_attr(PACKETBUF_ATTR_ORPL_CLASS, ret.traffic_class);
+#endif /* WITH_ORPL_TRAFFIC_CLASS */
+  } else {
+    packetbuf_set_attr(PACKETBUF_ATTR_EDC, 0xffff);
+  }
+
+  if(NETSTACK_FRAMER.parse() < 0) {
+    PRINTF("orpl-rimac: failed to parse (%u)\n", packetbuf_totlen());
+    return;
+  }
+
+#if CONTIKIMAC_CONF_WITH_CONTIKIMAC_HEADER
+  {
+    struct hdr *chdr = packetbuf_dataptr();
+    if(chdr->id != CONTIKIMAC_ID) {
+      return;
+    }
+    packetbuf_hdrreduce(sizeof(struct hdr));
+    packetbuf_set_datalen(chdr->len);
+  }
+#endif /* CONTIKIMAC_CONF_WITH_CONTIKIMAC_HEADER */
+
+  if(ret.direction != direction_none) {
+    rpl_set_parent_rank((uip_lladdr_t *)packetbuf_addr(PACKETBUF_ADDR_SENDER), ret.neighbor_edc);
+  }
+
+  if(packetbuf_datalen() == 0
+      || !(rimeaddr_cmp(packetbuf_addr(PACKETBUF_ADDR_RECEIVER), &rimeaddr_node_addr)
+          || rimeaddr_cmp(packetbuf_addr(PACKETBUF_ADDR_RECEIVER), &rimeaddr_null))
+      || (ret.direction != direction_none && !packetbuf_attr(PACKETBUF_ATTR_ACKED))) {
+    /* Not for us, or an anycast we didn't ack */
+    ORPL_RADIO_STATS(orpl_radio_stats_reclassify_last(ORPL_RADIO_RX, ORPL_RADIO_OVERHEAR));
+    return;
+  }
+
+  if(is_duplicate()) {
+    if(ret.direction != direction_none) {
+      orpl_anycast_duplicate_received();
+      ORPL_LOG_FROM_PACKETBUF("Cmac:! dropping app-layer duplicate from %d",
+          ORPL_LOG_NODEID_FROM_RIMEADDR(packetbuf_addr(PACKETBUF_ADDR_SENDER)));
+    }
+    return;
+  }
+
+  if(ret.direction != direction_none) {
+    ORPL_LOG_INC_HOPCOUNT_FROM_PACKETBUF();
+    ORPL_LOG_FROM_PACKETBUF("Cmac: input from %d",
+        ORPL_LOG_NODEID_FROM_RIMEADDR(packetbuf_addr(PACKETBUF_ADDR_SENDER)));
+#if WITH_ORPL_FAST_FORWARD
+    if(orpl_fast_forward()) {
+      return;
+    }
+#endif /* WITH_ORPL_FAST_FORWARD */
+  }
+
+  NETSTACK_MAC.input();
+}
+/*---------------------------------------------------------------------------*/
+static void
+init(void)
+{
+  radio_is_on = 0;
+  PT_INIT(&pt);
+  rimac_is_on = 1;
+  beacon_seqno = random_rand();
+  rtimer_set(&rt, RTIMER_NOW() + (random_rand() % CYCLE_TIME), 1,
+             (void (*)(struct rtimer *, void *))powercycle, NULL);
+  ORPL_RADIO_STATS(orpl_radio_stats_init());
+}
+/*---------------------------------------------------------------------------*/
+static int
+turn_on(void)
+{
+  if(rimac_is_on == 0) {
+    rimac_is_on = 1;
+    contikimac_keep_radio_on = 0;
+    rtimer_set(&rt, RTIMER_NOW() + CYCLE_TIME, 1,
+               (void (*)(struct rtimer *, void *))powercycle, NULL);
+  }
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+static int
+turn_off(int keep_radio_on)
+{
+  rimac_is_on = 0;
+  contikimac_keep_radio_on = keep_radio_on;
+  ORPL_RADIO_STATS(orpl_radio_stats_off());
+  if(keep_radio_on) {
+    radio_is_on = 1;
+    return NETSTACK_RADIO.on();
+  } else {
+    radio_is_on = 0;
+    return NETSTACK_RADIO.off();
+  }
+}
+/*---------------------------------------------------------------------------*/
+static unsigned short
+duty_cycle(void)
+{
+  return (1ul * CLOCK_SECOND * CYCLE_TIME) / RTIMER_ARCH_SECOND;
+}
+/*---------------------------------------------------------------------------*/
+const struct rdc_driver orpl_rimac_driver = {
+  "ORPL-RIMAC",
+  init,
+  qsend_packet,
+  qsend_list,
+  input_packet,
+  turn_on,
+  turn_off,
+  duty_cycle,
+};
+/*---------------------------------------------------------------------------*/
+
+#endif /* WITH_ORPL && WITH_ORPL_RIMAC */
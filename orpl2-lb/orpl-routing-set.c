@@ -124,13 +124,21 @@ orpl_routing_set_get_active() {
 /* Inserts a global IPv6 in the global double routing set */
 void
 orpl_routing_set_insert(const uip_ipaddr_t *ipv6)
+{
+  /* Set the bits in both routing sets */
+  orpl_routing_set_add(&routing_sets[0], ipv6);
+  orpl_routing_set_add(&routing_sets[1], ipv6);
+}
+
+/* Inserts a global IPv6 in a given routing set */
+void
+orpl_routing_set_add(struct routing_set_s *rs, const uip_ipaddr_t *ipv6)
 {
   int k;
   uint64_t hash = get_hash(ipv6);
-  /* For each hash, set a bit in both routing sets */
+  /* For each hash, set a bit */
   for(k=0; k<ROUTING_SET_K; k++) {
-    rs_set_bit(&routing_sets[0], hash % ROUTING_SET_M);
-    rs_set_bit(&routing_sets[1], hash % ROUTING_SET_M);
+    rs_set_bit(rs, hash % ROUTING_SET_M);
     hash /= ROUTING_SET_M;
   }
 }
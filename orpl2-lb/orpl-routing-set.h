@@ -91,6 +91,8 @@ void orpl_routing_set_init();
 struct routing_set_s *orpl_routing_set_get_active();
 /* Inserts a global IPv6 in the global double routing set */
 void orpl_routing_set_insert(const uip_ipaddr_t *ipv6);
+/* Inserts a global IPv6 in a given routing set */
+void orpl_routing_set_add(struct routing_set_s *rs, const uip_ipaddr_t *ipv6);
 /* Merges a routing set into our global double routing set */
 void orpl_routing_set_merge(const struct routing_set_s *rs);
 /* Checks if our global double bloom filter contains an given IPv6 */
@@ -0,0 +1,199 @@
+/*
+ * Copyright (c) 2014, Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+
+
+/**
+ * \file
+ *         Latency profiling of the softack path. The FIFOP interrupt
+ *         timestamps each stage in a timetable, and cc2420_process folds
+ *         the timetable of the last frame into per-stage min/avg/max and
+ *         a histogram. Statistics are logged on request, by sending
+ *         "softack" on the serial line ("softack reset" clears them).
+ */
+
+#include "contiki.h"
+#include "dev/serial-line.h"
+#include "orpl.h"
+#include "orpl-softack-prof.h"
+#include "cc2420-softack.h"
+#include <string.h>
+
+#if WITH_ORPL && WITH_ORPL_SOFTACK_PROF
+
+TIMETABLE_NONSTATIC(orpl_softack_tt);
+
+const char *orpl_softack_prof_ids[ORPL_SOFTACK_PROF_STAMP_COUNT] = {
+  "sfd", "interrupt", "header", "must-ack-start", "must-ack-end", "decision", "ack-ready"
+};
+static const char *stage_names[ORPL_SOFTACK_PROF_STAGE_COUNT] = {
+  "irq", "read", "must-ack", "callback", "total"
+};
+/* First and last stamp of each stage */
+static const uint8_t stage_stamps[ORPL_SOFTACK_PROF_STAGE_COUNT][2] = {
+  { ORPL_SOFTACK_PROF_SFD, ORPL_SOFTACK_PROF_INTERRUPT },
+  { ORPL_SOFTACK_PROF_INTERRUPT, ORPL_SOFTACK_PROF_HEADER },
+  { ORPL_SOFTACK_PROF_MUST_ACK_START, ORPL_SOFTACK_PROF_MUST_ACK_END },
+  { ORPL_SOFTACK_PROF_HEADER, ORPL_SOFTACK_PROF_DECISION },
+  { ORPL_SOFTACK_PROF_SFD, ORPL_SOFTACK_PROF_ACK_READY },
+};
+
+volatile uint16_t orpl_softack_prof_late;
+volatile uint16_t orpl_softack_prof_acks;
+
+static struct orpl_softack_prof_stats stats[ORPL_SOFTACK_PROF_STAGE_COUNT];
+
+PROCESS(orpl_softack_prof_process, "ORPL softack profiler");
+
+/* Returns the histogram bin of a duration */
+static uint8_t
+hist_bin(uint16_t ticks)
+{
+  uint8_t bin = 0;
+  while(ticks > 0 && bin < ORPL_SOFTACK_PROF_BINS - 1) {
+    ticks >>= 1;
+    bin++;
+  }
+  return bin;
+}
+
+/* Fold the timestamps of the last frame into the statistics */
+void
+orpl_softack_prof_update()
+{
+  struct timetable_timestamp stamps[orpl_softack_tt_size];
+  rtimer_clock_t times[ORPL_SOFTACK_PROF_STAMP_COUNT];
+  uint8_t found[ORPL_SOFTACK_PROF_STAMP_COUNT];
+  int count, i, j;
+  int s;
+
+  /* Copy the timetable, the interrupt may start over at any time */
+  s = splhigh();
+  count = timetable_ptr(&orpl_softack_tt);
+  memcpy(stamps, orpl_softack_tt_timestamps, count * sizeof(stamps[0]));
+  timetable_clear(&orpl_softack_tt);
+  splx(s);
+
+  memset(found, 0, sizeof(found));
+  for(i = 0; i < count; i++) {
+    for(j = 0; j < ORPL_SOFTACK_PROF_STAMP_COUNT; j++) {
+      if(stamps[i].id == orpl_softack_prof_ids[j]) {
+        times[j] = stamps[i].time;
+        found[j] = 1;
+      }
+    }
+  }
+
+  for(i = 0; i < ORPL_SOFTACK_PROF_STAGE_COUNT; i++) {
+    uint8_t from = stage_stamps[i][0];
+    uint8_t to = stage_stamps[i][1];
+    if(found[from] && found[to]) {
+      rtimer_clock_t diff = times[to] - times[from];
+      uint16_t ticks;
+      /* Remove the cost of the timestamp itself */
+      if(diff > timetable_timestamp_time) {
+        diff -= timetable_timestamp_time;
+      }
+      ticks = diff > 0xffff ? 0xffff : diff;
+      if(stats[i].count == 0 || ticks < stats[i].min) {
+        stats[i].min = ticks;
+      }
+      if(ticks > stats[i].max) {
+        stats[i].max = ticks;
+      }
+      stats[i].sum += ticks;
+      stats[i].count++;
+      stats[i].hist[hist_bin(ticks)]++;
+    }
+  }
+}
+
+/* Get the statistics of a stage */
+const struct orpl_softack_prof_stats *
+orpl_softack_prof_get(enum orpl_softack_prof_stage stage)
+{
+  return &stats[stage];
+}
+
+/* Log all statistics, durations in rtimer ticks */
+void
+orpl_softack_prof_print()
+{
+  int i;
+  for(i = 0; i < ORPL_SOFTACK_PROF_STAGE_COUNT; i++) {
+    struct orpl_softack_prof_stats *st = &stats[i];
+    ORPL_LOG("ORPL: softack %s n %u min %u avg %u max %u hist %u %u %u %u %u %u %u %u\n",
+        stage_names[i], st->count, st->min,
+        st->count ? (uint16_t)(st->sum / st->count) : 0, st->max,
+        st->hist[0], st->hist[1], st->hist[2], st->hist[3],
+        st->hist[4], st->hist[5], st->hist[6], st->hist[7]);
+  }
+  ORPL_LOG("ORPL: softack acks %u late %u cancelled %u\n",
+      orpl_softack_prof_acks, orpl_softack_prof_late,
+      cc2420_softack_cancelled_count);
+}
+
+/* Clear all statistics */
+void
+orpl_softack_prof_reset()
+{
+  memset(stats, 0, sizeof(stats));
+  orpl_softack_prof_acks = 0;
+  orpl_softack_prof_late = 0;
+}
+
+PROCESS_THREAD(orpl_softack_prof_process, ev, data)
+{
+  PROCESS_BEGIN();
+
+  while(1) {
+    PROCESS_WAIT_EVENT_UNTIL(ev == serial_line_event_message && data != NULL);
+    if(!strcmp(data, "softack")) {
+      orpl_softack_prof_print();
+    } else if(!strcmp(data, "softack reset")) {
+      orpl_softack_prof_reset();
+    }
+  }
+
+  PROCESS_END();
+}
+
+/* Start listening for requests on the serial line */
+void
+orpl_softack_prof_init()
+{
+  timetable_init();
+  orpl_softack_prof_reset();
+  process_start(&orpl_softack_prof_process, NULL);
+}
+
+#endif /* WITH_ORPL && WITH_ORPL_SOFTACK_PROF */
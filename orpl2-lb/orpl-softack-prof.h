@@ -0,0 +1,123 @@
+/*
+ * Copyright (c) 2014, Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+
+
+/**
+ * \file
+ *         Latency profiling of the softack path, from the SFD of a frame
+ *         to its ACK being ready in the TX FIFO
+ */
+
+#ifndef __ORPL_SOFTACK_PROF_H__
+#define __ORPL_SOFTACK_PROF_H__
+
+#include "contiki.h"
+#include "sys/timetable.h"
+
+#if WITH_ORPL_SOFTACK_PROF
+
+/* Timestamps of the last frame, taken from interrupt */
+enum orpl_softack_prof_stamp {
+  ORPL_SOFTACK_PROF_SFD,           /* Start of frame, from the SFD capture */
+  ORPL_SOFTACK_PROF_INTERRUPT,     /* FIFOP interrupt entered */
+  ORPL_SOFTACK_PROF_HEADER,        /* Frame header read from the RX FIFO */
+  ORPL_SOFTACK_PROF_MUST_ACK_START,
+  ORPL_SOFTACK_PROF_MUST_ACK_END,  /* Anycast ack decision done */
+  ORPL_SOFTACK_PROF_DECISION,      /* Input callback returned */
+  ORPL_SOFTACK_PROF_ACK_READY,     /* ACK written to the TX FIFO */
+  ORPL_SOFTACK_PROF_STAMP_COUNT
+};
+
+/* Stages we keep statistics for, as the time between two stamps */
+enum orpl_softack_prof_stage {
+  ORPL_SOFTACK_PROF_STAGE_IRQ,      /* SFD -> interrupt */
+  ORPL_SOFTACK_PROF_STAGE_READ,     /* interrupt -> header */
+  ORPL_SOFTACK_PROF_STAGE_MUST_ACK, /* orpl_anycast_802154_frame_must_ack */
+  ORPL_SOFTACK_PROF_STAGE_CALLBACK, /* header -> callback returned */
+  ORPL_SOFTACK_PROF_STAGE_TOTAL,    /* SFD -> ACK ready */
+  ORPL_SOFTACK_PROF_STAGE_COUNT
+};
+
+/* Histogram bins, on a log2 scale of rtimer ticks: 0, 1, 2-3, 4-7, ..., >=64 */
+#define ORPL_SOFTACK_PROF_BINS 8
+
+struct orpl_softack_prof_stats {
+  uint16_t count;
+  uint16_t min;
+  uint16_t max;
+  uint32_t sum;
+  uint16_t hist[ORPL_SOFTACK_PROF_BINS];
+};
+
+/* The timetable filled from interrupt, for the last frame. An acked
+ * frame takes every stamp: one more entry keeps the pointer from
+ * wrapping back to 0, which would hide them all. */
+#define orpl_softack_tt_size (ORPL_SOFTACK_PROF_STAMP_COUNT + 1)
+TIMETABLE_DECLARE(orpl_softack_tt);
+extern const char *orpl_softack_prof_ids[ORPL_SOFTACK_PROF_STAMP_COUNT];
+/* ACKs that were ready only after the end of the frame */
+extern volatile uint16_t orpl_softack_prof_late;
+/* ACKs prepared in total */
+extern volatile uint16_t orpl_softack_prof_acks;
+
+/* Start profiling a new frame, from the FIFOP interrupt */
+#define ORPL_SOFTACK_PROF_START(sfd_time) do { \
+    rtimer_clock_t now = RTIMER_NOW(); \
+    timetable_clear(&orpl_softack_tt); \
+    TIMETABLE_TIMESTAMP(orpl_softack_tt, orpl_softack_prof_ids[ORPL_SOFTACK_PROF_SFD]); \
+    TIMETABLE_ENTRY(orpl_softack_tt, 0).time = now - (uint16_t)((uint16_t)now - (sfd_time)); \
+    TIMETABLE_TIMESTAMP(orpl_softack_tt, orpl_softack_prof_ids[ORPL_SOFTACK_PROF_INTERRUPT]); \
+  } while(0)
+#define ORPL_SOFTACK_PROF_STAMP(stamp) \
+    TIMETABLE_TIMESTAMP(orpl_softack_tt, orpl_softack_prof_ids[stamp])
+
+/* Fold the timestamps of the last frame into the statistics.
+ * Called from cc2420_process, out of interrupt. */
+void orpl_softack_prof_update();
+/* Get the statistics of a stage */
+const struct orpl_softack_prof_stats *orpl_softack_prof_get(enum orpl_softack_prof_stage stage);
+/* Log all statistics */
+void orpl_softack_prof_print();
+/* Clear all statistics */
+void orpl_softack_prof_reset();
+/* Start listening for "softack" and "softack reset" on the serial line */
+void orpl_softack_prof_init();
+
+#else /* WITH_ORPL_SOFTACK_PROF */
+
+#define ORPL_SOFTACK_PROF_START(sfd_time)
+#define ORPL_SOFTACK_PROF_STAMP(stamp)
+
+#endif /* WITH_ORPL_SOFTACK_PROF */
+
+#endif /* __ORPL_SOFTACK_PROF_H__ */
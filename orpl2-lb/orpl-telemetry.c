@@ -0,0 +1,260 @@
+/*
+ * Copyright (c) 2014, Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+
+
+/**
+ * \file
+ *         Compact binary reports of the ORPL state of each node: EDC,
+ *         forwarder and neighbor set sizes, routing set fill, queue length,
+ *         duty cycle, wake-up interval and false positive recoveries.
+ *         Nodes send them to the sink, which prints them as collect-view
+ *         lines: the collect-view fields that ORPL has (energest, EDC as
+ *         routing metric, neighbors, DIO interval as beacon interval) go
+ *         in place, and ORPL fields in place of the sensors, after
+ *         ORPL_TELEMETRY_MAGIC.
+ */
+
+#include "contiki.h"
+#include "net/uip.h"
+#include "net/uip-ds6.h"
+#include "net/netstack.h"
+#include "net/simple-udp.h"
+#include "net/rpl/rpl-private.h"
+#include "sys/energest.h"
+#include "orpl.h"
+#include "orpl-routing-set.h"
+#include "orpl-telemetry.h"
+#include "lib/random.h"
+#include <stdio.h>
+#include <string.h>
+
+#if WITH_ORPL && WITH_ORPL_TELEMETRY
+
+#define UIP_IP_BUF ((struct uip_ip_hdr *)&uip_buf[UIP_LLH_LEN])
+
+/* Number of 16-bit words after the collect-view header */
+#define COLLECT_VIEW_WORDS 22
+
+#if QUEUEBUF_CONF_STATS
+/* Number of queuebufs in use, from queuebuf.c */
+extern uint8_t queuebuf_len;
+#endif /* QUEUEBUF_CONF_STATS */
+extern int forwarder_set_size;
+
+static struct simple_udp_connection telemetry_connection;
+
+PROCESS(orpl_telemetry_process, "ORPL Telemetry");
+
+/* Fill in a report with our current state */
+static void
+build_report(struct orpl_telemetry_msg *msg)
+{
+  static uint8_t seqno;
+  static unsigned long last_cpu, last_lpm, last_transmit, last_listen;
+  unsigned long cpu, lpm, transmit, listen;
+  unsigned long on, total;
+  rpl_parent_t *p;
+  uint8_t num_neighbors = 0;
+
+  energest_flush();
+  cpu = energest_type_time(ENERGEST_TYPE_CPU) - last_cpu;
+  lpm = energest_type_time(ENERGEST_TYPE_LPM) - last_lpm;
+  transmit = energest_type_time(ENERGEST_TYPE_TRANSMIT) - last_transmit;
+  listen = energest_type_time(ENERGEST_TYPE_LISTEN) - last_listen;
+  last_cpu += cpu;
+  last_lpm += lpm;
+  last_transmit += transmit;
+  last_listen += listen;
+
+  /* Radio duty cycle in 0.01%, scaled so that on * 10000 fits in 32 bits */
+  on = transmit + listen;
+  total = cpu + lpm;
+  while(on >= 429496ul) {
+    on /= 2;
+    total /= 2;
+  }
+  msg->duty_cycle = total > 0 ? (uint16_t)((on * 10000) / total) : 0;
+
+  /* Scale the times down to 16 bits, as collect-view does */
+  while(cpu >= 65536ul || lpm >= 65536ul ||
+      transmit >= 65536ul || listen >= 65536ul) {
+    cpu /= 2;
+    lpm /= 2;
+    transmit /= 2;
+    listen /= 2;
+  }
+
+  for(p = nbr_table_head(rpl_parents); p != NULL; p = nbr_table_next(rpl_parents, p)) {
+    num_neighbors++;
+  }
+
+  msg->version = ORPL_TELEMETRY_VERSION;
+  msg->seqno = seqno++;
+  msg->clock = (uint16_t)clock_seconds();
+  msg->cpu = cpu;
+  msg->lpm = lpm;
+  msg->transmit = transmit;
+  msg->listen = listen;
+  msg->edc = orpl_current_edc();
+  msg->routing_set_bits = orpl_routing_set_count_bits();
+  msg->wakeup_interval = (uint16_t)((1000ul * NETSTACK_RDC.channel_check_interval()) / CLOCK_SECOND);
+  msg->fp_recoveries = orpl_fp_recoveries;
+  msg->sink = orpl_current_sink();
+  msg->forwarder_set_size = forwarder_set_size;
+  msg->num_neighbors = num_neighbors;
+#if QUEUEBUF_CONF_STATS
+  msg->queue_len = queuebuf_len;
+#else /* QUEUEBUF_CONF_STATS */
+  msg->queue_len = 0xff;
+#endif /* QUEUEBUF_CONF_STATS */
+  msg->dio_interval = default_instance != NULL ? default_instance->dio_intcurrent : 0;
+}
+
+/* Print a report as a collect-view line */
+static void
+print_report(uint16_t node, uint8_t hops, const struct orpl_telemetry_msg *msg)
+{
+  uint16_t words[COLLECT_VIEW_WORDS];
+  unsigned long time = clock_seconds();
+  int i;
+
+  words[0] = COLLECT_VIEW_WORDS;
+  words[1] = msg->clock;
+  words[2] = 0; /* Time synch */
+  words[3] = msg->cpu;
+  words[4] = msg->lpm;
+  words[5] = msg->transmit;
+  words[6] = msg->listen;
+  words[7] = 0; /* No parent in ORPL */
+  words[8] = 0;
+  words[9] = msg->edc;
+  words[10] = msg->num_neighbors;
+  words[11] = (uint16_t)((1ul << msg->dio_interval) / 1000);
+  words[12] = ORPL_TELEMETRY_MAGIC;
+  words[13] = msg->forwarder_set_size;
+  words[14] = msg->routing_set_bits;
+  words[15] = msg->queue_len;
+  words[16] = msg->duty_cycle;
+  words[17] = msg->wakeup_interval;
+  words[18] = msg->fp_recoveries;
+  words[19] = msg->sink;
+  words[20] = msg->version;
+  words[21] = ROUTING_SET_M;
+
+  /* Header: length, sink timestamp, node, seqno, hops, latency */
+  printf("%u %lu %lu 0 %u %u %u 0", 8 + COLLECT_VIEW_WORDS,
+      (time >> 16) & 0xffff, time & 0xffff, node, msg->seqno, hops);
+  for(i = 0; i < COLLECT_VIEW_WORDS; i++) {
+    printf(" %u", words[i]);
+  }
+  printf("\n");
+}
+
+/* A node sent us a report */
+static void
+udp_received_report(struct simple_udp_connection *c,
+         const uip_ipaddr_t *sender_addr,
+         uint16_t sender_port,
+         const uip_ipaddr_t *receiver_addr,
+         uint16_t receiver_port,
+         const uint8_t *data,
+         uint16_t datalen)
+{
+  struct orpl_telemetry_msg msg;
+
+  if(datalen != sizeof(msg)) {
+    return;
+  }
+  memcpy(&msg, data, sizeof(msg));
+  if(msg.version != ORPL_TELEMETRY_VERSION) {
+    return;
+  }
+  print_report(ORPL_LOG_NODEID_FROM_IPADDR(sender_addr),
+      uip_ds6_if.cur_hop_limit - UIP_IP_BUF->ttl + 1, &msg);
+}
+
+/* Send or print a report */
+static void
+report()
+{
+  struct orpl_telemetry_msg msg;
+  uip_ipaddr_t dest_ipaddr;
+
+  if(default_instance == NULL) {
+    return;
+  }
+  build_report(&msg);
+  if(ORPL_TELEMETRY_SERIAL || orpl_is_root()) {
+    print_report(ORPL_LOG_NODEID_FROM_RIMEADDR(&rimeaddr_node_addr), 0, &msg);
+  } else {
+#if WITH_ORPL_MULTI_SINK
+    orpl_sink_ipaddr(&dest_ipaddr);
+#else /* WITH_ORPL_MULTI_SINK */
+    uip_ipaddr_copy(&dest_ipaddr, &default_instance->current_dag->dag_id);
+#endif /* WITH_ORPL_MULTI_SINK */
+    simple_udp_sendto(&telemetry_connection, &msg, sizeof(msg), &dest_ipaddr);
+  }
+}
+
+PROCESS_THREAD(orpl_telemetry_process, ev, data)
+{
+  static struct etimer periodic;
+  static struct etimer jitter;
+  PROCESS_BEGIN();
+
+  etimer_set(&periodic, ORPL_TELEMETRY_PERIOD * CLOCK_SECOND);
+  while(1) {
+    PROCESS_WAIT_UNTIL(etimer_expired(&periodic));
+    etimer_reset(&periodic);
+    /* Spread reports over the period, to avoid bursts at the sink */
+    etimer_set(&jitter, random_rand() % (ORPL_TELEMETRY_PERIOD * CLOCK_SECOND / 2));
+    PROCESS_WAIT_UNTIL(etimer_expired(&jitter));
+    report();
+  }
+
+  PROCESS_END();
+}
+
+/* Start sending (or printing) periodic reports */
+void
+orpl_telemetry_init()
+{
+  if(!ORPL_TELEMETRY_SERIAL) {
+    simple_udp_register(&telemetry_connection, ORPL_TELEMETRY_PORT,
+                          NULL, ORPL_TELEMETRY_PORT,
+                          udp_received_report);
+  }
+  process_start(&orpl_telemetry_process, NULL);
+}
+
+#endif /* WITH_ORPL && WITH_ORPL_TELEMETRY */
@@ -0,0 +1,96 @@
+/*
+ * Copyright (c) 2014, Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the Contiki operating system.
+ *
+ */
+
+
+
+/**
+ * \file
+ *         Header file for orpl-telemetry.c, compact binary reports of the
+ *         ORPL state of each node, printed in the collect-view format
+ */
+
+#ifndef __ORPL_TELEMETRY_H__
+#define __ORPL_TELEMETRY_H__
+
+#include "contiki.h"
+
+/* UDP port of telemetry reports */
+#define ORPL_TELEMETRY_PORT 4446
+
+/* Version of struct orpl_telemetry_msg */
+#define ORPL_TELEMETRY_VERSION 1
+
+/* Marks ORPL reports among collect-view lines, in place of the first sensor */
+#define ORPL_TELEMETRY_MAGIC 0x0e4c
+
+/* Period of the reports, in seconds */
+#ifdef ORPL_CONF_TELEMETRY_PERIOD
+#define ORPL_TELEMETRY_PERIOD ORPL_CONF_TELEMETRY_PERIOD
+#else /* ORPL_CONF_TELEMETRY_PERIOD */
+#define ORPL_TELEMETRY_PERIOD 60
+#endif /* ORPL_CONF_TELEMETRY_PERIOD */
+
+/* When set, every node prints its own reports on serial (testbeds with
+ * one serial line per node). Otherwise, reports are sent to the sink
+ * and printed there. */
+#ifdef ORPL_CONF_TELEMETRY_SERIAL
+#define ORPL_TELEMETRY_SERIAL ORPL_CONF_TELEMETRY_SERIAL
+#else /* ORPL_CONF_TELEMETRY_SERIAL */
+#define ORPL_TELEMETRY_SERIAL 0
+#endif /* ORPL_CONF_TELEMETRY_SERIAL */
+
+/* A telemetry report, as sent to the sink. Energest times are deltas
+ * since the last report, scaled down together to fit in 16 bits. */
+struct orpl_telemetry_msg {
+  uint8_t version;
+  uint8_t seqno;
+  uint16_t clock; /* Seconds since boot */
+  uint16_t cpu;
+  uint16_t lpm;
+  uint16_t transmit;
+  uint16_t listen;
+  uint16_t edc;
+  uint16_t routing_set_bits;
+  uint16_t wakeup_interval; /* ms */
+  uint16_t duty_cycle; /* Radio duty cycle since the last report, in 0.01% */
+  uint16_t fp_recoveries;
+  uint16_t sink;
+  uint8_t forwarder_set_size;
+  uint8_t num_neighbors;
+  uint8_t queue_len;
+  uint8_t dio_interval; /* Current DIO interval, log2 ms */
+};
+
+/* Start sending (or printing) periodic reports */
+void orpl_telemetry_init();
+
+#endif /* __ORPL_TELEMETRY_H__ */
@@ -40,7 +40,28 @@
 #include "orpl.h"
 #include "orpl-anycast.h"
 #include "orpl-routing-set.h"
+#if WITH_ORPL_ENERGY
+#include "orpl-energy.h"
+#endif /* WITH_ORPL_ENERGY */
+#if WITH_ORPL_SOFTACK_PROF
+#include "orpl-softack-prof.h"
+#endif /* WITH_ORPL_SOFTACK_PROF */
+#if WITH_ORPL_DTN
+#include "orpl-dtn.h"
+#endif /* WITH_ORPL_DTN */
+#if WITH_ORPL_PATH_HINT
+#include "orpl-path-hint.h"
+#endif /* WITH_ORPL_PATH_HINT */
+#if WITH_ORPL_TELEMETRY
+#include "orpl-telemetry.h"
+#endif /* WITH_ORPL_TELEMETRY */
+#if WITH_ORPL_MCAST
+#include "orpl-mcast.h"
+#endif /* WITH_ORPL_MCAST */
 #include "net/packetbuf.h"
+#if WITH_ORPL_FRAG
+#include "net/sicslowpan.h"
+#endif /* WITH_ORPL_FRAG */
 #include "net/simple-udp.h"
 #include "net/uip-ds6.h"
 #include "net/rpl/rpl-private.h"
@@ -50,12 +71,6 @@
 
 #if WITH_ORPL
 
-#if WITH_ORPL_LB && WITH_ORPL_LB_DIO_TARGET
-uint8_t dio_dc_objective=100;// 8bit so NOT > 2.56 % (256)
-uint8_t dio_dc_obj_sn=0;
-//uint16_t dc_obj_metric=500;//average WUint?
-#endif
-
 #define DEBUG DEBUG_NONE
 #include "net/uip-debug.h"
 
@@ -67,21 +82,11 @@ uip_ipaddr_t global_ipv6;
  * after each transmission attempt */
 int sending_routing_set = 0;
 
-/* Total number of broadcast sent */
-uint32_t orpl_broadcast_count = 0;
-
 /* Defines whether all neighbors we have a good link to should be included
  * in our routing set, regardless of them being children or not. */
 #define ORPL_ALL_NEIGHBORS_IN_ROUTING_SET 1
 
-/* When set:
- * - stop updating EDC after N seconds
- * - start updating Routing sets only after N+1 seconds
- * - don't age routing sets */
-#ifndef FREEZE_TOPOLOGY
-#define FREEZE_TOPOLOGY 1
-#endif
-
+/* See FREEZE_TOPOLOGY in orpl.h */
 #if FREEZE_TOPOLOGY
 #define UPDATE_EDC_MAX_TIME 4*60
 #define UPDATE_ROUTING_SET_MIN_TIME 5*60
@@ -90,14 +95,20 @@ uint32_t orpl_broadcast_count = 0;
 #define UPDATE_ROUTING_SET_MIN_TIME 0
 #endif
 
-/* PRR threshold for considering a neighbor as usable */
-#define NEIGHBOR_PRR_THRESHOLD 30
-
 /* Rank changes of more than RANK_MAX_CHANGE trigger a trickle timer reset */
 #define RANK_MAX_CHANGE (2*EDC_DIVISOR)
 /* The last boradcasted EDC */
 static uint16_t last_broadcasted_edc = 0xffff;
 
+#if !FREEZE_TOPOLOGY
+/* Uptime of the last routing set swap */
+static clock_time_t last_swap_time;
+/* Number of loops detected since the last routing set swap */
+static uint8_t loop_count;
+/* Set when a loop was detected, to bypass EDC hysteresis once */
+static int edc_force_update;
+#endif /* !FREEZE_TOPOLOGY */
+
 /* Set to 1 when only upwards routing is enabled */
 static int orpl_up_only = 0;
 /* A flag that tells whether we are root or not */
@@ -113,6 +124,12 @@ static uip_ipaddr_t routing_set_addr;
  * current edc. */
 struct routing_set_broadcast_s {
   uint16_t edc;
+#if WITH_ORPL_MULTI_SINK
+  uint16_t sink;
+#endif /* WITH_ORPL_MULTI_SINK */
+#if WITH_ORPL_ENERGY
+  uint8_t energy;
+#endif /* WITH_ORPL_ENERGY */
   union {
     struct routing_set_s rs;
     uint8_t padding[64];
@@ -141,11 +158,19 @@ static rpl_instance_t *curr_instance;
 /* Routing set false positive blacklist */
 #define BLACKLIST_SIZE 16
 static uint32_t blacklisted_seqnos[BLACKLIST_SIZE];
+/* Number of false positive recoveries we triggered */
+uint16_t orpl_fp_recoveries;
 
 static void broadcast_routing_set(void *ptr);
+#if WITH_ORPL_BOOTSTRAP
+static void bootstrap_start();
+#endif /* WITH_ORPL_BOOTSTRAP */
 
 /* Seqno of the next packet to be sent */
 static uint32_t current_seqno = 0;
+#if WITH_ORPL_TRAFFIC_CLASS
+static uint8_t current_class = ORPL_CLASS_NORMAL;
+#endif /* WITH_ORPL_TRAFFIC_CLASS */
 
 static init_done = 0;
 static clock_time_t init_time;
@@ -159,6 +184,20 @@ init_global_ipv6()
       memcpy(&global_ipv6, &ipaddr, 16);
       init_done = 1;
       init_time = clock_seconds();
+#if WITH_ORPL_BOOTSTRAP
+      /* We just joined (or booted as root) */
+      bootstrap_start();
+#endif /* WITH_ORPL_BOOTSTRAP */
+#if WITH_ORPL_MULTI_SINK
+      if(is_root_flag) {
+        /* Roots also own the virtual sink address */
+        uip_ipaddr_t sink_ipaddr;
+        orpl_sink_ipaddr(&sink_ipaddr);
+        if(uip_ds6_addr_lookup(&sink_ipaddr) == NULL) {
+          uip_ds6_addr_add(&sink_ipaddr, 0, ADDR_MANUAL);
+        }
+      }
+#endif /* WITH_ORPL_MULTI_SINK */
     }
   }
 }
@@ -191,6 +230,22 @@ orpl_packetbuf_seqno()
     packetbuf_attr(PACKETBUF_ATTR_ORPL_SEQNO1);
 }
 
+#if WITH_ORPL_FRAG
+/* Get the offset of the anycast fragment in packetbuf, in 8-byte units.
+ * 0 for first fragments and packets that are not fragmented. */
+uint8_t
+orpl_packetbuf_frag_offset()
+{
+  uint8_t *data = packetbuf_dataptr();
+  if(packetbuf_datalen() >= ORPL_DESC_LEN + SICSLOWPAN_FRAGN_HDR_LEN
+      && ORPL_DESC_IS_DISPATCH(data[0])
+      && (data[ORPL_DESC_LEN] & 0xf8) == SICSLOWPAN_DISPATCH_FRAGN) {
+    return data[ORPL_DESC_LEN + 4];
+  }
+  return 0;
+}
+#endif /* WITH_ORPL_FRAG */
+
 /* Get the current ORPL sequence number */
 uint32_t
 orpl_get_curr_seqno()
@@ -217,6 +272,24 @@ void orpl_set_curr_seqno(uint32_t seqno)
   current_seqno = seqno;
 }
 
+#if WITH_ORPL_TRAFFIC_CLASS
+/* Set the traffic class of the next packet we send, as for the seqno */
+void
+orpl_set_curr_class(uint8_t traffic_class)
+{
+  current_class = traffic_class;
+}
+
+/* Get the current traffic class, and reset it */
+uint8_t
+orpl_get_curr_class()
+{
+  uint8_t ret = current_class;
+  current_class = ORPL_CLASS_NORMAL;
+  return ret;
+}
+#endif /* WITH_ORPL_TRAFFIC_CLASS */
+
 /* Build a global IPv6 address from a link-local IPv6 address */
 static void
 global_ipaddr_from_llipaddr(uip_ipaddr_t *gipaddr, const uip_ipaddr_t *llipaddr)
@@ -237,18 +310,58 @@ orpl_uptime()
 
 }
 
+#if WITH_ORPL_BOOTSTRAP
+/* Set during the bootstrap phase */
+static int bootstrap_active;
+/* Uptime at which the bootstrap phase ended, 0 if not ended yet */
+static clock_time_t bootstrap_end_time;
+/* EDC at the previous bootstrap round, and number of rounds it was stable */
+static rpl_rank_t bootstrap_last_edc;
+static uint8_t bootstrap_stable_rounds;
+/* Timer for bootstrap rounds */
+static struct ctimer bootstrap_timer;
+
+/* EDC variation under which we consider it stable */
+#define BOOTSTRAP_EDC_STABLE (ORPL_EDC_W / 2)
+/* Number of stable rounds before ending the bootstrap phase */
+#define BOOTSTRAP_STABLE_ROUNDS 4
+/* Number of virtual broadcasts the link prior accounts for */
+#define BOOTSTRAP_PRIOR_SAMPLES 4
+/* CC2420 correlation (LQI) of the worst and best links */
+#define BOOTSTRAP_LQI_LOW 55
+#define BOOTSTRAP_LQI_HIGH 105
+/* Below this RSSI (dBm), we don't trust the link at all */
+#define BOOTSTRAP_RSSI_MIN -90
+/* Offset from CC2420 RSSI register values to dBm */
+#define BOOTSTRAP_RSSI_OFFSET -45
+#endif /* WITH_ORPL_BOOTSTRAP */
+
+/* Uptime after which EDC is frozen. With bootstrap, this happens as soon as
+ * the bootstrap phase ended, routing sets being activated accordingly. */
+static clock_time_t
+edc_freeze_time()
+{
+#if WITH_ORPL_BOOTSTRAP
+  if(bootstrap_end_time != 0 && bootstrap_end_time < UPDATE_EDC_MAX_TIME) {
+    return bootstrap_end_time;
+  }
+#endif /* WITH_ORPL_BOOTSTRAP */
+  return UPDATE_EDC_MAX_TIME;
+}
+
 /* Returns 1 if EDC is frozen, i.e. we are not allowed to change edc */
 int
 orpl_is_edc_frozen()
 {
-  return FREEZE_TOPOLOGY && orpl_up_only == 0 && orpl_uptime() > UPDATE_EDC_MAX_TIME;
+  return FREEZE_TOPOLOGY && orpl_up_only == 0 && orpl_uptime() > edc_freeze_time();
 }
 
 /* Returns 1 routing sets are active, i.e. we can start inserting and merging */
 int
 orpl_are_routing_set_active()
 {
-  return orpl_up_only == 0 && !(FREEZE_TOPOLOGY && orpl_uptime() <= UPDATE_ROUTING_SET_MIN_TIME);
+  return orpl_up_only == 0 && !(FREEZE_TOPOLOGY
+      && orpl_uptime() <= edc_freeze_time() + (UPDATE_ROUTING_SET_MIN_TIME - UPDATE_EDC_MAX_TIME));
 }
 
 /* Returns 1 if the node is root of ORPL */
@@ -258,6 +371,64 @@ orpl_is_root()
   return is_root_flag;
 }
 
+#if WITH_ORPL_MULTI_SINK
+/* Set the IID of an IPv6 address to that of the virtual sink */
+void
+orpl_set_sink_iid(uip_ipaddr_t *ipaddr)
+{
+  memset(ipaddr->u8 + 8, 0, 8);
+  ipaddr->u8[14] = ORPL_SINK_IID >> 8;
+  ipaddr->u8[15] = ORPL_SINK_IID & 0xff;
+}
+
+/* Build the global virtual sink address, shared by all roots */
+void
+orpl_sink_ipaddr(uip_ipaddr_t *ipaddr)
+{
+  memcpy(ipaddr, &global_ipv6, 8);
+  orpl_set_sink_iid(ipaddr);
+}
+
+/* Returns 1 if ipaddr is the virtual sink address. Only the IID is
+ * compared, as there is a single prefix in the PAN. */
+int
+orpl_is_sink_ipaddr(const uip_ipaddr_t *ipaddr)
+{
+  return ipaddr->u16[4] == 0 && ipaddr->u16[5] == 0 && ipaddr->u16[6] == 0
+      && ipaddr->u8[14] == (ORPL_SINK_IID >> 8)
+      && ipaddr->u8[15] == (ORPL_SINK_IID & 0xff);
+}
+
+/* Returns the id of the sink we are currently routing to. Roots are
+ * identified by the last two bytes of their MAC address; other nodes
+ * inherit the sink of their best neighbor, i.e. the head of their
+ * forwarder set. As all roots have an EDC of 0, this is the nearest
+ * sink in terms of EDC. */
+uint16_t
+orpl_current_sink()
+{
+  rpl_parent_t *p;
+  rpl_rank_t best_rank = 0xffff;
+  uint16_t sink = ORPL_SINK_NONE;
+
+  if(is_root_flag) {
+    return (rimeaddr_node_addr.u8[RIMEADDR_SIZE-2] << 8)
+        | rimeaddr_node_addr.u8[RIMEADDR_SIZE-1];
+  }
+
+  for(p = nbr_table_head(rpl_parents);
+      p != NULL;
+      p = nbr_table_next(rpl_parents, p)) {
+    if(p->sink != ORPL_SINK_NONE && p->rank < best_rank) {
+      best_rank = p->rank;
+      sink = p->sink;
+    }
+  }
+
+  return sink;
+}
+#endif /* WITH_ORPL_MULTI_SINK */
+
 /* Returns current EDC of the node */
 rpl_rank_t
 orpl_current_edc()
@@ -266,19 +437,37 @@ orpl_current_edc()
   return dag == NULL ? 0xffff : dag->rank;
 }
 
+/* Returns the number of broadcasts acked by a neighbor over the last
+ * ORPL_LINK_WINDOW ones, scaled to the window if we have fewer samples */
+uint16_t
+orpl_link_ackcount(const rpl_parent_t *p)
+{
+  uint16_t history = p->bc_history;
+  uint16_t count = 0;
+  if(p->bc_samples == 0) {
+    /* No broadcast sent yet: assume a reception rate of 50% */
+    return ORPL_LINK_WINDOW / 2;
+  }
+  while(history) {
+    count += history & 1;
+    history >>= 1;
+  }
+  return count * ORPL_LINK_WINDOW / p->bc_samples;
+}
+
 /* Returns 1 if addr is link-layer address of a reachable neighbor */
 static int
 orpl_is_reachable_neighbor_from_lladdr(const uip_lladdr_t *lladdr)
 {
-  /* We don't consider neighbors as reachable before we have send
-   * at least 4 broadcasts to estimate link quality */
-  if(lladdr != NULL && orpl_broadcast_count >= 4) {
+  if(lladdr != NULL) {
     rpl_parent_t *p = rpl_get_parent(lladdr);
-    uint16_t bc_count = p == NULL ? 0 : p->bc_ackcount;
-    return 100*bc_count/orpl_broadcast_count >= NEIGHBOR_PRR_THRESHOLD;
-  } else {
-    return 0;
+    /* We don't consider neighbors as reachable before we have send
+     * at least 4 broadcasts to estimate link quality */
+    if(p != NULL && p->bc_samples >= 4) {
+      return 100*orpl_link_ackcount(p)/ORPL_LINK_WINDOW >= NEIGHBOR_PRR_THRESHOLD;
+    }
   }
+  return 0;
 }
 
 /* Returns 1 if addr is the global ip of a reachable neighbor */
@@ -313,6 +502,7 @@ orpl_blacklist_insert(uint32_t seqno)
 {
   ORPL_LOG("ORPL: blacklisting %lx\n", seqno);
   int i;
+  orpl_fp_recoveries++;
   for(i = BLACKLIST_SIZE - 1; i > 0; --i) {
     blacklisted_seqnos[i] = blacklisted_seqnos[i - 1];
   }
@@ -364,10 +554,116 @@ orpl_acked_down_contains(uint32_t seqno, const rimeaddr_t *child)
 static void
 request_routing_set_broadcast()
 {
+  clock_time_t spread = 32 * CLOCK_SECOND;
+#if WITH_ORPL_BOOTSTRAP
+  if(bootstrap_active) {
+    spread = ORPL_BOOTSTRAP_PERIOD;
+  }
+#endif /* WITH_ORPL_BOOTSTRAP */
   ORPL_LOG("ORPL: requesting routing set broadcast\n");
-  ctimer_set(&routing_set_broadcast_timer, random_rand() % (32 * CLOCK_SECOND), broadcast_routing_set, NULL);
+  ctimer_set(&routing_set_broadcast_timer, random_rand() % spread, broadcast_routing_set, NULL);
 }
 
+/* Schedule a routing set broadcast, after a change of the content
+ * of our routing set from outside this module */
+void
+orpl_request_routing_set_broadcast()
+{
+  if(orpl_are_routing_set_active()) {
+    request_routing_set_broadcast();
+  }
+}
+
+#if WITH_ORPL_BOOTSTRAP
+/* Returns 1 during the bootstrap phase */
+int
+orpl_is_bootstrapping()
+{
+  return bootstrap_active;
+}
+
+/* Seed the link estimate of a new neighbor from the RSSI and LQI
+ * of the frame in packetbuf */
+void
+orpl_bootstrap_link_prior(rpl_parent_t *p)
+{
+  int16_t rssi = (int8_t)packetbuf_attr(PACKETBUF_ATTR_RSSI) + BOOTSTRAP_RSSI_OFFSET;
+  uint16_t lqi = packetbuf_attr(PACKETBUF_ATTR_LINK_QUALITY);
+  uint16_t prr;
+  uint8_t bits;
+
+  if(!bootstrap_active || p->bc_samples != 0 || lqi == 0) {
+    /* Not bootstrapping, already estimated, or no link quality info */
+    return;
+  }
+
+  if(rssi < BOOTSTRAP_RSSI_MIN || lqi <= BOOTSTRAP_LQI_LOW) {
+    prr = 0;
+  } else if(lqi >= BOOTSTRAP_LQI_HIGH) {
+    prr = 100;
+  } else {
+    prr = 100 * (lqi - BOOTSTRAP_LQI_LOW) / (BOOTSTRAP_LQI_HIGH - BOOTSTRAP_LQI_LOW);
+  }
+
+  /* The prior counts as a few virtual broadcasts, pushed out of the
+   * window by real ones */
+  bits = (prr * BOOTSTRAP_PRIOR_SAMPLES + 50) / 100;
+  p->bc_history = (1 << bits) - 1;
+  p->bc_samples = BOOTSTRAP_PRIOR_SAMPLES;
+
+  ORPL_LOG("ORPL: link prior rssi %d lqi %u -> prr %u\n", rssi, lqi, prr);
+}
+
+/* A bootstrap round: keep beacons and routing sets at a high rate,
+ * until our EDC is stable */
+static void
+bootstrap_round(void *ptr)
+{
+  rpl_rank_t edc = orpl_current_edc();
+  clock_time_t uptime = orpl_uptime();
+
+  if(edc != 0xffff && bootstrap_last_edc != 0xffff
+      && (edc > bootstrap_last_edc ? edc - bootstrap_last_edc : bootstrap_last_edc - edc) <= BOOTSTRAP_EDC_STABLE) {
+    bootstrap_stable_rounds++;
+  } else {
+    bootstrap_stable_rounds = 0;
+  }
+  bootstrap_last_edc = edc;
+
+  if((uptime >= ORPL_BOOTSTRAP_MIN_TIME && bootstrap_stable_rounds >= BOOTSTRAP_STABLE_ROUNDS)
+      || uptime >= ORPL_BOOTSTRAP_MAX_TIME) {
+    bootstrap_active = 0;
+    /* Avoid 0, which means "not ended" */
+    bootstrap_end_time = uptime > 0 ? uptime : 1;
+    ORPL_LOG("ORPL: bootstrap done after %lu s (edc %u)\n", (unsigned long)uptime, edc);
+    return;
+  }
+
+  /* Keep DIOs at the minimum trickle interval */
+  if(curr_instance) {
+    rpl_reset_dio_timer(curr_instance);
+  }
+  /* Broadcast our routing set as soon as it is in use */
+  if(orpl_are_routing_set_active()) {
+    request_routing_set_broadcast();
+  }
+
+  ctimer_reset(&bootstrap_timer);
+}
+
+/* Start the bootstrap phase */
+static void
+bootstrap_start()
+{
+  ORPL_LOG("ORPL: starting bootstrap\n");
+  bootstrap_active = 1;
+  bootstrap_end_time = 0;
+  bootstrap_last_edc = 0xffff;
+  bootstrap_stable_rounds = 0;
+  ctimer_set(&bootstrap_timer, ORPL_BOOTSTRAP_PERIOD, bootstrap_round, NULL);
+}
+#endif /* WITH_ORPL_BOOTSTRAP */
+
 /* Broadcast our routing set to all neighbors */
 static void
 broadcast_routing_set(void *ptr)
@@ -383,7 +679,17 @@ broadcast_routing_set(void *ptr)
     /* Build data structure to be broadcasted */
     last_broadcasted_edc = curr_edc;
     routing_set_broadcast.edc = curr_edc;
+#if WITH_ORPL_MULTI_SINK
+    routing_set_broadcast.sink = orpl_current_sink();
+#endif /* WITH_ORPL_MULTI_SINK */
+#if WITH_ORPL_ENERGY
+    routing_set_broadcast.energy = orpl_energy_remaining();
+#endif /* WITH_ORPL_ENERGY */
     memcpy(&routing_set_broadcast.rs, orpl_routing_set_get_active(), sizeof(struct routing_set_s));
+#if WITH_ORPL_MCAST
+    /* Advertise our groups to our parents */
+    orpl_mcast_add_groups(&routing_set_broadcast.rs);
+#endif /* WITH_ORPL_MCAST */
 
     /* Proceed to UDP transmission */
     sending_routing_set = 1;
@@ -416,6 +722,17 @@ udp_received_routing_set(struct simple_udp_connection *c,
   /* EDC: store edc as neighbor attribute, update metric */
   uint16_t neighbor_edc = data->edc;
   rpl_set_parent_rank((uip_lladdr_t *)packetbuf_addr(PACKETBUF_ADDR_SENDER), neighbor_edc);
+#if WITH_ORPL_ENERGY
+  orpl_energy_set_neighbor((uip_lladdr_t *)packetbuf_addr(PACKETBUF_ADDR_SENDER), data->energy);
+#endif /* WITH_ORPL_ENERGY */
+#if WITH_ORPL_MULTI_SINK
+  {
+    rpl_parent_t *p = rpl_get_parent((uip_lladdr_t *)packetbuf_addr(PACKETBUF_ADDR_SENDER));
+    if(p != NULL) {
+      p->sink = data->sink;
+    }
+  }
+#endif /* WITH_ORPL_MULTI_SINK */
   rpl_recalculate_ranks();
 
   /* Calculate neighbor's global IP address */
@@ -436,6 +753,16 @@ udp_received_routing_set(struct simple_udp_connection *c,
 //      ORPL_LOG("\n");
     }
 
+#if WITH_ORPL_MULTI_SINK
+    /* Routing sets are scoped per sink: only merge children that route
+     * to the same sink as we do, so that a sink only attracts the
+     * downward traffic it can deliver within its own region. Other
+     * destinations are handed over through the fallback interface. */
+    if(data->sink != orpl_current_sink()) {
+      is_reachable_child = 0;
+    }
+#endif /* WITH_ORPL_MULTI_SINK */
+
     if(is_reachable_child) {
       /* The neighbor is a child, merge its routing set in ours */
       orpl_routing_set_merge((const struct routing_set_s *)
@@ -465,9 +792,14 @@ orpl_trickle_callback(rpl_instance_t *instance)
 
   if(orpl_are_routing_set_active()) {
 #if !FREEZE_TOPOLOGY
-    /* Swap routing sets to implement ageing */
-    ORPL_LOG("ORPL: swapping routing sets\n");
-    orpl_routing_set_swap();
+    /* Swap routing sets to implement ageing. The trickle period can be
+     * short, we swap only once the warmup set had time to fill up. */
+    if(orpl_uptime() - last_swap_time >= ORPL_ROUTING_SET_AGEING_PERIOD) {
+      ORPL_LOG("ORPL: swapping routing sets\n");
+      orpl_routing_set_swap();
+      last_swap_time = orpl_uptime();
+      loop_count = 0;
+    }
 #endif /* FREEZE_TOPOLOGY */
 
     /* Request transmission of routing set */
@@ -485,25 +817,43 @@ orpl_broadcast_acked(const rimeaddr_t *receiver)
 {
   rpl_parent_t *p = rpl_get_parent((uip_lladdr_t *)receiver);
   if(p != NULL) {
-    p->bc_ackcount++;
-    if(p->bc_ackcount > orpl_broadcast_count+1) {
-      p->bc_ackcount = orpl_broadcast_count+1;
-    }
+    p->bc_acked = 1;
   }
 }
 
+/* Callback function for every ACK received while strobing an anycast.
+ * Used for passive link estimation: the link is known to work, count
+ * it as an ack to our next broadcast. */
+void
+orpl_strobe_acked(const rimeaddr_t *receiver)
+{
+  orpl_broadcast_acked(receiver);
+}
+
 /* Callback function at the end of a every broadcast
  * Used for beacon counting. */
 void
 orpl_broadcast_done()
 {
-  /* Update global broacast count */
-  orpl_broadcast_count++;
+  rpl_parent_t *p;
+
+  /* Slide the link estimation window of all neighbors */
+  for(p = nbr_table_head(rpl_parents);
+      p != NULL;
+      p = nbr_table_next(rpl_parents, p)) {
+    p->bc_history = (p->bc_history << 1) | p->bc_acked;
+#if ORPL_LINK_WINDOW < 16
+    p->bc_history &= (1 << ORPL_LINK_WINDOW) - 1;
+#endif /* ORPL_LINK_WINDOW < 16 */
+    p->bc_acked = 0;
+    if(p->bc_samples < ORPL_LINK_WINDOW) {
+      p->bc_samples++;
+    }
+  }
 
   /* Loop over all neighbors and insert the reachable ones into
      out routing set */
   if(orpl_are_routing_set_active()) {
-    rpl_parent_t *p;
     for(p = nbr_table_head(rpl_parents);
         p != NULL;
         p = nbr_table_next(rpl_parents, p)) {
@@ -552,6 +902,43 @@ orpl_update_edc(rpl_rank_t edc)
   curr_edc = edc;
 }
 
+#if !FREEZE_TOPOLOGY
+/* Apply EDC hysteresis to a newly calculated EDC */
+rpl_rank_t
+orpl_edc_hysteresis(rpl_rank_t prev_edc, rpl_rank_t edc)
+{
+  if(edc_force_update) {
+    edc_force_update = 0;
+    return edc;
+  }
+  if(prev_edc != 0xffff && edc != 0xffff
+      && (edc > prev_edc ? edc - prev_edc : prev_edc - edc) < ORPL_EDC_HYSTERESIS) {
+    return prev_edc;
+  }
+  return edc;
+}
+
+/* Called when an upwards packet we already received comes back from
+ * another neighbor, with an EDC that shows it went through a loop */
+void
+orpl_loop_detected(uint32_t seqno, const rimeaddr_t *sender)
+{
+  ORPL_LOG("ORPL: loop detected for %lx from %u\n", seqno,
+      ORPL_LOG_NODEID_FROM_RIMEADDR(sender));
+  /* Duplicate forwarders can cause the same symptom once in a while,
+   * only react to repeated loops */
+  if(++loop_count >= ORPL_LOOP_THRESHOLD) {
+    loop_count = 0;
+    /* Some EDCs are stale: update ours right away and advertise it */
+    edc_force_update = 1;
+    orpl_update_edc(orpl_calculate_edc(0));
+    if(curr_instance) {
+      rpl_reset_dio_timer(curr_instance);
+    }
+  }
+}
+#endif /* !FREEZE_TOPOLOGY */
+
 /* ORPL initialization */
 void
 orpl_init(int is_root, int up_only)
@@ -572,6 +959,24 @@ orpl_init(int is_root, int up_only)
   /* Initialize routing set module */
   orpl_anycast_init();
   orpl_routing_set_init();
+#if WITH_ORPL_ENERGY
+  orpl_energy_init();
+#endif /* WITH_ORPL_ENERGY */
+#if WITH_ORPL_SOFTACK_PROF
+  orpl_softack_prof_init();
+#endif /* WITH_ORPL_SOFTACK_PROF */
+#if WITH_ORPL_DTN
+  orpl_dtn_init();
+#endif /* WITH_ORPL_DTN */
+#if WITH_ORPL_PATH_HINT
+  orpl_path_hint_init();
+#endif /* WITH_ORPL_PATH_HINT */
+#if WITH_ORPL_TELEMETRY
+  orpl_telemetry_init();
+#endif /* WITH_ORPL_TELEMETRY */
+#if WITH_ORPL_LB && WITH_ORPL_LB_DIO_TARGET
+  orpl_dc_objective_init(is_root);
+#endif /* WITH_ORPL_LB && WITH_ORPL_LB_DIO_TARGET */
 
   /* Set up multicast UDP connectoin for dissemination of routing sets */
   uip_create_linklocal_allnodes_mcast(&routing_set_addr);
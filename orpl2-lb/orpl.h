@@ -42,12 +42,9 @@
 
 #include "net/rpl/rpl.h"
 
-#if WITH_ORPL_LB
-#if WITH_ORPL_LB_DIO_TARGET
-uint8_t dio_dc_objective;//DC objective carried by DIO
-uint8_t dio_dc_obj_sn;
-#endif
-#endif /*WITH_ORPL_LB*/
+#if WITH_ORPL_LB && WITH_ORPL_LB_DIO_TARGET
+#include "orpl-dc-objective.h"
+#endif /* WITH_ORPL_LB && WITH_ORPL_LB_DIO_TARGET */
 
 #ifdef ORPL_CONF_EDC_W
 #define ORPL_EDC_W ORPL_CONF_EDC_W
@@ -61,6 +58,87 @@ uint8_t dio_dc_obj_sn;
 #define ORPL_WITH_FP_RECOVERY 1
 #endif /* ORPL_CONF_WITH_FP_RECOVERY */
 
+/* When set (the default, for experiments):
+ * - stop updating EDC after a few minutes
+ * - start updating routing sets only after that
+ * - don't age routing sets
+ * When unset, ORPL runs continuously, with EDC hysteresis, periodic
+ * routing set ageing and loop detection. */
+#ifndef FREEZE_TOPOLOGY
+#ifdef ORPL_CONF_FREEZE_TOPOLOGY
+#define FREEZE_TOPOLOGY ORPL_CONF_FREEZE_TOPOLOGY
+#else /* ORPL_CONF_FREEZE_TOPOLOGY */
+#define FREEZE_TOPOLOGY 1
+#endif /* ORPL_CONF_FREEZE_TOPOLOGY */
+#endif /* FREEZE_TOPOLOGY */
+
+/* EDC changes smaller than this are ignored in continuous mode. Must be
+ * below ORPL_EDC_W, so that the progress required at each hop is never
+ * fully eaten up by stale EDCs. */
+#ifdef ORPL_CONF_EDC_HYSTERESIS
+#define ORPL_EDC_HYSTERESIS ORPL_CONF_EDC_HYSTERESIS
+#else /* ORPL_CONF_EDC_HYSTERESIS */
+#define ORPL_EDC_HYSTERESIS (ORPL_EDC_W / 4)
+#endif /* ORPL_CONF_EDC_HYSTERESIS */
+
+#if ORPL_EDC_HYSTERESIS >= ORPL_EDC_W
+#error "ORPL_EDC_HYSTERESIS must be lower than ORPL_EDC_W"
+#endif
+
+/* Minimum time between two routing set swaps in continuous mode, in
+ * seconds. Must leave enough time for all children to broadcast their
+ * routing set at least once, so that the warmup set is complete when
+ * it becomes active. */
+#ifdef ORPL_CONF_ROUTING_SET_AGEING_PERIOD
+#define ORPL_ROUTING_SET_AGEING_PERIOD ORPL_CONF_ROUTING_SET_AGEING_PERIOD
+#else /* ORPL_CONF_ROUTING_SET_AGEING_PERIOD */
+#define ORPL_ROUTING_SET_AGEING_PERIOD (10 * 60)
+#endif /* ORPL_CONF_ROUTING_SET_AGEING_PERIOD */
+
+/* Number of loops detected within an ageing period before we force an
+ * EDC update and advertise it */
+#ifdef ORPL_CONF_LOOP_THRESHOLD
+#define ORPL_LOOP_THRESHOLD ORPL_CONF_LOOP_THRESHOLD
+#else /* ORPL_CONF_LOOP_THRESHOLD */
+#define ORPL_LOOP_THRESHOLD 2
+#endif /* ORPL_CONF_LOOP_THRESHOLD */
+
+/* Bootstrap phase, right after boot or after joining: beacon and
+ * routing set broadcast period, and minimum and maximum duration (s).
+ * The phase ends when our EDC is stable, at the earliest after the
+ * minimum duration. */
+#ifdef ORPL_CONF_BOOTSTRAP_PERIOD
+#define ORPL_BOOTSTRAP_PERIOD ORPL_CONF_BOOTSTRAP_PERIOD
+#else /* ORPL_CONF_BOOTSTRAP_PERIOD */
+#define ORPL_BOOTSTRAP_PERIOD (8 * CLOCK_SECOND)
+#endif /* ORPL_CONF_BOOTSTRAP_PERIOD */
+
+#ifdef ORPL_CONF_BOOTSTRAP_MIN_TIME
+#define ORPL_BOOTSTRAP_MIN_TIME ORPL_CONF_BOOTSTRAP_MIN_TIME
+#else /* ORPL_CONF_BOOTSTRAP_MIN_TIME */
+#define ORPL_BOOTSTRAP_MIN_TIME 60
+#endif /* ORPL_CONF_BOOTSTRAP_MIN_TIME */
+
+#ifdef ORPL_CONF_BOOTSTRAP_MAX_TIME
+#define ORPL_BOOTSTRAP_MAX_TIME ORPL_CONF_BOOTSTRAP_MAX_TIME
+#else /* ORPL_CONF_BOOTSTRAP_MAX_TIME */
+#define ORPL_BOOTSTRAP_MAX_TIME (4 * 60)
+#endif /* ORPL_CONF_BOOTSTRAP_MAX_TIME */
+
+/* PRR threshold for considering a neighbor as usable */
+#define NEIGHBOR_PRR_THRESHOLD 30
+
+/* Interface identifier of the virtual sink address, shared by all
+ * roots of a multi-sink deployment (last 16 bits, the rest is zero) */
+#ifdef ORPL_CONF_SINK_IID
+#define ORPL_SINK_IID ORPL_CONF_SINK_IID
+#else /* ORPL_CONF_SINK_IID */
+#define ORPL_SINK_IID 0x0001
+#endif /* ORPL_CONF_SINK_IID */
+
+/* Sink id of a neighbor that has not advertised its sink yet */
+#define ORPL_SINK_NONE 0
+
 /* Default implementation for logging functions */
 #ifndef ORPL_LOG
 #define ORPL_LOG(...) PRINTF(__VA_ARGS__)
@@ -95,6 +173,16 @@ uint8_t dio_dc_obj_sn;
 #ifndef ORPL_LOG_INC_FPCOUNT_FROM_PACKETBUF
 #define ORPL_LOG_INC_FPCOUNT_FROM_PACKETBUF()
 #endif /* ORPL_LOG_INC_FPCOUNT_FROM_PACKETBUF */
+#ifndef ORPL_LOG_ADD_DELAY_FROM_PACKETBUF
+#define ORPL_LOG_ADD_DELAY_FROM_PACKETBUF(queue, strobe)
+#endif /* ORPL_LOG_ADD_DELAY_FROM_PACKETBUF */
+
+/* Size of the window used for link estimation, in broadcasts (max 16) */
+#ifdef ORPL_CONF_LINK_WINDOW
+#define ORPL_LINK_WINDOW ORPL_CONF_LINK_WINDOW
+#else /* ORPL_CONF_LINK_WINDOW */
+#define ORPL_LINK_WINDOW 16
+#endif /* ORPL_CONF_LINK_WINDOW */
 
 /* Fixed point divisor */
 #define EDC_DIVISOR 128
@@ -109,29 +197,66 @@ extern uip_ipaddr_t global_ipv6;
  * after each transmission attempt */
 extern int sending_routing_set;
 
-/* Total number of broadcast sent */
-extern uint32_t orpl_broadcast_count;
+/* Number of false positive recoveries triggered by this node */
+extern uint16_t orpl_fp_recoveries;
 
 /* Set the 32-bit ORPL sequence number in packetbuf */
 void orpl_packetbuf_set_seqno(uint32_t seqno);
 /* Get the 32-bit ORPL sequence number from packetbuf */
 uint32_t orpl_packetbuf_seqno();
+#if WITH_ORPL_FRAG
+/* Get the offset of the anycast fragment in packetbuf */
+uint8_t orpl_packetbuf_frag_offset();
+#endif /* WITH_ORPL_FRAG */
 /* Set the current ORPL sequence number before sending */
 void orpl_set_curr_seqno(uint32_t seqno);
 /* Get the current ORPL sequence number */
 uint32_t orpl_get_curr_seqno();
 /* Get a new ORPL sequence number */
 uint32_t orpl_get_new_seqno();
+#if WITH_ORPL_TRAFFIC_CLASS
+/* Traffic classes. Urgent packets (e.g. alarms) bypass the regular
+ * ones in CSMA queues and are acked without waiting for ACK slots. */
+#define ORPL_CLASS_NORMAL 0
+#define ORPL_CLASS_URGENT 1
+#define ORPL_CLASS_COUNT  2
+/* Set the traffic class of the next packet we send, as for the seqno */
+void orpl_set_curr_class(uint8_t traffic_class);
+/* Get the current traffic class, and reset it */
+uint8_t orpl_get_curr_class();
+#endif /* WITH_ORPL_TRAFFIC_CLASS */
 /* Build a global link-layer address from an IPv6 based on its UUID64 */
 void lladdr_from_ipaddr_uuid(uip_lladdr_t *lladdr, const uip_ipaddr_t *ipaddr);
 /* Returns 1 if EDC is frozen, i.e. we are not allowed to change edc */
 int orpl_is_edc_frozen();
 /* Returns 1 routing sets are active, i.e. we can start inserting and merging */
 int orpl_are_routing_set_active();
+/* Schedule a routing set broadcast after our routing set changed */
+void orpl_request_routing_set_broadcast();
 /* Returns 1 if the node is root of ORPL */
 int orpl_is_root();
+#if WITH_ORPL_MULTI_SINK
+/* Set the IID of an IPv6 address to that of the virtual sink */
+void orpl_set_sink_iid(uip_ipaddr_t *ipaddr);
+/* Build the global virtual sink address, shared by all roots */
+void orpl_sink_ipaddr(uip_ipaddr_t *ipaddr);
+/* Returns 1 if ipaddr is the virtual sink address */
+int orpl_is_sink_ipaddr(const uip_ipaddr_t *ipaddr);
+/* Returns the id of the sink we are currently routing to */
+uint16_t orpl_current_sink();
+#endif /* WITH_ORPL_MULTI_SINK */
 /* Returns current EDC of the node */
 rpl_rank_t orpl_current_edc();
+/* Returns the number of broadcasts acked by a neighbor over the last
+ * ORPL_LINK_WINDOW ones, scaled to the window if we have fewer samples */
+uint16_t orpl_link_ackcount(const rpl_parent_t *p);
+#if WITH_ORPL_BOOTSTRAP
+/* Seed the link estimate of a new neighbor from the RSSI and LQI
+ * of the frame in packetbuf */
+void orpl_bootstrap_link_prior(rpl_parent_t *p);
+/* Returns 1 during the bootstrap phase */
+int orpl_is_bootstrapping();
+#endif /* WITH_ORPL_BOOTSTRAP */
 /* Returns 1 if addr is the global ip of a reachable neighbor */
 int orpl_is_reachable_neighbor(const uip_ipaddr_t *ipaddr);
 /* Insert a packet sequence number to the blacklist
@@ -151,6 +276,9 @@ void orpl_trickle_callback(rpl_instance_t *instance);
 /* Callback function for every ACK received while broadcasting.
  * Used for beacon counting. */
 void orpl_broadcast_acked(const rimeaddr_t *receiver);
+/* Callback function for every ACK received while strobing an anycast.
+ * Used for passive link estimation. */
+void orpl_strobe_acked(const rimeaddr_t *receiver);
 /* Callback function at the end of a every broadcast
  * Used for beacon counting. */
 void orpl_broadcast_done();
@@ -160,5 +288,12 @@ void orpl_update_edc(rpl_rank_t edc);
 void orpl_init(int is_root, int up_only);
 /* Function that computes the metric EDC */
 rpl_rank_t orpl_calculate_edc(int verbose);
+#if !FREEZE_TOPOLOGY
+/* Apply EDC hysteresis to a newly calculated EDC */
+rpl_rank_t orpl_edc_hysteresis(rpl_rank_t prev_edc, rpl_rank_t edc);
+/* Called when an upwards packet we already received comes back from
+ * another neighbor, i.e. it went through a loop */
+void orpl_loop_detected(uint32_t seqno, const rimeaddr_t *sender);
+#endif /* !FREEZE_TOPOLOGY */
 
 #endif /* __ORPL_H__ */